@@ -0,0 +1,219 @@
+#include "ast.h"
+
+ExpressionPtr Expression::makeLiteral(const Value& value) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = ExpressionType::LITERAL;
+    expression->value = value;
+    return expression;
+}
+
+ExpressionPtr Expression::makeColumn(const std::string& table, const std::string& name) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = ExpressionType::COLUMN;
+    expression->table = table;
+    expression->name = name;
+    return expression;
+}
+
+ExpressionPtr Expression::makeComparison(const std::string& op, ExpressionPtr left, ExpressionPtr right) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = ExpressionType::COMPARISON;
+    expression->op = op;
+    expression->children.push_back(std::move(left));
+    expression->children.push_back(std::move(right));
+    return expression;
+}
+
+ExpressionPtr Expression::makeLogical(ExpressionType type, ExpressionPtr left, ExpressionPtr right) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = type;
+    expression->children.push_back(std::move(left));
+    expression->children.push_back(std::move(right));
+    return expression;
+}
+
+ExpressionPtr Expression::makeNot(ExpressionPtr child) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = ExpressionType::NOT;
+    expression->children.push_back(std::move(child));
+    return expression;
+}
+
+ExpressionPtr Expression::makeAggregate(const std::string& function, ExpressionPtr argument) {
+    auto expression = std::make_unique<Expression>();
+    expression->type = ExpressionType::AGGREGATE;
+    expression->name = function;
+    if (argument) {
+        expression->children.push_back(std::move(argument));
+    }
+    return expression;
+}
+
+ExpressionPtr Expression::clone() const {
+    auto copy = std::make_unique<Expression>();
+    copy->type = type;
+    copy->value = value;
+    copy->table = table;
+    copy->name = name;
+    copy->op = op;
+    copy->column_index = column_index;
+    for (const auto& child : children) {
+        copy->children.push_back(child->clone());
+    }
+    return copy;
+}
+
+std::string Expression::toString() const {
+    switch (type) {
+    case ExpressionType::LITERAL: {
+        if (!value.isString()) {
+            return value.toString();
+        }
+        std::string quoted = "'";
+        for (char c : value.asString()) {
+            quoted += c;
+            if (c == '\'') quoted += c;
+        }
+        return quoted + "'";
+    }
+    case ExpressionType::COLUMN:
+        return table.empty() ? name : table + "." + name;
+    case ExpressionType::COMPARISON:
+        return children[0]->toString() + " " + op + " " + children[1]->toString();
+    case ExpressionType::AND:
+    case ExpressionType::OR: {
+        std::string text;
+        for (size_t i = 0; i < children.size(); i++) {
+            if (i > 0) text += type == ExpressionType::AND ? " AND " : " OR ";
+            bool wrap = type == ExpressionType::AND && children[i]->type == ExpressionType::OR;
+            text += wrap ? "(" + children[i]->toString() + ")" : children[i]->toString();
+        }
+        return text;
+    }
+    case ExpressionType::NOT: {
+        const Expression& child = *children[0];
+        bool wrap = child.type == ExpressionType::AND || child.type == ExpressionType::OR;
+        return "NOT " + (wrap ? "(" + child.toString() + ")" : child.toString());
+    }
+    case ExpressionType::AGGREGATE:
+        return name + "(" + (children.empty() ? "*" : children[0]->toString()) + ")";
+    case ExpressionType::STAR:
+        return "*";
+    }
+    return "";
+}
+
+bool Expression::containsAggregate() const {
+    if (type == ExpressionType::AGGREGATE) {
+        return true;
+    }
+    for (const auto& child : children) {
+        if (child->containsAggregate()) return true;
+    }
+    return false;
+}
+
+void Expression::collectAggregates(std::vector<Expression*>& aggregates) {
+    if (type == ExpressionType::AGGREGATE) {
+        std::string text = toString();
+        for (const Expression* existing : aggregates) {
+            if (existing->toString() == text) return;
+        }
+        aggregates.push_back(this);
+        return;
+    }
+    for (auto& child : children) {
+        child->collectAggregates(aggregates);
+    }
+}
+
+bool Expression::bind(const Schema& schema, std::string& error) {
+    column_index = -1;
+
+    if (type == ExpressionType::COLUMN) {
+        for (size_t i = 0; i < schema.size(); i++) {
+            const SchemaColumn& column = schema[i];
+            bool matches = (column.name == name && (table.empty() || column.table == table)) ||
+                           (table.empty() && !column.alias.empty() && column.alias == name);
+            if (!matches || column_index == static_cast<int>(i)) {
+                continue;
+            }
+            if (column_index != -1) {
+                error = "Ambiguous column: " + toString();
+                return false;
+            }
+            column_index = static_cast<int>(i);
+        }
+        if (column_index == -1) {
+            error = "Column not found: " + toString();
+            return false;
+        }
+        return true;
+    }
+
+    if (type != ExpressionType::LITERAL) {
+        // e.g. COUNT(*) in HAVING refers to the aggregate's output column
+        std::string text = toString();
+        for (size_t i = 0; i < schema.size(); i++) {
+            if (schema[i].name == text || (!schema[i].alias.empty() && schema[i].alias == text)) {
+                column_index = static_cast<int>(i);
+                return true;
+            }
+        }
+    }
+
+    switch (type) {
+    case ExpressionType::AGGREGATE:
+        error = "Aggregate not allowed here: " + toString();
+        return false;
+    case ExpressionType::STAR:
+        error = "* is only allowed as a select item";
+        return false;
+    default:
+        for (auto& child : children) {
+            if (!child->bind(schema, error)) return false;
+        }
+        return true;
+    }
+}
+
+Value Expression::evaluate(const Record& row) const {
+    if (column_index >= 0) {
+        return column_index < static_cast<int>(row.values.size()) ? row.values[column_index] : Value();
+    }
+    switch (type) {
+    case ExpressionType::LITERAL:
+        return value;
+    case ExpressionType::COMPARISON:
+    case ExpressionType::AND:
+    case ExpressionType::OR:
+    case ExpressionType::NOT:
+        return Value(static_cast<int32_t>(isTrue(row)));
+    default:
+        return Value();
+    }
+}
+
+bool Expression::isTrue(const Record& row) const {
+    if (column_index < 0) {
+        switch (type) {
+        case ExpressionType::COMPARISON: {
+            Value left = children[0]->evaluate(row);
+            Value right = children[1]->evaluate(row);
+            return !left.isNull() && !right.isNull() && left.compare(op, right);
+        }
+        case ExpressionType::AND:
+            return children[0]->isTrue(row) && children[1]->isTrue(row);
+        case ExpressionType::OR:
+            return children[0]->isTrue(row) || children[1]->isTrue(row);
+        case ExpressionType::NOT:
+            return !children[0]->isTrue(row);
+        default:
+            break;
+        }
+    }
+
+    Value result = evaluate(row);
+    if (result.isNull()) return false;
+    return result.isNumeric() ? result.asDouble() != 0 : !result.asString().empty();
+}
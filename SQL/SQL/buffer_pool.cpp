@@ -0,0 +1,268 @@
+#include "buffer_pool.h"
+#include <filesystem>
+#include <iostream>
+
+BufferPool::BufferPool(size_t num_frames)
+    : frames(num_frames == 0 ? 1 : num_frames), log_manager(nullptr), clock_hand(0), hits(0), misses(0) {
+}
+
+BufferPool::~BufferPool() {
+    flushAll();
+}
+
+std::string BufferPool::normalize(const std::string& filename) {
+    return std::filesystem::path(filename).lexically_normal().string();
+}
+
+std::string BufferPool::frameKey(const std::string& filename, int page_id) {
+    return filename + "#" + std::to_string(page_id);
+}
+
+Page* BufferPool::fetchPage(const std::string& filename, int page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+    return pinFrame(normalize(filename), page_id, true);
+}
+
+Page* BufferPool::newPage(const std::string& filename, int page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+    return pinFrame(normalize(filename), page_id, false);
+}
+
+bool BufferPool::unpinPage(const std::string& filename, int page_id, bool is_dirty) {
+    std::lock_guard<std::mutex> lock(latch);
+    auto it = page_table.find(frameKey(normalize(filename), page_id));
+    if (it == page_table.end()) {
+        return false;
+    }
+
+    Frame& frame = frames[it->second];
+    if (frame.pin_count <= 0) {
+        return false;
+    }
+    frame.pin_count--;
+    frame.is_dirty = frame.is_dirty || is_dirty;
+    return true;
+}
+
+Page* BufferPool::pinFrame(const std::string& filename, int page_id, bool read_from_disk) {
+    if (page_id < 0) {
+        return nullptr;
+    }
+
+    std::string key = frameKey(filename, page_id);
+    auto it = page_table.find(key);
+    if (it != page_table.end()) {
+        Frame& frame = frames[it->second];
+        if (frame.pin_count == 0 && !frame.is_dirty) {
+            frame.rec_lsn = currentLSN();
+        }
+        frame.pin_count++;
+        frame.referenced = true;
+        hits++;
+        return &frame.page;
+    }
+
+    misses++;
+
+    std::fstream* file = getFile(filename);
+    if (!file) {
+        return nullptr;
+    }
+
+    if (read_from_disk) {
+        // Pages past the end of the file do not exist yet
+        file->clear();
+        file->seekg(0, std::ios::end);
+        std::streamoff file_size = file->tellg();
+        if (static_cast<std::streamoff>((page_id + 1) * PAGE_SIZE_BYTES) > file_size) {
+            return nullptr;
+        }
+    }
+
+    int victim = findVictim();
+    if (victim == -1) {
+        std::cerr << "Buffer pool exhausted: all " << frames.size() << " frames are pinned" << std::endl;
+        return nullptr;
+    }
+
+    Frame& frame = frames[victim];
+    if (frame.page_id != -1) {
+        if (frame.is_dirty && !writeFrame(frame)) {
+            return nullptr;
+        }
+        page_table.erase(frameKey(frame.filename, frame.page_id));
+    }
+
+    frame.page.clear();
+    if (read_from_disk) {
+        file->clear();
+        file->seekg(page_id * PAGE_SIZE_BYTES);
+        file->read(frame.page.getData(), PAGE_SIZE_BYTES);
+        if (!file->good()) {
+            std::cerr << "Error reading page " << page_id << " from " << filename << std::endl;
+            frame.page_id = -1;
+            frame.filename.clear();
+            return nullptr;
+        }
+    }
+
+    frame.filename = filename;
+    frame.page_id = page_id;
+    frame.pin_count = 1;
+    frame.is_dirty = false;
+    frame.referenced = true;
+    frame.rec_lsn = currentLSN();
+    page_table[key] = victim;
+    return &frame.page;
+}
+
+// Any change made while the page is pinned is logged at or after this LSN,
+// so it is a safe recLSN for a frame that becomes dirty
+lsn_t BufferPool::currentLSN() const {
+    return log_manager ? log_manager->getNextLSN() : INVALID_LSN;
+}
+
+// CLOCK: sweep the frames, giving referenced pages a second chance
+int BufferPool::findVictim() {
+    for (size_t step = 0; step < 2 * frames.size(); step++) {
+        size_t index = clock_hand;
+        clock_hand = (clock_hand + 1) % frames.size();
+
+        Frame& frame = frames[index];
+        if (frame.page_id == -1) {
+            return index;
+        }
+        if (frame.pin_count > 0) {
+            continue;
+        }
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        return index;
+    }
+    return -1;
+}
+
+bool BufferPool::writeFrame(Frame& frame) {
+    // Changes described by the log must reach disk before the page does
+    if (log_manager && !log_manager->flush(frame.page.getLSN())) {
+        std::cerr << "Failed to force log before writing page " << frame.page_id
+                  << " of " << frame.filename << std::endl;
+        return false;
+    }
+
+    std::fstream* file = getFile(frame.filename);
+    if (!file) {
+        std::cerr << "Failed to open file for writing: " << frame.filename << std::endl;
+        return false;
+    }
+
+    file->clear();
+    file->seekp(frame.page_id * PAGE_SIZE_BYTES);
+    file->write(frame.page.getData(), PAGE_SIZE_BYTES);
+    file->flush();
+    if (!file->good()) {
+        std::cerr << "Error writing to file: " << frame.filename << std::endl;
+        return false;
+    }
+
+    frame.is_dirty = false;
+    return true;
+}
+
+bool BufferPool::flushPage(const std::string& filename, int page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+    auto it = page_table.find(frameKey(normalize(filename), page_id));
+    if (it == page_table.end()) {
+        return true;
+    }
+    Frame& frame = frames[it->second];
+    return !frame.is_dirty || writeFrame(frame);
+}
+
+bool BufferPool::flushFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(latch);
+    std::string name = normalize(filename);
+    bool success = true;
+    for (auto& frame : frames) {
+        if (frame.page_id != -1 && frame.is_dirty && frame.filename == name) {
+            success = writeFrame(frame) && success;
+        }
+    }
+    return success;
+}
+
+bool BufferPool::flushAll() {
+    std::lock_guard<std::mutex> lock(latch);
+    bool success = true;
+    for (auto& frame : frames) {
+        if (frame.page_id != -1 && frame.is_dirty) {
+            success = writeFrame(frame) && success;
+        }
+    }
+    return success;
+}
+
+bool BufferPool::flushPagesOlderThan(lsn_t lsn) {
+    std::lock_guard<std::mutex> lock(latch);
+    bool success = true;
+    for (auto& frame : frames) {
+        if (frame.page_id != -1 && frame.is_dirty && frame.rec_lsn < lsn) {
+            success = writeFrame(frame) && success;
+        }
+    }
+    return success;
+}
+
+std::vector<DirtyPageEntry> BufferPool::getDirtyPages() {
+    std::lock_guard<std::mutex> lock(latch);
+    std::vector<DirtyPageEntry> dirty_pages;
+    for (const auto& frame : frames) {
+        if (frame.page_id != -1 && frame.is_dirty) {
+            dirty_pages.push_back({frame.filename, frame.page_id, frame.rec_lsn});
+        }
+    }
+    return dirty_pages;
+}
+
+void BufferPool::discardFile(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(latch);
+    std::string name = normalize(filename);
+    for (auto& frame : frames) {
+        if (frame.page_id != -1 && frame.filename == name) {
+            page_table.erase(frameKey(frame.filename, frame.page_id));
+            frame = Frame();
+        }
+    }
+    closeFile(name);
+}
+
+void BufferPool::discardAll() {
+    std::lock_guard<std::mutex> lock(latch);
+    for (auto& frame : frames) {
+        frame = Frame();
+    }
+    page_table.clear();
+    open_files.clear();
+}
+
+std::fstream* BufferPool::getFile(const std::string& filename) {
+    auto it = open_files.find(filename);
+    if (it != open_files.end()) {
+        return it->second.get();
+    }
+
+    auto file = std::make_unique<std::fstream>(filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!*file) {
+        return nullptr;
+    }
+
+    std::fstream* handle = file.get();
+    open_files[filename] = std::move(file);
+    return handle;
+}
+
+void BufferPool::closeFile(const std::string& filename) {
+    open_files.erase(filename);
+}
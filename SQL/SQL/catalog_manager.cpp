@@ -6,6 +6,28 @@
 #include <algorithm>
 #include <filesystem>
 
+// Version 2 added table statistics after each table's columns, version 3
+// the table's indexes after its statistics and version 4 the index kind
+const int CATALOG_VERSION = 4;
+
+namespace {
+    IndexInfo makeIndex(const std::string& table_name, const std::vector<std::string>& columns, bool unique) {
+        IndexInfo index;
+        index.name = indexFileName(table_name, columns);
+        index.columns = columns;
+        index.unique = unique;
+        return index;
+    }
+}
+
+std::string indexFileName(const std::string& table_name, const std::vector<std::string>& columns, bool hash) {
+    std::string name = table_name;
+    for (const auto& column : columns) {
+        name += "_" + column;
+    }
+    return name + (hash ? ".hash.idx" : ".idx");
+}
+
 CatalogManager::CatalogManager(const std::string& db_name) 
     : db_name(db_name), 
       catalog_file("./data/" + db_name + "/catalog.dat") {
@@ -27,6 +49,11 @@ bool CatalogManager::createTable(const std::string& table_name,
     table_info.name = table_name;
     table_info.columns = columns;
     table_info.data_file = "./data/" + db_name + "/" + table_name + ".dat";
+    for (const auto& col : columns) {
+        if (col.is_primary_key) {
+            table_info.indexes.push_back(makeIndex(table_name, {col.name}, true));
+        }
+    }
     
     tables[table_name] = table_info;
     saveCatalog();
@@ -43,12 +70,17 @@ bool CatalogManager::dropTable(const std::string& table_name) {
     return false;
 }
 
-bool CatalogManager::addIndex(const std::string& table_name,
-                            const std::string& column_name) {
+bool CatalogManager::addIndex(const std::string& table_name, const IndexInfo& index) {
     auto it = tables.find(table_name);
     if (it != tables.end()) {
-        std::string index_file = table_name + "_" + column_name + ".idx";
-        it->second.index_files.push_back(index_file);
+        auto& indexes = it->second.indexes;
+        for (const auto& existing : indexes) {
+            if (existing.columns == index.columns && existing.hash == index.hash) {
+                return false;
+            }
+        }
+        indexes.push_back(index);
+        indexes.back().name = indexFileName(table_name, index.columns, index.hash);
         saveCatalog();
         return true;
     }
@@ -75,8 +107,16 @@ bool CatalogManager::loadCatalog() {
         tables.clear();
         std::string line;
 
-        // Read number of tables
+        // Catalogs written before statistics existed start with the table
+        // count instead of a version line
+        int version = 1;
         std::getline(file, line);
+        if (line.rfind("VERSION ", 0) == 0) {
+            version = std::stoi(line.substr(8));
+            std::getline(file, line);
+        }
+
+        // Read number of tables
         int num_tables = std::stoi(line);
         std::cout << "Expected number of tables: " << num_tables << std::endl;
 
@@ -115,19 +155,28 @@ bool CatalogManager::loadCatalog() {
                          << ", FK: " << col.is_foreign_key << ")" << std::endl;
             }
 
-            // Set the data file path
-            table.data_file = "./data/" + db_name + "/" + table_name + ".dat";
-            
-            // Add any index files
-            if (table.columns.size() > 0) {
+            if (version >= 2 && !loadTableStats(file, table)) {
+                std::cerr << "Invalid statistics for table: " << table_name << std::endl;
+                table.stats = TableStats();
+            }
+
+            // Older catalogs only had the primary key indexes
+            if (version >= 3) {
+                if (!loadIndexes(file, table, version)) {
+                    std::cerr << "Invalid index list for table: " << table_name << std::endl;
+                    return false;
+                }
+            } else {
                 for (const auto& col : table.columns) {
-                    if (col.is_primary_key || col.is_foreign_key) {
-                        std::string index_file = table_name + "_" + col.name + ".idx";
-                        table.index_files.push_back(index_file);
+                    if (col.is_primary_key) {
+                        table.indexes.push_back(makeIndex(table_name, {col.name}, true));
                     }
                 }
             }
 
+            // Set the data file path
+            table.data_file = "./data/" + db_name + "/" + table_name + ".dat";
+
             tables[table_name] = table;
         }
 
@@ -146,13 +195,17 @@ bool CatalogManager::saveCatalog() const {
         // Create the directory if it doesn't exist
         std::filesystem::create_directories(std::filesystem::path(catalog_file).parent_path());
         
-        std::ofstream file(catalog_file);
+        // Write a new copy and rename it over the old one, so a crash while
+        // saving leaves the previous catalog intact
+        std::string tmp_file = catalog_file + ".tmp";
+        std::ofstream file(tmp_file, std::ios::trunc);
         if (!file) {
             std::cerr << "Failed to open catalog file for writing" << std::endl;
             return false;
         }
 
-        // Write number of tables first
+        // Write format version and number of tables first
+        file << "VERSION " << CATALOG_VERSION << "\n";
         file << tables.size() << "\n";
 
         for (const auto& [table_name, table] : tables) {
@@ -175,8 +228,17 @@ bool CatalogManager::saveCatalog() const {
                          << col.references_column << "\n";
                 }
             }
+            saveTableStats(file, table.stats);
+            saveIndexes(file, table);
         }
         
+        file.close();
+        if (!file) {
+            std::cerr << "Failed to write catalog file" << std::endl;
+            return false;
+        }
+        std::filesystem::rename(tmp_file, catalog_file);
+
         std::cout << "Successfully saved catalog with " << tables.size() << " tables" << std::endl;
         return true;
     } catch (const std::exception& e) {
@@ -186,14 +248,16 @@ bool CatalogManager::saveCatalog() const {
 }
 
 bool CatalogManager::removeIndex(const std::string& table_name, 
-                               const std::string& column_name) {
+                               const std::vector<std::string>& columns,
+                               bool hash) {
     auto it = tables.find(table_name);
     if (it != tables.end()) {
-        std::string index_file = table_name + "_" + column_name + ".idx";
-        auto& index_files = it->second.index_files;
-        auto index_it = std::find(index_files.begin(), index_files.end(), index_file);
-        if (index_it != index_files.end()) {
-            index_files.erase(index_it);
+        auto& indexes = it->second.indexes;
+        auto index_it = std::find_if(indexes.begin(), indexes.end(), [&](const IndexInfo& index) {
+            return index.columns == columns && index.hash == hash;
+        });
+        if (index_it != indexes.end()) {
+            indexes.erase(index_it);
             saveCatalog();
             return true;
         }
@@ -231,4 +295,149 @@ std::string CatalogManager::getColumnName(const std::string& table_name, int col
         return it->second.columns[column_index].name;
     }
     return "";
-}
\ No newline at end of file
+}
+
+std::string CatalogManager::getIndexPath(const IndexInfo& index) const {
+    return "./data/" + db_name + "/" + index.name;
+}
+
+bool CatalogManager::setTableStats(const std::string& table_name, const TableStats& stats) {
+    auto it = tables.find(table_name);
+    if (it == tables.end()) {
+        return false;
+    }
+    it->second.stats = stats;
+    return saveCatalog();
+}
+
+// STATS 0 for a table that was never analyzed, otherwise STATS 1, the row
+// and page counts, and per column "distinct nulls buckets ordered", min,
+// max and the histogram bounds, one value per line. Catalogs written
+// before ordered was kept leave it at 0.
+void CatalogManager::saveTableStats(std::ostream& file, const TableStats& stats) const {
+    if (!stats.analyzed) {
+        file << "STATS 0\n";
+        return;
+    }
+    file << "STATS 1\n"
+         << stats.row_count << "\n"
+         << stats.page_count << "\n";
+    for (const auto& col : stats.columns) {
+        file << col.distinct_count << " " << col.null_count << " " << col.histogram.size() << " " << col.ordered
+             << "\n"
+             << encodeStatsValue(col.min) << "\n"
+             << encodeStatsValue(col.max) << "\n";
+        for (const auto& bound : col.histogram) {
+            file << encodeStatsValue(bound) << "\n";
+        }
+    }
+}
+
+bool CatalogManager::loadTableStats(std::istream& file, TableInfo& table) {
+    std::string line;
+    std::getline(file, line);
+    if (line == "STATS 0") {
+        return true;
+    }
+    if (line != "STATS 1") {
+        return false;
+    }
+
+    TableStats& stats = table.stats;
+    stats.analyzed = true;
+    std::getline(file, line); stats.row_count = std::stoll(line);
+    std::getline(file, line); stats.page_count = std::stoll(line);
+    for (size_t c = 0; c < table.columns.size(); c++) {
+        ColumnStats col;
+        size_t buckets;
+        std::getline(file, line);
+        std::istringstream counts(line);
+        if (!(counts >> col.distinct_count >> col.null_count >> buckets)) {
+            return false;
+        }
+        if (!(counts >> col.ordered)) {
+            col.ordered = 0;
+        }
+        std::getline(file, line);
+        if (!decodeStatsValue(line, col.min)) return false;
+        std::getline(file, line);
+        if (!decodeStatsValue(line, col.max)) return false;
+        for (size_t b = 0; b < buckets; b++) {
+            Value bound;
+            std::getline(file, line);
+            if (!decodeStatsValue(line, bound)) return false;
+            col.histogram.push_back(bound);
+        }
+        stats.columns.push_back(col);
+    }
+    return true;
+}
+
+namespace {
+    std::string joinColumns(const std::vector<std::string>& columns) {
+        std::string text;
+        for (size_t i = 0; i < columns.size(); i++) {
+            text += (i > 0 ? "," : "") + columns[i];
+        }
+        return text;
+    }
+
+    std::vector<std::string> splitColumns(const std::string& text) {
+        std::vector<std::string> columns;
+        std::istringstream names(text);
+        std::string column;
+        while (std::getline(names, column, ',')) {
+            columns.push_back(column);
+        }
+        return columns;
+    }
+}
+
+// INDEXES n, then "name columns unique kind [included]" per index with
+// the columns separated by commas and kind BTREE or HASH (missing before
+// version 4)
+void CatalogManager::saveIndexes(std::ostream& file, const TableInfo& table) const {
+    file << "INDEXES " << table.indexes.size() << "\n";
+    for (const auto& index : table.indexes) {
+        file << index.name << " " << joinColumns(index.columns) << " " << (index.unique ? "1" : "0") << " "
+             << (index.hash ? "HASH" : "BTREE");
+        if (!index.included.empty()) {
+            file << " " << joinColumns(index.included);
+        }
+        file << "\n";
+    }
+}
+
+bool CatalogManager::loadIndexes(std::istream& file, TableInfo& table, int version) {
+    std::string line;
+    std::getline(file, line);
+    if (line.rfind("INDEXES ", 0) != 0) {
+        return false;
+    }
+    int num_indexes = std::stoi(line.substr(8));
+    for (int i = 0; i < num_indexes; i++) {
+        IndexInfo index;
+        std::string columns;
+        std::string included;
+        int unique;
+        std::getline(file, line);
+        std::istringstream fields(line);
+        if (!(fields >> index.name >> columns >> unique)) {
+            return false;
+        }
+        if (version >= 4) {
+            std::string kind;
+            if (!(fields >> kind) || (kind != "BTREE" && kind != "HASH")) {
+                return false;
+            }
+            index.hash = kind == "HASH";
+        }
+        index.columns = splitColumns(columns);
+        if (fields >> included) {
+            index.included = splitColumns(included);
+        }
+        index.unique = unique == 1;
+        table.indexes.push_back(index);
+    }
+    return true;
+}
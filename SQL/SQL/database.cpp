@@ -7,6 +7,9 @@
 #include <string>
 #include "page.h"
 #include "catalog_manager.h"
+#include "explain.h"
+#include <chrono>
+#include <iomanip>
 #include <filesystem>
 #include <fstream>
 
@@ -15,14 +18,105 @@ namespace fs = std::filesystem;
 
 namespace
 {
-    struct AggregateResult
+    ValueType columnType(const ColumnInfo &col, int *max_length = nullptr)
     {
-        double sum = 0;
-        int count = 0;
+        ValueType type = Value::typeFromName(col.type, max_length);
+        if (max_length && *max_length == 0 &&
+            (type == ValueType::VARCHAR || type == ValueType::CHAR))
+        {
+            *max_length = col.size;
+        }
+        return type;
+    }
+
+    // Converts an inserted or assigned value to its column's type
+    bool parseColumnValue(const ColumnInfo &col, const std::string &text, Value &value)
+    {
+        int max_length = 0;
+        ValueType type = columnType(col, &max_length);
+        std::string error;
+        if (!Value::parse(text, type, max_length, value, &error))
+        {
+            std::cerr << "Error: " << error << " (column " << col.name << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Converts a typed literal of a statement to its column's type
+    bool castColumnValue(const ColumnInfo &col, const Value &literal, Value &value)
+    {
+        int max_length = 0;
+        ValueType type = columnType(col, &max_length);
+        std::string error;
+        if (!literal.castTo(type, max_length, value, &error))
+        {
+            std::cerr << "Error: " << error << " (column " << col.name << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Statements issued outside BEGIN TRANSACTION run as their own
+    // transaction: committed by commit(), rolled back if the statement
+    // returns early or throws
+    class AutoCommitScope
+    {
+    public:
+        AutoCommitScope(TransactionManager *manager, RecoveryManager *recovery,
+                        int active_transaction_id)
+            : transaction_manager(manager), recovery_manager(recovery), transaction_id(-1)
+        {
+            if (active_transaction_id == -1)
+            {
+                transaction_id = transaction_manager->beginTransaction();
+            }
+        }
+
+        ~AutoCommitScope()
+        {
+            if (transaction_id != -1)
+            {
+                transaction_manager->abortTransaction(transaction_id);
+            }
+        }
+
+        bool commit()
+        {
+            if (transaction_id == -1)
+            {
+                return true;
+            }
+            int id = transaction_id;
+            transaction_id = -1;
+            if (!transaction_manager->commitTransaction(id))
+            {
+                return false;
+            }
+            recovery_manager->maybeCheckpoint();
+            return true;
+        }
+
+    private:
+        TransactionManager *transaction_manager;
+        RecoveryManager *recovery_manager;
+        int transaction_id;
     };
 
-    // Map for GROUP BY keys to their aggregates
-    using AggregateMap = std::unordered_map<std::string, AggregateResult>;
+    // DDL is not logged: a rollback must not undo the pages of a table or
+    // index that the catalog still knows about
+    class UnloggedScope
+    {
+    public:
+        UnloggedScope() : saved_transaction_id(StorageManager::getCurrentTransaction())
+        {
+            StorageManager::setCurrentTransaction(-1);
+        }
+        ~UnloggedScope() { StorageManager::setCurrentTransaction(saved_transaction_id); }
+
+    private:
+        int saved_transaction_id;
+    };
 }
 namespace {
     std::vector<std::string> split(const std::string& str, char delimiter) {
@@ -48,105 +142,73 @@ std::vector<std::string> readRecord(const char *data, const std::vector<ColumnIn
 // Add these helper functions at the top of database.cpp
 size_t getRecordSize(const Record &record)
 {
-    size_t size = 0;
-    size += sizeof(size_t); // For number of values
-
-    for (const auto &value : record.values)
-    {
-        size += sizeof(size_t); // For string length
-        size += value.length(); // For string content
-    }
-    return size;
+    return record.getSize();
 }
 
 bool serializeRecord(const Record &record, char *buffer, size_t buffer_size)
 {
-    size_t pos = 0;
-
-    // Write number of values
-    size_t num_values = record.values.size();
-    if (pos + sizeof(size_t) > buffer_size)
-        return false;
-    memcpy(buffer + pos, &num_values, sizeof(size_t));
-    pos += sizeof(size_t);
-
-    // Write each value
-    for (const auto &value : record.values)
-    {
-        // Write string length
-        size_t len = value.length();
-        if (pos + sizeof(size_t) > buffer_size)
-            return false;
-        memcpy(buffer + pos, &len, sizeof(size_t));
-        pos += sizeof(size_t);
-
-        // Write string content
-        if (pos + len > buffer_size)
-            return false;
-        memcpy(buffer + pos, value.c_str(), len);
-        pos += len;
-    }
-
-    return true;
+    return Record::serializeRecord(record, buffer, buffer_size);
 }
 
 bool deserializeRecord(Record &record, const char *buffer, size_t buffer_size)
 {
-    size_t pos = 0;
-
-    // Read number of values
-    size_t num_values;
-    if (pos + sizeof(size_t) > buffer_size)
-        return false;
-    memcpy(&num_values, buffer + pos, sizeof(size_t));
-    pos += sizeof(size_t);
-
-    record.values.clear();
-    record.values.reserve(num_values);
-
-    // Read each value
-    for (size_t i = 0; i < num_values; i++)
-    {
-        // Read string length
-        size_t len;
-        if (pos + sizeof(size_t) > buffer_size)
-            return false;
-        memcpy(&len, buffer + pos, sizeof(size_t));
-        pos += sizeof(size_t);
-
-        // Read string content
-        if (pos + len > buffer_size)
-            return false;
-        record.values.push_back(std::string(buffer + pos, len));
-        pos += len;
-    }
-
-    return true;
+    return record.deserialize(buffer, buffer_size);
 }
 
-Database::Database(const std::string& name) : db_name(name) {
+Database::Database(const std::string& name) : db_name(name), active_transaction_id(-1) {
     // Create data directory if it doesn't exist
     fs::create_directories("./data/" + db_name);
     
     // Initialize managers
+    std::string log_file = "./data/" + db_name + "/wal.log";
+    std::string master_file = "./data/" + db_name + "/wal.master";
+    log_manager = std::make_unique<LogManager>(log_file, RecoveryManager::prepareLog(log_file, master_file));
     storage_manager = std::make_unique<StorageManager>();
+    storage_manager->setLogManager(log_manager.get());
     catalog_manager = std::make_unique<CatalogManager>(db_name);
     index_manager = std::make_unique<IndexManager>(storage_manager.get());
+    recovery_manager = std::make_unique<RecoveryManager>(
+        storage_manager.get(),
+        log_manager.get(),
+        master_file
+    );
     transaction_manager = std::make_unique<TransactionManager>(
         storage_manager.get(), 
         catalog_manager.get(), 
-        index_manager.get()
+        index_manager.get(),
+        log_manager.get()
     );
     
     // Set current database name in transaction manager
     transaction_manager->setCurrentDatabase(db_name);
+
+    // Bring table and index pages back to a transaction-consistent state
+    int max_transaction_id = 0;
+    if (!recovery_manager->recover(max_transaction_id)) {
+        std::cerr << "Recovery failed for database: " << db_name << std::endl;
+    }
+    transaction_manager->setNextTransactionId(max_transaction_id + 1);
     
     // Load catalog
     reloadCatalog();
+
+    // Convert table and index files written by older versions
+    rebuildIndexes();
+
+    // Start the new log epoch from a clean checkpoint
+    recovery_manager->checkpoint(true);
 }
 
 Database::~Database() {
-    // No need to delete unique_ptr members - they will be automatically deleted
+    // A transaction still open when the database is closed never committed
+    if (active_transaction_id != -1) {
+        abortTransaction(active_transaction_id);
+    }
+
+    // A clean shutdown leaves nothing for the next restart to redo
+    if (fs::exists("./data/" + db_name)) {
+        recovery_manager->checkpoint(true);
+    }
 }
 
 void Database::reloadCatalog() {
@@ -155,6 +217,66 @@ void Database::reloadCatalog() {
     }
 }
 
+void Database::rebuildIndexes() {
+    std::string db_path = "./data/" + db_name;
+    if (!fs::exists(db_path)) {
+        return;
+    }
+
+    for (const auto& entry : fs::directory_iterator(db_path)) {
+        if (entry.path().extension() != ".dat" || entry.path().filename() == "catalog.dat") {
+            continue;
+        }
+
+        std::string table_name = entry.path().stem().string();
+        TableInfo* table = catalog_manager->getTableInfo(table_name);
+        if (!table) {
+            continue;
+        }
+
+        // Record locations change when an old table file is converted to heap pages
+        std::vector<ValueType> column_types;
+        for (const auto& col : table->columns) {
+            column_types.push_back(columnType(col));
+        }
+        bool converted = storage_manager->upgradeLegacyTable(getTablePath(table_name), column_types);
+
+        for (const auto& index : table->indexes) {
+            if (!converted && index_manager->isValidIndex(catalog_manager->getIndexPath(index))) {
+                continue;
+            }
+            std::cout << "Rebuilding index: " << catalog_manager->getIndexPath(index) << std::endl;
+            buildIndex(table, index);
+        }
+    }
+}
+
+// Creates the file of index from one scan of the table, bulk loading an
+// entry for every row
+bool Database::buildIndex(TableInfo* table, const IndexInfo& index) {
+    TableIterator it = storage_manager->scan(getTablePath(table->name));
+    Record record;
+    auto next = [&](IndexEntry& entry) {
+        if (!it.next(record)) {
+            return false;
+        }
+        entry.key = columnValues(table, index.columns, record);
+        entry.included = columnValues(table, index.included, record);
+        entry.rid = record.rid;
+        return true;
+    };
+    return index_manager->bulkLoad(db_name, table->name, index.columns, index.unique, index.hash, next);
+}
+
+// The values of the row in columns, e.g. an index's key columns
+IndexKey Database::columnValues(TableInfo* table, const std::vector<std::string>& columns, const Record& record) {
+    IndexKey values;
+    for (const auto& column : columns) {
+        values.push_back(record.values[getColumnIndex(table, column)]);
+    }
+    return values;
+}
+
 bool Database::cleanup() {
     // Remove all existing catalog files
     std::string catalog_path = "./data/" + db_name + "/catalog.dat";
@@ -175,6 +297,8 @@ bool Database::cleanup() {
 }
 
 bool Database::createTable(const std::string& table_name, const std::vector<ColumnInfo>& columns) {
+    UnloggedScope unlogged;
+
     // Check if table already exists
     if (catalog_manager->getTableInfo(table_name) != nullptr) {
         return false;  // Table already exists
@@ -184,13 +308,26 @@ bool Database::createTable(const std::string& table_name, const std::vector<Colu
     if (!storage_manager->createTable(db_name, table_name)) {
         return false;
     }
+
+    // Primary keys are always backed by a unique B+ tree index
+    for (const auto& col : columns) {
+        if (col.is_primary_key && !index_manager->createIndex(db_name, table_name, {col.name}, true)) {
+            return false;
+        }
+    }
     
     // Add table to catalog
-    return catalog_manager->createTable(table_name, columns);
+    if (!catalog_manager->createTable(table_name, columns)) {
+        return false;
+    }
+
+    // DDL is not logged; make sure redo never reaches back past it
+    return recovery_manager->checkpoint(true);
 }
 
 bool Database::dropTable(const std::string &table_name)
 {
+    UnloggedScope unlogged;
     TableInfo *table = catalog_manager->getTableInfo(table_name);
     if (!table)
         return false;
@@ -202,17 +339,24 @@ bool Database::dropTable(const std::string &table_name)
     }
 
     // Drop associated indexes
-    for (const auto &index_file : table->index_files)
+    for (const auto &index : table->indexes)
     {
-        storage_manager->dropTable(db_name, index_file);
+        index_manager->dropIndex(db_name, table_name, index.columns, index.hash);
     }
 
-    return catalog_manager->dropTable(table_name);
+    if (!catalog_manager->dropTable(table_name))
+    {
+        return false;
+    }
+    return recovery_manager->checkpoint(true);
 }
 
 bool Database::createIndex(const std::string &table_name,
-                           const std::string &column_name)
+                           const std::vector<std::string> &columns,
+                           const std::vector<std::string> &included,
+                           bool hash)
 {
+    UnloggedScope unlogged;
     TableInfo *table = catalog_manager->getTableInfo(table_name);
     if (!table)
     {
@@ -220,35 +364,98 @@ bool Database::createIndex(const std::string &table_name,
         return false;
     }
 
-    // Check if column exists
-    bool column_found = false;
-    for (const auto &col : table->columns)
+    // Check if the key and included columns exist, each named once
+    std::vector<std::string> all_columns = columns;
+    all_columns.insert(all_columns.end(), included.begin(), included.end());
+    for (size_t i = 0; i < all_columns.size(); i++)
+    {
+        bool column_found = false;
+        for (const auto &col : table->columns)
+        {
+            if (col.name == all_columns[i])
+            {
+                column_found = true;
+                break;
+            }
+        }
+
+        if (!column_found)
+        {
+            std::cerr << "Column not found: " << all_columns[i] << std::endl;
+            return false;
+        }
+        if (std::find(all_columns.begin(), all_columns.begin() + i, all_columns[i]) != all_columns.begin() + i)
+        {
+            std::cerr << "Column indexed twice: " << all_columns[i] << std::endl;
+            return false;
+        }
+    }
+    // Secondary indexes allow duplicate keys, except that a hash index on
+    // the key of a unique index is unique too and takes over its duplicate
+    // checks. Fill the new index from the rows already in the table.
+    IndexInfo index;
+    index.name = indexFileName(table_name, columns, hash);
+    index.columns = columns;
+    index.included = included;
+    index.hash = hash;
+    for (const auto &existing : table->indexes)
     {
-        if (col.name == column_name)
+        if (existing.columns == columns && existing.hash == hash)
         {
-            column_found = true;
-            break;
+            std::cerr << "Index already exists: " << existing.name << std::endl;
+            return false;
+        }
+        if (existing.columns == columns && existing.unique)
+        {
+            index.unique = true;
         }
     }
+    if (!buildIndex(table, index))
+    {
+        std::cerr << "Failed to create index" << std::endl;
+        index_manager->dropIndex(db_name, table_name, columns, hash);
+        return false;
+    }
 
-    if (!column_found)
+    if (!catalog_manager->addIndex(table_name, index))
     {
-        std::cerr << "Column not found: " << column_name << std::endl;
         return false;
     }
+    return recovery_manager->checkpoint(true);
+}
 
-    // Create the index
-    if (!index_manager->createIndex(db_name, table_name, column_name))
+bool Database::analyze(const std::string &table_name)
+{
+    TableInfo *table = catalog_manager->getTableInfo(table_name);
+    if (!table)
     {
-        std::cerr << "Failed to create index" << std::endl;
+        std::cerr << "Table not found: " << table_name << std::endl;
         return false;
     }
 
-    // Add index file to table info
-    std::string index_file = table_name + "_" + column_name + ".idx";
-    table->index_files.push_back(index_file);
+    StatisticsBuilder builder(table->columns.size());
+    TableIterator it = storage_manager->scan(getTablePath(table_name));
+    Record record;
+    while (it.next(record))
+    {
+        builder.add(record);
+    }
+    TableStats stats = builder.finish(it.getPagesRead());
+
+    std::cout << "Rows: " << stats.row_count << ", pages: " << stats.page_count << std::endl;
+    for (size_t i = 0; i < table->columns.size(); i++)
+    {
+        const ColumnStats &col = stats.columns[i];
+        std::cout << "  " << table->columns[i].name << ": " << col.distinct_count << " distinct, "
+                  << col.null_count << " null";
+        if (col.distinct_count > 0)
+        {
+            std::cout << ", min " << col.min << ", max " << col.max;
+        }
+        std::cout << std::endl;
+    }
 
-    return true;
+    return catalog_manager->setTableStats(table_name, stats);
 }
 
 bool Database::insert(const std::string &table_name,
@@ -261,410 +468,188 @@ bool Database::insert(const std::string &table_name,
         return false;
     }
 
-    // Check and update indexes
+    // Type every value once; rows are stored in binary form
+    Record record;
     for (size_t i = 0; i < table->columns.size(); i++)
     {
-        const ColumnInfo &col = table->columns[i];
-        if (col.is_primary_key)
+        Value value;
+        if (!parseColumnValue(table->columns[i], values[i], value))
         {
-            try
-            {
-                int key = std::stoi(values[i]);
-                // Fix the path to include the proper prefix
-                std::string index_file = "./data/" + db_name + "/" + table_name + "_" + col.name + ".idx";
-                std::cout << "Checking primary key constraint in: " << index_file << std::endl;
-
-                if (index_manager->exists(index_file, key))
-                {
-                    std::cerr << "Error: Duplicate primary key value: " << key << std::endl;
-                    return false;
-                }
-            }
-            catch (...)
-            {
-                std::cerr << "Error: Invalid primary key value" << std::endl;
-                return false;
-            }
+            return false;
         }
+        record.values.push_back(value);
     }
+    return insertRecord(table, record);
+}
 
-    // Insert the record
-    Record record;
-    record.values = values;
-    if (!storage_manager->insertRecord(db_name, table_name, record))
+bool Database::insert(const std::string &table_name,
+                      const std::vector<Value> &values)
+{
+    TableInfo *table = catalog_manager->getTableInfo(table_name);
+    if (!table || values.size() != table->columns.size())
     {
-        std::cerr << "Failed to insert record into table" << std::endl;
+        std::cerr << "Invalid table or number of values" << std::endl;
         return false;
     }
 
-    // Update all relevant indexes
+    Record record;
     for (size_t i = 0; i < table->columns.size(); i++)
     {
-        const ColumnInfo &col = table->columns[i];
-        if (col.is_primary_key)
+        Value value;
+        if (!castColumnValue(table->columns[i], values[i], value))
         {
-            try
-            {
-                int key = std::stoi(values[i]);
-                // Fix the path to include the proper prefix
-                std::string index_file = "./data/" + db_name + "/" + table_name + "_" + col.name + ".idx";
-                std::cout << "Updating index: " << index_file << std::endl;
-
-                if (!index_manager->insert(index_file, key, record))
-                {
-                    std::cerr << "Failed to update index: " << index_file << std::endl;
-                    return false;
-                }
-            }
-            catch (const std::exception &e)
-            {
-                std::cerr << "Error updating index: " << e.what() << std::endl;
-                return false;
-            }
+            return false;
         }
+        record.values.push_back(value);
     }
-
-    return true;
+    return insertRecord(table, record);
 }
 
-// Simple select without conditions
-std::vector<Record> Database::select(const std::string &table_name,
-                                     const std::string &where_clause)
+bool Database::insertRecord(TableInfo *table, Record &record)
 {
-    std::vector<Record> result;
-    if (where_clause.empty())
+    const std::string &table_name = table->name;
+
+    // Check primary key constraints
+    for (size_t i = 0; i < table->columns.size(); i++)
+    {
+        if (table->columns[i].is_primary_key && record.values[i].isNull())
+        {
+            std::cerr << "Error: Invalid primary key value" << std::endl;
+            return false;
+        }
+    }
+    for (const IndexInfo *index : uniqueIndexes(table))
     {
-        // Simple SELECT * case
-        std::string data_file = getTablePath(table_name);
-        result = storage_manager->getAllRecords(data_file);
+        IndexKey key = columnValues(table, index->columns, record);
+        std::string index_file = catalog_manager->getIndexPath(*index);
+        std::cout << "Checking primary key constraint in: " << index_file << std::endl;
 
-        // Display results
-        TableInfo *table = catalog_manager->getTableInfo(table_name);
-        if (table)
+        if (index_manager->exists(index_file, key))
         {
-            std::cout << "\nQuery Results (" << result.size() << " records):\n";
-            std::cout << "----------------------------------------\n";
+            std::cerr << "Error: Duplicate primary key value: " << key.front() << std::endl;
+            return false;
+        }
+    }
 
-            // Print header
-            for (const auto &col : table->columns)
-            {
-                std::cout << std::setw(15) << std::left << col.name;
-            }
-            std::cout << "\n----------------------------------------\n";
+    // Insert the record
+    AutoCommitScope statement(transaction_manager.get(), recovery_manager.get(), active_transaction_id);
+    if (!storage_manager->insertRecord(db_name, table_name, record, &record.rid))
+    {
+        std::cerr << "Failed to insert record into table" << std::endl;
+        return false;
+    }
 
-            // Print records
-            for (const auto &record : result)
-            {
-                for (const auto &value : record.values)
-                {
-                    std::cout << std::setw(15) << std::left << value;
-                }
-                std::cout << "\n";
-            }
-            std::cout << "----------------------------------------\n";
-        }
+    // Update all relevant indexes
+    if (!updateIndexEntries(table, nullptr, &record))
+    {
+        return false;
     }
-    return result;
+
+    return statement.commit();
 }
 
-std::vector<Record> Database::groupQuery(const std::string& table_name,
-    const std::string& group_column,
-    const std::string& agg_function,
-    const std::string& where_clause,
-    const std::string& having_clause)
+Planner Database::makePlanner()
 {
-    std::vector<Record> results;
-    std::map<std::string, std::vector<Record>> groups;
-    
-    // Get all records
-    std::vector<Record> all_records = storage_manager->getAllRecords(
-        storage_manager->getTablePath(db_name, table_name));
-    
-    // Apply WHERE clause if present
-    if (!where_clause.empty()) {
-        std::vector<Record> filtered_records;
-        for (const auto& record : all_records) {
-            if (evaluateCondition(record, where_clause)) {
-                filtered_records.push_back(record);
-            }
-        }
-        all_records = filtered_records;
+    return Planner(catalog_manager.get(), storage_manager.get(), index_manager.get(), db_name);
+}
+
+// Plans a parsed SELECT into an operator tree and prints the rows the root
+// produces; pipelined plans print each row as soon as it is pulled
+bool Database::executeSelect(SelectStatement &query)
+{
+    std::string error;
+    OperatorPtr root;
+    if (!makePlanner().planSelect(query, root, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
     }
-    
-    // Group records
-    for (const auto& record : all_records) {
-        // Find the group column index
-        int group_col_idx = -1;
-        for (size_t i = 0; i < record.values.size(); i++) {
-            if (catalog_manager->getColumnName(table_name, i) == group_column) {
-                group_col_idx = i;
-                break;
-            }
-        }
-        
-        if (group_col_idx != -1) {
-            groups[record.values[group_col_idx]].push_back(record);
-        }
+    if (!root->open())
+    {
+        std::cerr << "Error: Failed to execute query" << std::endl;
+        root->close();
+        return false;
     }
-    
-    // Apply aggregate function and HAVING clause
-    for (const auto& group : groups) {
-        Record result;
-        result.values.push_back(group.first); // Group value
-        
-        // Calculate aggregate
-        double agg_value = 0.0;
-        std::string agg_alias;
-        
-        if (agg_function == "COUNT(*)") {
-            agg_value = group.second.size();
-            agg_alias = "count";
-        } else {
-            // Extract column name and alias from aggregate function
-            size_t start = agg_function.find('(') + 1;
-            size_t end = agg_function.find(')');
-            std::string agg_column = agg_function.substr(start, end - start);
-            
-            // Check for alias
-            size_t as_pos = agg_function.find(" as ");
-            if (as_pos != std::string::npos) {
-                agg_alias = agg_function.substr(as_pos + 4);
-            } else {
-                agg_alias = agg_column;
-            }
-            
-            // Find the aggregate column index
-            int agg_col_idx = -1;
-            for (size_t i = 0; i < group.second[0].values.size(); i++) {
-                if (catalog_manager->getColumnName(table_name, i) == agg_column) {
-                    agg_col_idx = i;
-                    break;
-                }
-            }
-            
-            if (agg_col_idx != -1) {
-                if (agg_function.find("AVG") != std::string::npos) {
-                    double sum = 0.0;
-                    for (const auto& record : group.second) {
-                        sum += std::stod(record.values[agg_col_idx]);
-                    }
-                    agg_value = sum / group.second.size();
-                } else if (agg_function.find("SUM") != std::string::npos) {
-                    for (const auto& record : group.second) {
-                        agg_value += std::stod(record.values[agg_col_idx]);
-                    }
-                }
-            }
-        }
-        
-        // Check HAVING clause
-        bool include_group = true;
-        if (!having_clause.empty()) {
-            // Parse HAVING clause
-            std::istringstream iss(having_clause);
-            std::string col_name, op, value;
-            iss >> col_name >> op >> value;
-            
-            // Check if column name matches the alias
-            if (col_name == agg_alias) {
-                double having_value = std::stod(value);
-                if (op == ">") {
-                    include_group = agg_value > having_value;
-                } else if (op == "<") {
-                    include_group = agg_value < having_value;
-                } else if (op == "=") {
-                    include_group = agg_value == having_value;
-                }
-            }
-        }
-        
-        if (include_group) {
-            result.values.push_back(std::to_string(agg_value));
-            results.push_back(result);
-        }
+
+    std::cout << "\nQuery Results:\n";
+    std::cout << "----------------------------------------\n";
+    for (const auto &column : root->getSchema())
+    {
+        std::string name = query.joins.empty() || column.table.empty() ? column.name : column.table + "." + column.name;
+        std::cout << std::setw(15) << std::left << name;
     }
-    
-    return results;
-}
+    std::cout << "\n----------------------------------------\n";
 
-// Select with conditions
-bool Database::selectWithCondition(const std::string &table_name,
-                                   const std::string &column_name,
-                                   const std::string &op,
-                                   const std::string &value,
-                                   std::vector<Record> &result)
-{
-    try
+    size_t count = 0;
+    Record row;
+    while (root->next(row))
     {
-        TableInfo *table = catalog_manager->getTableInfo(table_name);
-        if (!table)
+        for (const auto &value : row.values)
         {
-            std::cerr << "Table not found: " << table_name << std::endl;
-            return false;
+            std::cout << std::setw(15) << std::left << value;
         }
+        std::cout << "\n";
+        count++;
+    }
+    root->close();
+    if (root->failed())
+    {
+        std::cerr << "Error: Query stopped after " << count << " records" << std::endl;
+        return false;
+    }
 
-        // Check for aggregate queries
-        bool is_aggregate = (column_name.find("COUNT(") != std::string::npos ||
-                             column_name.find("SUM(") != std::string::npos ||
-                             column_name.find("AVG(") != std::string::npos ||
-                             column_name.find("MIN(") != std::string::npos ||
-                             column_name.find("MAX(") != std::string::npos);
-
-        // For aggregate functions, extract column name
-        std::string actual_column;
-        int col_index = -1;
-        if (is_aggregate && column_name != "COUNT(*)")
-        {
-            size_t start = column_name.find('(') + 1;
-            size_t end = column_name.find(')');
-            actual_column = column_name.substr(start, end - start);
-
-            for (size_t i = 0; i < table->columns.size(); i++)
-            {
-                if (table->columns[i].name == actual_column)
-                {
-                    col_index = i;
-                    break;
-                }
-            }
-            if (col_index == -1)
-            {
-                std::cerr << "Column not found in aggregate function: " << actual_column << std::endl;
-                return false;
-            }
-        }
-
-        result.clear();
-        std::vector<Record> all_records = storage_manager->getAllRecords(getTablePath(table_name));
-
-        if (is_aggregate)
-        {
-            if (column_name == "COUNT(*)")
-            {
-                Record count_record;
-                count_record.values.push_back(std::to_string(all_records.size()));
-                result.push_back(count_record);
-            }
-            else if (column_name.find("SUM(") != std::string::npos)
-            {
-                double sum = 0;
-                for (const auto &record : all_records)
-                {
-                    sum += std::stod(record.values[col_index]);
-                }
-                Record sum_record;
-                sum_record.values.push_back(std::to_string(sum));
-                result.push_back(sum_record);
-            }
-            else if (column_name.find("AVG(") != std::string::npos)
-            {
-                double sum = 0;
-                for (const auto &record : all_records)
-                {
-                    sum += std::stod(record.values[col_index]);
-                }
-                Record avg_record;
-                avg_record.values.push_back(std::to_string(sum / all_records.size()));
-                result.push_back(avg_record);
-            }
-            else if (column_name.find("MIN(") != std::string::npos)
-            {
-                double min_val = std::numeric_limits<double>::max();
-                for (const auto &record : all_records)
-                {
-                    double val = std::stod(record.values[col_index]);
-                    if (val < min_val)
-                        min_val = val;
-                }
-                Record min_record;
-                min_record.values.push_back(std::to_string(min_val));
-                result.push_back(min_record);
-            }
-            else if (column_name.find("MAX(") != std::string::npos)
-            {
-                double max_val = std::numeric_limits<double>::lowest();
-                for (const auto &record : all_records)
-                {
-                    double val = std::stod(record.values[col_index]);
-                    if (val > max_val)
-                        max_val = val;
-                }
-                Record max_record;
-                max_record.values.push_back(std::to_string(max_val));
-                result.push_back(max_record);
-            }
-
-            // Display aggregate results
-            std::cout << "\nQuery Results:\n";
-            std::cout << "----------------------------------------\n";
-            std::cout << std::setw(15) << std::left << column_name << "\n";
-            std::cout << "----------------------------------------\n";
-            for (const auto &record : result)
-            {
-                std::cout << std::setw(15) << std::left << record.values[0] << "\n";
-            }
-            std::cout << "----------------------------------------\n";
-            return true;
-        }
+    std::cout << "----------------------------------------\n";
+    std::cout << "(" << count << " records)\n";
+    return true;
+}
 
-        // Original non-aggregate query handling
-        for (size_t i = 0; i < table->columns.size(); i++)
-        {
-            if (table->columns[i].name == column_name)
-            {
-                col_index = i;
-                break;
-            }
-        }
+bool Database::explainSelect(SelectStatement &query, bool analyze)
+{
+    std::string error;
+    OperatorPtr root;
+    if (!makePlanner().planSelect(query, root, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
 
-        if (col_index == -1)
+    double total_ms = 0;
+    if (analyze)
+    {
+        profilePlan(root, storage_manager->getBufferPool());
+        auto start = std::chrono::steady_clock::now();
+        if (!root->open())
         {
-            std::cerr << "Column not found: " << column_name << std::endl;
+            std::cerr << "Error: Failed to execute query" << std::endl;
+            root->close();
             return false;
         }
-
-        bool has_index = table->columns[col_index].is_primary_key;
-        std::string index_file = db_name + "/" + table_name + "_" + column_name + ".idx";
-
-        bool success;
-        if (has_index)
-        {
-            success = selectUsingIndex(table_name, index_file, op, value, result);
-        }
-        else
+        Record row;
+        while (root->next(row))
         {
-            success = selectUsingTableScan(table_name, col_index, op, value, result);
         }
-
-        // Display non-aggregate results
-        if (success)
+        root->close();
+        if (root->failed())
         {
-            std::cout << "\nQuery Results (" << result.size() << " records):\n";
-            std::cout << "----------------------------------------\n";
-            for (const auto &col : table->columns)
-            {
-                std::cout << std::setw(15) << std::left << col.name;
-            }
-            std::cout << "\n----------------------------------------\n";
-            for (const auto &record : result)
-            {
-                for (const auto &value : record.values)
-                {
-                    std::cout << std::setw(15) << std::left << value;
-                }
-                std::cout << "\n";
-            }
-            std::cout << "----------------------------------------\n";
+            std::cerr << "Error: Failed to execute query" << std::endl;
+            return false;
         }
-
-        return success;
+        total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     }
-    catch (const std::exception &e)
+
+    std::cout << "\nQuery Plan:\n";
+    std::cout << "----------------------------------------\n";
+    printPlan(root.get(), std::cout);
+    std::cout << "----------------------------------------\n";
+    if (analyze)
     {
-        std::cerr << "Error in select: " << e.what() << std::endl;
-        return false;
+        std::ostringstream time;
+        time << std::fixed << std::setprecision(3) << total_ms;
+        std::cout << "Execution time: " << time.str() << " ms\n";
     }
+    return true;
 }
+
 int Database::getColumnIndex(TableInfo *table, const std::string &col_name)
 {
     for (size_t i = 0; i < table->columns.size(); i++)
@@ -703,305 +688,87 @@ std::vector<std::string> readRecord(const char *data, const std::vector<ColumnIn
 }
 
 bool Database::update(const std::string &table_name,
-                     const std::string &set_clause,
-                     const std::string &where_clause)
+                     const std::vector<Assignment> &assignments,
+                     Expression *where)
 {
     try
     {
-        // Parse WHERE clause
-        std::istringstream where_iss(where_clause);
-        std::string column, op, value;
-        where_iss >> column >> op;
-        std::getline(where_iss, value);
-        value = value.substr(value.find_first_not_of(" \t"));
-        if (!value.empty() && (value[0] == '\'' || value[0] == '"'))
-            value = value.substr(1, value.length() - 2);
-
-        // Find records to update
-        std::vector<Record> records_to_update_metadata;
-        if (!selectWithCondition(table_name, column, op, value, records_to_update_metadata))
-        {
-            if (records_to_update_metadata.empty())
-            {
-                std::cout << "No records matched the WHERE clause. No update performed." << std::endl;
-                return true;
-            }
-            std::cerr << "Error during selectWithCondition for update." << std::endl;
-            return false;
-        }
-        if (records_to_update_metadata.empty())
-        {
-            std::cout << "No records matched the WHERE clause. No update performed." << std::endl;
-            return true;
-        }
-
-        // Display query results
-        std::cout << "\nQuery Results (" << records_to_update_metadata.size() << " records):" << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
-
         TableInfo *table = catalog_manager->getTableInfo(table_name);
         if (!table)
-            return false;
-
-        for (size_t i = 0; i < table->columns.size(); i++)
         {
-            std::cout << std::left << std::setw(15) << table->columns[i].name;
+            std::cerr << "Table not found: " << table_name << std::endl;
+            return false;
         }
-        std::cout << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
 
-        for (const auto &record : records_to_update_metadata)
+        // Type each new value against its column once, up front
+        std::vector<std::pair<int, Value>> changes;
+        for (const auto &assignment : assignments)
         {
-            for (size_t i = 0; i < record.values.size(); i++)
+            int col_index = getColumnIndex(table, assignment.column);
+            Value new_value;
+            if (!castColumnValue(table->columns[col_index], assignment.value, new_value))
             {
-                std::string display_value = record.values[i];
-                std::cout << std::left << std::setw(15) << display_value;
+                return false;
             }
-            std::cout << std::endl;
-        }
-        std::cout << "----------------------------------------" << std::endl;
-
-        // Parse SET clause
-        size_t equals_pos = set_clause.find('=');
-        if (equals_pos == std::string::npos)
-            return false;
-        std::string update_col_name = set_clause.substr(0, equals_pos);
-        std::string new_value_str = set_clause.substr(equals_pos + 1);
-        update_col_name.erase(0, update_col_name.find_first_not_of(" \t"));
-        update_col_name.erase(update_col_name.find_last_not_of(" \t") + 1);
-        new_value_str.erase(0, new_value_str.find_first_not_of(" \t"));
-        new_value_str.erase(new_value_str.find_last_not_of(" \t") + 1);
-        if (!new_value_str.empty() && (new_value_str[0] == '\'' || new_value_str[0] == '"'))
-            new_value_str = new_value_str.substr(1, new_value_str.length() - 2);
-
-        // Find column index
-        int update_col_idx = -1;
-        for (size_t i = 0; i < table->columns.size(); i++)
-        {
-            if (table->columns[i].name == update_col_name)
+            if (table->columns[col_index].is_primary_key && new_value.isNull())
             {
-                update_col_idx = i;
-                break;
+                std::cerr << "Error: Invalid primary key value" << std::endl;
+                return false;
             }
+            changes.push_back({col_index, new_value});
         }
-        if (update_col_idx == -1)
-            return false;
-
-        // Check if we're updating a primary key column
-        bool updating_primary_key = table->columns[update_col_idx].is_primary_key;
 
-        // Get the data file path
-        std::string data_file = getTablePath(table_name);
-
-        // Read all records first
-        std::vector<Record> all_records;
-        std::ifstream inFile(data_file, std::ios::binary);
-        if (!inFile)
+        // Find records to update, together with their RIDs
+        std::vector<Record> records_to_update;
+        if (!findMatchingRecords(table, where, records_to_update))
         {
-            std::cerr << "Failed to open file: " << data_file << std::endl;
+            std::cerr << "Error locating records for update." << std::endl;
             return false;
         }
+        if (records_to_update.empty())
+        {
+            std::cout << "No records matched the WHERE clause. No update performed." << std::endl;
+            return true;
+        }
 
-        // Get file size
-        inFile.seekg(0, std::ios::end);
-        size_t file_size = inFile.tellg();
-        inFile.seekg(0, std::ios::beg);
+        printRecords(table, records_to_update);
 
-        // Read all records from file
-        if (file_size > 0)
+        // Rewrite each matching record in place and patch the indexes
+        AutoCommitScope statement(transaction_manager.get(), recovery_manager.get(), active_transaction_id);
+        for (const auto &old_record : records_to_update)
         {
-            std::vector<char> buffer(file_size);
-            inFile.read(buffer.data(), file_size);
-
-            size_t pos = 0;
-            while (pos < file_size)
+            Record new_record = old_record;
+            for (const auto &change : changes)
             {
-                // Read record size
-                size_t record_size;
-                if (pos + sizeof(size_t) > file_size)
-                    break;
-                memcpy(&record_size, buffer.data() + pos, sizeof(size_t));
-
-                if (record_size == 0 || pos + record_size > file_size)
-                    break;
-
-                // Create new record and deserialize
-                Record record;
-
-                // Manual deserialization
-                size_t data_pos = pos + sizeof(size_t); // Skip record size
-
-                // Read number of values
-                size_t num_values;
-                memcpy(&num_values, buffer.data() + data_pos, sizeof(size_t));
-                data_pos += sizeof(size_t);
-
-                // Read values
-                for (size_t i = 0; i < num_values; i++)
-                {
-                    size_t str_len;
-                    memcpy(&str_len, buffer.data() + data_pos, sizeof(size_t));
-                    data_pos += sizeof(size_t);
-
-                    std::string value(buffer.data() + data_pos, str_len);
-                    record.values.push_back(value);
-                    data_pos += str_len;
-                }
-
-                all_records.push_back(record);
-                pos += record_size;
+                new_record.values[change.first] = change.second;
             }
-        }
-        inFile.close();
-
-        // Update matching records
-        bool any_updated = false;
-        for (auto &record : all_records)
-        {
-            for (const auto &meta_record : records_to_update_metadata)
+            for (const IndexInfo *index : uniqueIndexes(table))
             {
-                if (record.values == meta_record.values)
+                IndexKey key = columnValues(table, index->columns, new_record);
+                if (compareKeys(key, columnValues(table, index->columns, old_record)) != 0 &&
+                    index_manager->exists(catalog_manager->getIndexPath(*index), key))
                 {
-                    record.values[update_col_idx] = new_value_str;
-                    any_updated = true;
-                    break;
+                    std::cerr << "Error: Duplicate primary key value: " << key.front() << std::endl;
+                    return false;
                 }
             }
-        }
-
-        if (!any_updated) {
-            std::cout << "No records were updated." << std::endl;
-            return true;
-        }
 
-        // Create temporary file and write all records
-        std::string temp_file = data_file + ".tmp";
-        std::ofstream outFile(temp_file, std::ios::binary);
-        if (!outFile)
-        {
-            std::cerr << "Failed to create temporary file: " << temp_file << std::endl;
-            return false;
-        }
-
-        // Write all records to the temporary file
-        for (const auto &record : all_records)
-        {
-            // Calculate record size
-            size_t total_size = sizeof(size_t); // Size field itself
-            total_size += sizeof(size_t);       // Number of values
-
-            for (const auto &value : record.values)
+            if (!storage_manager->updateRecord(db_name, table_name, old_record.rid, new_record, &new_record.rid))
             {
-                total_size += sizeof(size_t); // String length
-                total_size += value.length(); // String content
+                std::cerr << "Failed to update record" << std::endl;
+                return false;
             }
 
-            // Create buffer
-            std::vector<char> buffer(total_size);
-            size_t pos = 0;
-
-            // Write total size first
-            memcpy(buffer.data() + pos, &total_size, sizeof(size_t));
-            pos += sizeof(size_t);
-
-            // Write number of values
-            size_t num_values = record.values.size();
-            memcpy(buffer.data() + pos, &num_values, sizeof(size_t));
-            pos += sizeof(size_t);
-
-            // Write all values
-            for (const auto &value : record.values)
+            if (!updateIndexEntries(table, &old_record, &new_record))
             {
-                // Write string length
-                size_t len = value.length();
-                memcpy(buffer.data() + pos, &len, sizeof(size_t));
-                pos += sizeof(size_t);
-
-                // Write string content
-                memcpy(buffer.data() + pos, value.c_str(), len);
-                pos += len;
+                return false;
             }
-
-            // Write to file
-            outFile.write(buffer.data(), total_size);
         }
 
-        outFile.close();
-
-        // Replace original file with temporary file
-        if (std::remove(data_file.c_str()) != 0)
+        if (!statement.commit())
         {
-            std::cerr << "Failed to remove original file: " << data_file << std::endl;
-            std::remove(temp_file.c_str());
             return false;
         }
-
-        if (std::rename(temp_file.c_str(), data_file.c_str()) != 0)
-        {
-            std::cerr << "Failed to rename temporary file: " << temp_file << std::endl;
-            return false;
-        }
-
-        // Rebuild indexes if necessary
-        if (updating_primary_key)
-        {
-            for (const auto &col : table->columns)
-            {
-                if (col.is_primary_key)
-                {
-                    // Find column index
-                    int col_index = -1;
-                    for (size_t i = 0; i < table->columns.size(); i++)
-                    {
-                        if (table->columns[i].name == col.name)
-                        {
-                            col_index = i;
-                            break;
-                        }
-                    }
-
-                    if (col_index >= 0)
-                    {
-                        // Recreate index
-                        std::string index_file = db_name + "/" + table_name + "_" + col.name + ".idx";
-
-                        // Drop old index
-                        if (!index_manager->dropIndex(db_name, table_name, col.name))
-                        {
-                            std::cerr << "Failed to drop index for column: " << col.name << std::endl;
-                        }
-
-                        // Create new index
-                        if (!index_manager->createIndex(db_name, table_name, col.name))
-                        {
-                            std::cerr << "Failed to rebuild index for column: " << col.name << std::endl;
-                            return false;
-                        }
-
-                        // Rebuild index with all records
-                        for (const auto &record : all_records)
-                        {
-                            if (static_cast<size_t>(col_index) < record.values.size())
-                            {
-                                try
-                                {
-                                    int key = std::stoi(record.values[col_index]);
-                                    if (!index_manager->insert(index_file, key, record))
-                                    {
-                                        std::cerr << "Failed to update index with key: " << key << std::endl;
-                                    }
-                                }
-                                catch (...)
-                                {
-                                    std::cerr << "Error parsing key for index" << std::endl;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
         std::cout << "Records updated successfully" << std::endl;
         return true;
     }
@@ -1012,30 +779,22 @@ bool Database::update(const std::string &table_name,
     }
 }
 
-bool Database::remove(const std::string &table_name,
-                     const std::string &where_clause)
+bool Database::remove(const std::string &table_name, Expression *where)
 {
     try
     {
-        // Parse WHERE clause
-        std::istringstream where_iss(where_clause);
-        std::string column, op, value;
-        where_iss >> column >> op;
-        std::getline(where_iss, value);
-        value = value.substr(value.find_first_not_of(" \t"));
-        if (!value.empty() && (value[0] == '\'' || value[0] == '"'))
-            value = value.substr(1, value.length() - 2);
-
-        // Find records to delete
+        TableInfo *table = catalog_manager->getTableInfo(table_name);
+        if (!table)
+        {
+            std::cerr << "Table not found: " << table_name << std::endl;
+            return false;
+        }
+
+        // Find records to delete, together with their RIDs
         std::vector<Record> records_to_delete;
-        if (!selectWithCondition(table_name, column, op, value, records_to_delete))
+        if (!findMatchingRecords(table, where, records_to_delete))
         {
-            if (records_to_delete.empty())
-            {
-                std::cout << "No records matched the WHERE clause. No delete performed." << std::endl;
-                return true;
-            }
-            std::cerr << "Error during selectWithCondition for delete." << std::endl;
+            std::cerr << "Error locating records for delete." << std::endl;
             return false;
         }
         if (records_to_delete.empty())
@@ -1044,245 +803,136 @@ bool Database::remove(const std::string &table_name,
             return true;
         }
 
-        // Display query results
-        std::cout << "\nQuery Results (" << records_to_delete.size() << " records):" << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
-
-        TableInfo *table = catalog_manager->getTableInfo(table_name);
-        if (!table)
-            return false;
-
-        for (size_t i = 0; i < table->columns.size(); i++)
-        {
-            std::cout << std::left << std::setw(15) << table->columns[i].name;
-        }
-        std::cout << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
+        printRecords(table, records_to_delete);
 
+        // Free each slot on its page and drop the index entries
+        AutoCommitScope statement(transaction_manager.get(), recovery_manager.get(), active_transaction_id);
         for (const auto &record : records_to_delete)
         {
-            for (size_t i = 0; i < record.values.size(); i++)
+            if (!storage_manager->deleteRecord(db_name, table_name, record.rid))
             {
-                std::string display_value = record.values[i];
-                std::cout << std::left << std::setw(15) << display_value;
+                std::cerr << "Failed to delete record" << std::endl;
+                return false;
             }
-            std::cout << std::endl;
-        }
-        std::cout << "----------------------------------------" << std::endl;
 
-        // Get the data file path
-        std::string data_file = getTablePath(table_name);
+            if (!updateIndexEntries(table, &record, nullptr))
+            {
+                return false;
+            }
+        }
 
-        // Read all records first
-        std::vector<Record> all_records;
-        std::ifstream inFile(data_file, std::ios::binary);
-        if (!inFile)
+        if (!statement.commit())
         {
-            std::cerr << "Failed to open file: " << data_file << std::endl;
             return false;
         }
+        std::cout << "Records deleted successfully" << std::endl;
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Exception in Database::remove: " << e.what() << std::endl;
+        return false;
+    }
+}
 
-        // Get file size
-        inFile.seekg(0, std::ios::end);
-        size_t file_size = inFile.tellg();
-        inFile.seekg(0, std::ios::beg);
-
-        // Read all records from file
-        if (file_size > 0)
-        {
-            std::vector<char> buffer(file_size);
-            inFile.read(buffer.data(), file_size);
-
-            size_t pos = 0;
-            while (pos < file_size)
-            {
-                // Read record size
-                size_t record_size;
-                if (pos + sizeof(size_t) > file_size)
-                    break;
-                memcpy(&record_size, buffer.data() + pos, sizeof(size_t));
-
-                if (record_size == 0 || pos + record_size > file_size)
-                    break;
-
-                // Create new record and deserialize
-                Record record;
-
-                // Manual deserialization
-                size_t data_pos = pos + sizeof(size_t); // Skip record size
-
-                // Read number of values
-                size_t num_values;
-                memcpy(&num_values, buffer.data() + data_pos, sizeof(size_t));
-                data_pos += sizeof(size_t);
-
-                // Read values
-                for (size_t i = 0; i < num_values; i++)
-                {
-                    size_t str_len;
-                    memcpy(&str_len, buffer.data() + data_pos, sizeof(size_t));
-                    data_pos += sizeof(size_t);
-
-                    std::string value(buffer.data() + data_pos, str_len);
-                    record.values.push_back(value);
-                    data_pos += str_len;
-                }
+// Collects the rows WHERE selects, through the same access path a SELECT
+// would use; a null WHERE selects all
+bool Database::findMatchingRecords(TableInfo *table, Expression *where, std::vector<Record> &result)
+{
+    std::string error;
+    OperatorPtr scan;
+    if (!makePlanner().planScan(table, table->name, where, scan, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return false;
+    }
+    if (!scan->open())
+    {
+        return false;
+    }
+    Record record;
+    while (scan->next(record))
+    {
+        result.push_back(record);
+    }
+    scan->close();
+    return !scan->failed();
+}
 
-                all_records.push_back(record);
-                pos += record_size;
-            }
-        }
-        inFile.close();
+std::vector<const IndexInfo *> Database::uniqueIndexes(TableInfo *table)
+{
+    std::vector<const IndexInfo *> checks;
+    for (const auto &index : table->indexes)
+    {
+        if (!index.unique)
+            continue;
 
-        // Filter out records to delete
-        std::vector<Record> remaining_records;
-        for (const auto &record : all_records)
+        // A unique hash index answers the check in one bucket read
+        auto same_key = std::find_if(checks.begin(), checks.end(),
+                                     [&](const IndexInfo *other) { return other->columns == index.columns; });
+        if (same_key == checks.end())
         {
-            bool should_delete = false;
-            for (const auto &del_record : records_to_delete)
-            {
-                if (record.values == del_record.values)
-                {
-                    should_delete = true;
-                    break;
-                }
-            }
-
-            if (!should_delete)
-            {
-                remaining_records.push_back(record);
-            }
+            checks.push_back(&index);
         }
-
-        // Create temporary file and write remaining records
-        std::string temp_file = data_file + ".tmp";
-        std::ofstream outFile(temp_file, std::ios::binary);
-        if (!outFile)
+        else if (index.hash)
         {
-            std::cerr << "Failed to create temporary file: " << temp_file << std::endl;
-            return false;
+            *same_key = &index;
         }
+    }
+    return checks;
+}
 
-        // Write remaining records to the temporary file
-        for (const auto &record : remaining_records)
+// Keeps every index of the table in step with one row change; old_record
+// is null for an insert and new_record is null for a delete
+bool Database::updateIndexEntries(TableInfo *table, const Record *old_record, const Record *new_record)
+{
+    for (const auto &index : table->indexes)
+    {
+        std::string index_file = catalog_manager->getIndexPath(index);
+        IndexKey old_key = old_record ? columnValues(table, index.columns, *old_record) : IndexKey();
+        IndexKey new_key = new_record ? columnValues(table, index.columns, *new_record) : IndexKey();
+        IndexKey new_included = new_record ? columnValues(table, index.included, *new_record) : IndexKey();
+        if (old_record && new_record && compareKeys(old_key, new_key) == 0 &&
+            compareKeys(columnValues(table, index.included, *old_record), new_included) == 0 &&
+            old_record->rid == new_record->rid)
         {
-            // Calculate record size
-            size_t total_size = sizeof(size_t); // Size field itself
-            total_size += sizeof(size_t);       // Number of values
-
-            for (const auto &value : record.values)
-            {
-                total_size += sizeof(size_t); // String length
-                total_size += value.length(); // String content
-            }
-
-            // Create buffer
-            std::vector<char> buffer(total_size);
-            size_t pos = 0;
-
-            // Write total size first
-            memcpy(buffer.data() + pos, &total_size, sizeof(size_t));
-            pos += sizeof(size_t);
-
-            // Write number of values
-            size_t num_values = record.values.size();
-            memcpy(buffer.data() + pos, &num_values, sizeof(size_t));
-            pos += sizeof(size_t);
-
-            // Write all values
-            for (const auto &value : record.values)
-            {
-                // Write string length
-                size_t len = value.length();
-                memcpy(buffer.data() + pos, &len, sizeof(size_t));
-                pos += sizeof(size_t);
-
-                // Write string content
-                memcpy(buffer.data() + pos, value.c_str(), len);
-                pos += len;
-            }
-
-            // Write to file
-            outFile.write(buffer.data(), total_size);
+            continue;  // Same entry at the same location
         }
 
-        outFile.close();
-
-        // Replace original file with temporary file
-        if (std::remove(data_file.c_str()) != 0)
+        std::cout << "Updating index: " << index_file << std::endl;
+        if (old_record && !index_manager->remove(index_file, old_key, old_record->rid))
         {
-            std::cerr << "Failed to remove original file: " << data_file << std::endl;
-            std::remove(temp_file.c_str());
+            std::cerr << "Failed to update index: " << index_file << std::endl;
             return false;
         }
-
-        if (std::rename(temp_file.c_str(), data_file.c_str()) != 0)
+        if (new_record && !index_manager->insert(index_file, new_key, new_record->rid, new_included))
         {
-            std::cerr << "Failed to rename temporary file: " << temp_file << std::endl;
+            std::cerr << "Failed to update index: " << index_file << std::endl;
             return false;
         }
+    }
+    return true;
+}
 
-        // Rebuild all indexes
-        for (const auto &col : table->columns)
-        {
-            if (col.is_primary_key)
-            {
-                // Find column index
-                int col_index = -1;
-                for (size_t i = 0; i < table->columns.size(); i++)
-                {
-                    if (table->columns[i].name == col.name)
-                    {
-                        col_index = i;
-                        break;
-                    }
-                }
-
-                if (col_index >= 0)
-                {
-                    // Recreate index
-                    std::string index_file = db_name + "/" + table_name + "_" + col.name + ".idx";
-
-                    // Drop old index
-                    if (!index_manager->dropIndex(db_name, table_name, col.name))
-                    {
-                        std::cerr << "Failed to drop index for column: " << col.name << std::endl;
-                    }
-
-                    // Create new index
-                    if (!index_manager->createIndex(db_name, table_name, col.name))
-                    {
-                        std::cerr << "Failed to rebuild index for column: " << col.name << std::endl;
-                        return false;
-                    }
-
-                    // Rebuild index with remaining records
-                    for (const auto &record : remaining_records)
-                    {
-                        if (static_cast<size_t>(col_index) < record.values.size()) {
-                            try {
-                                int key = std::stoi(record.values[col_index]);
-                                if (!index_manager->insert(index_file, key, record)) {
-                                    std::cerr << "Failed to update index with key: " << key << std::endl;
-                                }
-                            }
-                            catch (...) {
-                                std::cerr << "Error parsing key for index" << std::endl;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        std::cout << "Records deleted successfully" << std::endl;
-        return true;
+void Database::printRecords(TableInfo *table, const std::vector<Record> &records)
+{
+    std::cout << "\nQuery Results (" << records.size() << " records):" << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+    for (const auto &col : table->columns)
+    {
+        std::cout << std::left << std::setw(15) << col.name;
     }
-    catch (const std::exception &e)
+    std::cout << std::endl;
+    std::cout << "----------------------------------------" << std::endl;
+    for (const auto &record : records)
     {
-        std::cerr << "Exception in Database::remove: " << e.what() << std::endl;
-        return false;
+        for (const auto &value : record.values)
+        {
+            std::cout << std::left << std::setw(15) << value;
+        }
+        std::cout << std::endl;
     }
+    std::cout << "----------------------------------------" << std::endl;
 }
 
 void updateRecord(Page &page, size_t offset, const Record &new_record)
@@ -1308,124 +958,6 @@ void removeRecord(Page &page, size_t offset, size_t record_size)
     page.setNumKeys(page.getNumKeys() - 1);
 }
 
-bool Database::selectUsingIndex(const std::string &table_name,
-                                const std::string &index_file,
-                                const std::string &op,
-                                const std::string &value,
-                                std::vector<Record> &result)
-{
-    try
-    {
-        // Add ./data/ prefix to index file path
-        std::string full_index_path = "./data/" + index_file;
-        std::cout << "Using index file: " << full_index_path << std::endl;
-
-        std::vector<int> matching_keys;
-        if (!index_manager->search(full_index_path, op, std::stoi(value), matching_keys))
-        {
-            std::cerr << "Index search failed" << std::endl;
-            return false;
-        }
-
-        std::cout << "Found " << matching_keys.size() << " matching keys" << std::endl;
-
-        // Retrieve records for matching keys
-        for (int key : matching_keys)
-        {
-            Record record;
-            if (storage_manager->getRecord(db_name, table_name, key, record))
-            {
-                result.push_back(record);
-                std::cout << "Added record with key " << key << " to results" << std::endl;
-            }
-        }
-
-        return true;
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Error in index search: " << e.what() << std::endl;
-        return false;
-    }
-}
-
-bool Database::selectUsingTableScan(const std::string &table_name,
-                                    int col_index,
-                                    const std::string &op,
-                                    const std::string &value,
-                                    std::vector<Record> &result)
-{
-    try
-    {
-        std::string data_file = getTablePath(table_name);
-        std::cout << "Performing table scan on: " << data_file << std::endl;
-
-        std::vector<Record> all_records = storage_manager->getAllRecords(data_file);
-
-        for (const Record &record : all_records)
-        {
-            if (col_index >= 0 && col_index < static_cast<int>(record.values.size()))
-            {
-                if (compareValues(record.values[col_index], value, op))
-                {
-                    result.push_back(record);
-                }
-            }
-        }
-
-        std::cout << "Found " << result.size() << " matching records" << std::endl;
-        return true;
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Error in table scan: " << e.what() << std::endl;
-        return false;
-    }
-}
-
-bool Database::compareValues(const std::string &record_value,
-                             const std::string &search_value,
-                             const std::string &op)
-{
-    try
-    {
-        // Try numeric comparison first
-        int record_num = std::stoi(record_value);
-        int search_num = std::stoi(search_value);
-
-        if (op == "=")
-            return record_num == search_num;
-        if (op == ">")
-            return record_num > search_num;
-        if (op == "<")
-            return record_num < search_num;
-        if (op == ">=")
-            return record_num >= search_num;
-        if (op == "<=")
-            return record_num <= search_num;
-        if (op == "!=")
-            return record_num != search_num;
-    }
-    catch (...)
-    {
-        // Fall back to string comparison
-        if (op == "=")
-            return record_value == search_value;
-        if (op == ">")
-            return record_value > search_value;
-        if (op == "<")
-            return record_value < search_value;
-        if (op == ">=")
-            return record_value >= search_value;
-        if (op == "<=")
-            return record_value <= search_value;
-        if (op == "!=")
-            return record_value != search_value;
-    }
-
-    return false;
-}
-
 // Helper method to get the full table path
 std::string Database::getTablePath(const std::string &table_name)
 {
@@ -1437,351 +969,31 @@ std::string getIndexPath(const std::string &db_name, const std::string &table_na
     return "./data/" + db_name + "/" + table_name + "_" + column_name + ".idx";
 }
 
-std::vector<Record> Database::join(
-    const std::string &left_table,
-    const std::string &right_table,
-    const std::string &left_column,
-    const std::string &right_column,
-    JoinType join_type)
-{
-
-    std::vector<Record> result;
-
-    try
-    {
-        // Get table info
-        TableInfo *left_info = catalog_manager->getTableInfo(left_table);
-        TableInfo *right_info = catalog_manager->getTableInfo(right_table);
-
-        if (!left_info || !right_info)
-        {
-            std::cerr << "One or both tables not found" << std::endl;
-            return result;
-        }
-
-        // Find join column indices
-        int left_col_idx = -1, right_col_idx = -1;
-        if (!findJoinColumns(left_info, right_info, left_column, right_column,
-                             left_col_idx, right_col_idx))
-        {
-            return result;
-        }
-
-        // Get all records from both tables
-        std::vector<Record> left_records = storage_manager->getAllRecords(getTablePath(left_table));
-        std::vector<Record> right_records = storage_manager->getAllRecords(getTablePath(right_table));
-
-        // Create hash table for right table records
-        std::unordered_multimap<std::string, Record> right_hash;
-        for (const auto &right_record : right_records)
-        {
-            right_hash.insert({right_record.values[right_col_idx], right_record});
-        }
-
-        // Perform join based on join type
-        for (const auto &left_record : left_records)
-        {
-            bool match_found = false;
-            auto range = right_hash.equal_range(left_record.values[left_col_idx]);
-
-            for (auto it = range.first; it != range.second; ++it)
-            {
-                // Create joined record
-                Record joined_record;
-                joined_record.values = left_record.values;
-                joined_record.values.insert(
-                    joined_record.values.end(),
-                    it->second.values.begin(),
-                    it->second.values.end());
-                result.push_back(joined_record);
-                match_found = true;
-            }
-
-            // Handle outer joins
-            if (!match_found && (join_type == JoinType::LEFT ||
-                                 join_type == JoinType::RIGHT))
-            {
-                Record joined_record;
-                joined_record.values = left_record.values;
-                // Add NULL values for right table
-                joined_record.values.insert(
-                    joined_record.values.end(),
-                    right_info->columns.size(),
-                    "NULL");
-                result.push_back(joined_record);
-            }
-        }
-
-        // Display results
-        if (!result.empty())
-        {
-            std::cout << "\nJoin Results (" << result.size() << " records):\n";
-            std::cout << "----------------------------------------\n";
-
-            // Print header
-            for (const auto &col : left_info->columns)
-            {
-                std::cout << std::setw(15) << std::left << (left_table + "." + col.name);
-            }
-            for (const auto &col : right_info->columns)
-            {
-                std::cout << std::setw(15) << std::left << (right_table + "." + col.name);
-            }
-            std::cout << "\n----------------------------------------\n";
-
-            // Print records
-            for (const auto &record : result)
-            {
-                for (const auto &value : record.values)
-                {
-                    std::cout << std::setw(15) << std::left << value;
-                }
-                std::cout << "\n";
-            }
-            std::cout << "----------------------------------------\n";
-        }
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Error in join: " << e.what() << std::endl;
+int Database::beginTransaction() {
+    if (active_transaction_id != -1) {
+        std::cerr << "Transaction " << active_transaction_id << " is already active" << std::endl;
+        return -1;
     }
-
-    return result;
+    active_transaction_id = transaction_manager->beginTransaction();
+    return active_transaction_id;
 }
 
-bool Database::findJoinColumns(
-    const TableInfo *left_table,
-    const TableInfo *right_table,
-    const std::string &left_column,
-    const std::string &right_column,
-    int &left_col_idx,
-    int &right_col_idx)
-{
-
-    // Find left column index
-    for (size_t i = 0; i < left_table->columns.size(); i++)
-    {
-        if (left_table->columns[i].name == left_column)
-        {
-            left_col_idx = i;
-            break;
-        }
-    }
-
-    // Find right column index
-    for (size_t i = 0; i < right_table->columns.size(); i++)
-    {
-        if (right_table->columns[i].name == right_column)
-        {
-            right_col_idx = i;
-            break;
-        }
-    }
-
-    if (left_col_idx == -1 || right_col_idx == -1)
-    {
-        std::cerr << "Join columns not found" << std::endl;
+bool Database::commitTransaction(int transaction_id) {
+    if (transaction_id != active_transaction_id) {
         return false;
     }
-
-    // Verify column types match
-    if (left_table->columns[left_col_idx].type !=
-        right_table->columns[right_col_idx].type)
-    {
-        std::cerr << "Join column types do not match" << std::endl;
+    active_transaction_id = -1;
+    if (!transaction_manager->commitTransaction(transaction_id)) {
         return false;
     }
-
+    recovery_manager->maybeCheckpoint();
     return true;
 }
 
-QueryClauses parseQueryClauses(const std::string& query) {
-    QueryClauses clauses;
-    std::istringstream iss(query);
-    std::string token;
-    
-    while (iss >> token) {
-        if (token == "GROUP" && iss >> token && token == "BY") {
-            iss >> clauses.group_by_column;
-        }
-        else if (token == "HAVING") {
-            std::getline(iss, clauses.having_condition);
-            // Remove leading/trailing whitespace
-            clauses.having_condition.erase(0, clauses.having_condition.find_first_not_of(" \t"));
-            clauses.having_condition.erase(clauses.having_condition.find_last_not_of(" \t") + 1);
-        }
-        else if (token == "ORDER" && iss >> token && token == "BY") {
-            iss >> clauses.order_by_column;
-            if (iss >> token && token == "DESC") {
-                clauses.order_asc = false;
-            }
-        }
-    }
-    return clauses;
-}
-
-bool Database::selectWithClauses(const std::string& table_name, const std::string& query) {
-    TableInfo* table = catalog_manager->getTableInfo(table_name);
-    if (!table) {
-        std::cerr << "Table not found: " << table_name << std::endl;
-        return false;
-    }
-
-    QueryClauses clauses = parseQueryClauses(query);
-    std::vector<Record> records;
-    std::string data_file = storage_manager->getTablePath(db_name, table_name);
-    
-    // Read all records
-    std::ifstream inFile(data_file, std::ios::binary);
-    if (!inFile) {
-        std::cerr << "Error opening table file" << std::endl;
-        return false;
-    }
-
-    // Read and process records
-    while (inFile) {
-        Page page;
-        if (!inFile.read(reinterpret_cast<char*>(&page), sizeof(Page))) {
-            break;
-        }
-
-        for (size_t i = 0; i < page.getNumRecords(); i++) {
-            Record record;
-            if (deserializeRecord(record, page.getData() + i * sizeof(Record), sizeof(Record))) {
-                records.push_back(record);
-            }
-        }
-    }
-
-    // Apply GROUP BY if specified
-    if (!clauses.group_by_column.empty()) {
-        std::unordered_map<std::string, std::vector<Record>> grouped_records;
-        int group_col_index = -1;
-        
-        // Find group by column index
-        for (size_t i = 0; i < table->columns.size(); i++) {
-            if (table->columns[i].name == clauses.group_by_column) {
-                group_col_index = i;
-                break;
-            }
-        }
-
-        if (group_col_index == -1) {
-            std::cerr << "Group by column not found: " << clauses.group_by_column << std::endl;
-            return false;
-        }
-
-        // Group records
-        for (const auto& record : records) {
-            grouped_records[record.values[group_col_index]].push_back(record);
-        }
-
-        // Apply HAVING clause if specified
-        if (!clauses.having_condition.empty()) {
-            std::istringstream having_iss(clauses.having_condition);
-            std::string agg_func, col_name, op, value;
-            having_iss >> agg_func >> col_name >> op >> value;
-
-            for (auto it = grouped_records.begin(); it != grouped_records.end();) {
-                bool keep_group = true;
-                if (agg_func == "COUNT") {
-                    int count = static_cast<int>(it->second.size());
-                    int threshold = std::stoi(value);
-                    if (op == ">" && count <= threshold) keep_group = false;
-                    else if (op == "<" && count >= threshold) keep_group = false;
-                    else if (op == "=" && count != threshold) keep_group = false;
-                }
-
-                if (!keep_group) {
-                    it = grouped_records.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-        }
-
-        // Display grouped results
-        for (const auto& group : grouped_records) {
-            std::cout << clauses.group_by_column << ": " << group.first << std::endl;
-            for (const auto& record : group.second) {
-                for (size_t i = 0; i < record.values.size(); i++) {
-                    std::cout << table->columns[i].name << ": " << record.values[i] << " ";
-                }
-                std::cout << std::endl;
-            }
-            std::cout << "---" << std::endl;
-        }
-    } else {
-        // Apply ORDER BY if specified
-        if (!clauses.order_by_column.empty()) {
-            int order_col_index = -1;
-            for (size_t i = 0; i < table->columns.size(); i++) {
-                if (table->columns[i].name == clauses.order_by_column) {
-                    order_col_index = i;
-                    break;
-                }
-            }
-
-            if (order_col_index != -1) {
-                std::sort(records.begin(), records.end(),
-                    [order_col_index, clauses](const Record& a, const Record& b) {
-                        if (clauses.order_asc) {
-                            return a.values[order_col_index] < b.values[order_col_index];
-                        } else {
-                            return a.values[order_col_index] > b.values[order_col_index];
-                        }
-                    });
-            }
-        }
-
-        // Display results
-        for (const auto& record : records) {
-            for (size_t i = 0; i < record.values.size(); i++) {
-                std::cout << table->columns[i].name << ": " << record.values[i] << " ";
-            }
-            std::cout << std::endl;
-        }
-    }
-
-    return true;
-}
-
-int Database::beginTransaction() {
-    return transaction_manager->beginTransaction();
-}
-
-bool Database::commitTransaction(int transaction_id) {
-    return transaction_manager->commitTransaction(transaction_id);
-}
-
 bool Database::abortTransaction(int transaction_id) {
-    return transaction_manager->abortTransaction(transaction_id);
-}
-
-bool Database::evaluateCondition(const Record& record, const std::string& condition) {
-    std::istringstream iss(condition);
-    std::string column, op, value;
-    iss >> column >> op;
-    std::getline(iss, value);
-    value = value.substr(value.find_first_not_of(" \t"));
-    
-    // Remove quotes if present
-    if (!value.empty() && (value[0] == '\'' || value[0] == '"')) {
-        value = value.substr(1, value.length() - 2);
-    }
-    
-    // Find column index
-    int col_index = -1;
-    for (size_t i = 0; i < record.values.size(); i++) {
-        if (catalog_manager->getColumnName(record.values[i], i) == column) {
-            col_index = i;
-            break;
-        }
-    }
-    
-    if (col_index == -1) {
+    if (transaction_id != active_transaction_id) {
         return false;
     }
-    
-    return compareValues(record.values[col_index], value, op);
+    active_transaction_id = -1;
+    return transaction_manager->abortTransaction(transaction_id);
 }
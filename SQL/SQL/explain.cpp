@@ -0,0 +1,74 @@
+#include "explain.h"
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+ProfileOperator::ProfileOperator(OperatorPtr child, BufferPool* buffer_pool)
+    : Operator(child->getSchema()), child(std::move(child)), buffer_pool(buffer_pool) {
+    estimated_rows = this->child->getEstimatedRows();
+}
+
+bool ProfileOperator::open() {
+    Measure measure(*this);
+    return child->open();
+}
+
+bool ProfileOperator::next(Record& row) {
+    Measure measure(*this);
+    if (!child->next(row)) {
+        return false;
+    }
+    profile.rows++;
+    return true;
+}
+
+void ProfileOperator::close() {
+    Measure measure(*this);
+    child->close();
+}
+
+ProfileOperator::Measure::Measure(ProfileOperator& owner)
+    : owner(owner), start(std::chrono::steady_clock::now()),
+      hits(owner.buffer_pool->getHits()), misses(owner.buffer_pool->getMisses()) {}
+
+ProfileOperator::Measure::~Measure() {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    owner.profile.milliseconds += elapsed.count();
+    owner.profile.buffer_hits += owner.buffer_pool->getHits() - hits;
+    owner.profile.pages_read += owner.buffer_pool->getMisses() - misses;
+}
+
+void profilePlan(OperatorPtr& root, BufferPool* buffer_pool) {
+    root->forEachChild([buffer_pool](OperatorPtr& child) { profilePlan(child, buffer_pool); });
+    root = std::make_unique<ProfileOperator>(std::move(root), buffer_pool);
+}
+
+namespace {
+    void printNode(Operator* node, int depth, std::ostream& out) {
+        std::ostringstream line;
+        if (depth > 0) {
+            line << std::string(depth * 4 - 4, ' ') << "  -> ";
+        }
+        line << node->describe() << "  (est. rows ";
+        if (node->getEstimatedRows() < 0) {
+            line << "?";
+        } else {
+            line << std::llround(node->getEstimatedRows());
+        }
+        line << ")";
+
+        if (auto* profiled = dynamic_cast<ProfileOperator*>(node)) {
+            const OperatorProfile& profile = profiled->getProfile();
+            line << " (actual rows " << profile.rows << ", time " << std::fixed << std::setprecision(3)
+                 << profile.milliseconds << " ms, pages read " << profile.pages_read << ", buffer hits "
+                 << profile.buffer_hits << ")";
+        }
+        out << line.str() << "\n";
+
+        node->forEachChild([depth, &out](OperatorPtr& child) { printNode(child.get(), depth + 1, out); });
+    }
+}
+
+void printPlan(Operator* root, std::ostream& out) {
+    printNode(root, 0, out);
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include "value.h"
+#include "record.h"
+#include "catalog_manager.h"
+
+// One output column of a row source. Rows produced by a scan or join are
+// laid out in schema order, so a bound column is just an index into
+// Record::values.
+struct SchemaColumn {
+    std::string table;  // table name or alias, empty for computed columns
+    std::string name;
+    std::string alias;  // AS name given in the select list, if any
+};
+using Schema = std::vector<SchemaColumn>;
+
+enum class ExpressionType {
+    LITERAL,
+    COLUMN,
+    COMPARISON,  // op holds =, !=, <>, <, >, <=, >=
+    AND,
+    OR,
+    NOT,
+    AGGREGATE,   // name holds COUNT, SUM, AVG, MIN or MAX; no child for COUNT(*)
+    STAR
+};
+
+struct Expression;
+using ExpressionPtr = std::unique_ptr<Expression>;
+
+// Node of a parsed expression. bind() resolves column references against a
+// schema once per query; evaluation then reads values by index and never
+// looks at names or text again.
+struct Expression {
+    ExpressionType type = ExpressionType::LITERAL;
+    Value value;          // LITERAL
+    std::string table;    // COLUMN: optional qualifier
+    std::string name;     // COLUMN: column name, AGGREGATE: function
+    std::string op;       // COMPARISON
+    std::vector<ExpressionPtr> children;
+    int column_index = -1;  // set by bind(); the value is read from the row
+
+    static ExpressionPtr makeLiteral(const Value& value);
+    static ExpressionPtr makeColumn(const std::string& table, const std::string& name);
+    static ExpressionPtr makeComparison(const std::string& op, ExpressionPtr left, ExpressionPtr right);
+    static ExpressionPtr makeLogical(ExpressionType type, ExpressionPtr left, ExpressionPtr right);
+    static ExpressionPtr makeNot(ExpressionPtr child);
+    static ExpressionPtr makeAggregate(const std::string& function, ExpressionPtr argument);
+    ExpressionPtr clone() const;
+
+    // Canonical SQL text; also names aggregate output columns
+    std::string toString() const;
+    bool containsAggregate() const;
+    // Aggregates in this tree, outermost first, without duplicates
+    void collectAggregates(std::vector<Expression*>& aggregates);
+
+    // Resolves columns, and any subtree whose text names a schema column
+    // (e.g. SUM(x) over an aggregate's output); false with a message on an
+    // unknown or ambiguous name
+    bool bind(const Schema& schema, std::string& error);
+    Value evaluate(const Record& row) const;
+    // SQL truth: comparisons involving NULL are false
+    bool isTrue(const Record& row) const;
+};
+
+enum class JoinType {
+    INNER,
+    LEFT,
+    RIGHT,
+    FULL
+};
+
+struct TableRef {
+    std::string name;
+    std::string alias;
+
+    const std::string& qualifier() const { return alias.empty() ? name : alias; }
+};
+
+struct SelectItem {
+    ExpressionPtr expression;  // STAR for *
+    std::string alias;
+};
+
+struct JoinClause {
+    JoinType type = JoinType::INNER;
+    TableRef table;
+    ExpressionPtr condition;
+};
+
+struct OrderItem {
+    ExpressionPtr expression;
+    bool ascending = true;
+};
+
+struct SelectStatement {
+    std::vector<SelectItem> items;
+    TableRef from;
+    std::vector<JoinClause> joins;
+    ExpressionPtr where;
+    std::vector<ExpressionPtr> group_by;
+    ExpressionPtr having;
+    std::vector<OrderItem> order_by;
+    int64_t limit = -1;  // -1 without LIMIT
+    int64_t offset = 0;  // rows skipped before the LIMIT ones
+    // Expressions the planner derives from the ones above, e.g. join
+    // conditions regrouped for another join order; kept here because the
+    // plan is bound to them
+    std::vector<ExpressionPtr> planned;
+};
+
+struct InsertStatement {
+    std::string table;
+    std::vector<std::vector<Value>> rows;
+};
+
+struct Assignment {
+    std::string column;
+    Value value;
+};
+
+struct UpdateStatement {
+    std::string table;
+    std::vector<Assignment> assignments;
+    ExpressionPtr where;  // null updates every row
+};
+
+struct DeleteStatement {
+    std::string table;
+    ExpressionPtr where;  // null deletes every row
+};
+
+struct CreateTableStatement {
+    std::string table;
+    std::vector<ColumnInfo> columns;
+};
+
+struct CreateIndexStatement {
+    std::string table;
+    std::vector<std::string> columns;
+    std::vector<std::string> included;  // INCLUDE (...) columns
+    bool hash = false;  // USING HASH
+};
+
+enum class StatementType {
+    SELECT,
+    INSERT,
+    UPDATE,
+    DELETE,
+    CREATE_DATABASE,
+    USE_DATABASE,
+    DROP_DATABASE,
+    CREATE_TABLE,
+    DROP_TABLE,
+    CREATE_INDEX,
+    ANALYZE,
+    EXPLAIN,
+    BEGIN,
+    COMMIT,
+    ROLLBACK,
+    HELP,
+    EXIT
+};
+
+struct Statement {
+    StatementType type = StatementType::HELP;
+    std::string name;  // database or table for the CREATE/USE/DROP forms
+    SelectStatement select;      // also the query of EXPLAIN
+    bool explain_analyze = false;  // EXPLAIN ANALYZE runs the query
+    InsertStatement insert;
+    UpdateStatement update;
+    DeleteStatement remove;
+    CreateTableStatement create_table;
+    CreateIndexStatement create_index;
+};
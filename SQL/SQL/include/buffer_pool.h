@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "page.h"
+#include "log_manager.h"
+
+const size_t DEFAULT_BUFFER_POOL_FRAMES = 1024;  // 1024 frames of 4KB pages
+
+// Fixed-size cache of pages shared by every table and index file.
+// Pages are pinned while in use and written back lazily when a dirty
+// frame is evicted (CLOCK replacement) or flushed explicitly. Only the
+// PAGE_SIZE_BYTES data area of a Page is stored on disk. With a log
+// manager attached, the log is forced up to a page's LSN before the page
+// itself is written (write-ahead rule).
+class BufferPool {
+public:
+    explicit BufferPool(size_t num_frames = DEFAULT_BUFFER_POOL_FRAMES);
+    ~BufferPool();
+
+    // Pins the page, reading it from disk on a miss. Returns nullptr if the
+    // page is past the end of the file or every frame is pinned.
+    Page* fetchPage(const std::string& filename, int page_id);
+    // Pins a frame for a page that is about to be overwritten in full,
+    // skipping the disk read. The frame is zeroed on a miss.
+    Page* newPage(const std::string& filename, int page_id);
+    bool unpinPage(const std::string& filename, int page_id, bool is_dirty);
+
+    bool flushPage(const std::string& filename, int page_id);
+    bool flushFile(const std::string& filename);
+    bool flushAll();
+    // Writes back pages dirty since before lsn; checkpoints use it to keep
+    // the redo starting point recent
+    bool flushPagesOlderThan(lsn_t lsn);
+    // Dirty page table for checkpoints
+    std::vector<DirtyPageEntry> getDirtyPages();
+    // Forgets every cached page of the file without writing it back and
+    // closes its handle; call before the file is removed or truncated
+    void discardFile(const std::string& filename);
+    void discardAll();
+
+    void setLogManager(LogManager* manager) { log_manager = manager; }
+
+    size_t getNumFrames() const { return frames.size(); }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+private:
+    struct Frame {
+        Page page;
+        std::string filename;
+        int page_id = -1;
+        int pin_count = 0;
+        bool is_dirty = false;
+        bool referenced = false;
+        lsn_t rec_lsn = INVALID_LSN;  // log position when the frame was last clean
+    };
+
+    std::vector<Frame> frames;
+    std::unordered_map<std::string, size_t> page_table;  // "file#page" -> frame
+    std::unordered_map<std::string, std::unique_ptr<std::fstream>> open_files;
+    LogManager* log_manager;
+    size_t clock_hand;
+    size_t hits;
+    size_t misses;
+    std::mutex latch;
+
+    static std::string normalize(const std::string& filename);
+    static std::string frameKey(const std::string& filename, int page_id);
+
+    lsn_t currentLSN() const;
+    Page* pinFrame(const std::string& filename, int page_id, bool read_from_disk);
+    int findVictim();
+    bool writeFrame(Frame& frame);
+    std::fstream* getFile(const std::string& filename);
+    void closeFile(const std::string& filename);
+};
@@ -3,7 +3,9 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <iosfwd>
 #include "page.h"
+#include "statistics.h"
 
 // Forward declarations
 struct ColumnInfo {
@@ -18,14 +20,34 @@ struct ColumnInfo {
     ColumnInfo() : size(0), is_primary_key(false), is_foreign_key(false) {}
 };
 
+// A B+ tree or hash index over one or more columns, stored in the
+// database directory as name ("<table>_<column>[_<column>...].idx", or
+// ".hash.idx" for a hash index). B+ tree keys order by the first column,
+// then the next; a hash index only finds whole keys. Primary keys get a
+// unique B+ tree index. Included columns are stored in the entries but
+// are not part of the key.
+struct IndexInfo {
+    std::string name;
+    std::vector<std::string> columns;
+    std::vector<std::string> included;
+    bool unique;
+    bool hash;
+
+    IndexInfo() : unique(false), hash(false) {}
+};
+
+std::string indexFileName(const std::string& table_name, const std::vector<std::string>& columns,
+                          bool hash = false);
+
 struct TableInfo {
     std::string name;
     std::vector<ColumnInfo> columns;
     std::string data_file;
-    std::vector<std::string> index_files;
+    std::vector<IndexInfo> indexes;
     std::string primary_key_column;  // Store the name of primary key column
     std::string primary_key;
     std::vector<std::string> foreign_keys;
+    TableStats stats;  // filled in by ANALYZE
 };
 
 class CatalogManager {
@@ -36,18 +58,24 @@ public:
     bool createTable(const std::string& table_name, 
                     const std::vector<ColumnInfo>& columns);
     bool dropTable(const std::string& table_name);
-    bool addIndex(const std::string& table_name, 
-                 const std::string& column_name);
+    // False if the table is missing or already has an index of the same
+    // kind on the same columns
+    bool addIndex(const std::string& table_name, const IndexInfo& index);
     bool removeIndex(const std::string& table_name, 
-                    const std::string& column_name);
+                    const std::vector<std::string>& columns,
+                    bool hash = false);
     TableInfo* getTableInfo(const std::string& table_name);
     bool validateForeignKeyReference(const std::string& foreign_table,
                                    const std::string& foreign_column,
                                    const std::string& primary_table,
                                    const std::string& primary_column);
     bool tableExists(const std::string& table_name) const;
+    // Replaces the statistics of a table and saves the catalog
+    bool setTableStats(const std::string& table_name, const TableStats& stats);
     const TableInfo* getTableInfo(const std::string& table_name) const;
     std::string getColumnName(const std::string& table_name, int column_index) const;
+    // Path of an index file of this database
+    std::string getIndexPath(const IndexInfo& index) const;
     bool saveCatalog() const;
     bool loadCatalog();
     void printCatalog() const;
@@ -58,4 +86,8 @@ private:
     std::unordered_map<std::string, TableInfo> tables;
     
     std::string getCatalogPath() const;
+    void saveTableStats(std::ostream& file, const TableStats& stats) const;
+    bool loadTableStats(std::istream& file, TableInfo& table);
+    void saveIndexes(std::ostream& file, const TableInfo& table) const;
+    bool loadIndexes(std::istream& file, TableInfo& table, int version);
 };
\ No newline at end of file
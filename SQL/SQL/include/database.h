@@ -11,24 +11,20 @@
 #include "index_manager.h"
 #include "page.h"
 #include "transaction_manager.h"
+#include "log_manager.h"
+#include "recovery_manager.h"
 #include "record.h"
-
-// Forward declarations
-struct QueryClauses {
-    std::string group_by_column;
-    std::string having_condition;
-    std::string order_by_column;
-    bool order_asc = true;
-};
-
-QueryClauses parseQueryClauses(const std::string& query);
+#include "value.h"
+#include "ast.h"
+#include "planner.h"
 
 class Database {
 public:
     Database(const std::string& name);
     ~Database();
 
-    // Transaction management
+    // Transaction management. Writes outside an explicit transaction are
+    // committed (or rolled back) statement by statement.
     int beginTransaction();
     bool commitTransaction(int transaction_id);
     bool abortTransaction(int transaction_id);
@@ -36,64 +32,55 @@ public:
     bool createTable(const std::string& table_name, const std::vector<ColumnInfo>& columns);
     bool dropTable(const std::string& table_name);
     bool insert(const std::string& table_name, const std::vector<std::string>& values);
-    std::vector<Record> select(const std::string& table_name, const std::string& where_clause = "");
-    bool selectWithCondition(const std::string& table_name, const std::string& column_name,
-                            const std::string& op, const std::string& value,
-                            std::vector<Record>& result);
-    bool update(const std::string& table_name, const std::string& set_clause,
-                const std::string& where_clause);
-    bool remove(const std::string& table_name, const std::string& where_clause);
+    bool insert(const std::string& table_name, const std::vector<Value>& values);
+    bool update(const std::string& table_name, const std::vector<Assignment>& assignments,
+                Expression* where);
+    bool remove(const std::string& table_name, Expression* where);
     int getColumnIndex(TableInfo* table, const std::string& col_name);
 
-    // Select methods
-    bool selectWithClauses(const std::string& table_name, const std::string& query);
-    std::vector<Record> groupQuery(const std::string& table_name, const std::string& group_column,
-                                  const std::string& agg_function, const std::string& where_clause,
-                                  const std::string& having_clause);
-
-    bool createIndex(const std::string& table_name, const std::string& column_name);
+    // Runs a parsed SELECT and prints its result set
+    bool executeSelect(SelectStatement& query);
+    // Prints the plan of query; with analyze the query is run (its rows
+    // are discarded) and each operator reports what it measured
+    bool explainSelect(SelectStatement& query, bool analyze);
+
+    // included lists the INCLUDE columns stored alongside each key; hash
+    // builds a hash index, for equality lookups only
+    bool createIndex(const std::string& table_name, const std::vector<std::string>& columns,
+                     const std::vector<std::string>& included = {}, bool hash = false);
+    // Gathers optimizer statistics for a table into the catalog
+    bool analyze(const std::string& table_name);
     bool dropIndex(const std::string& table_name, const std::string& column_name);
-    bool dropDatabase(const std::string& db_name);  // database.h
-    // Join types enum
-    enum class JoinType {
-        INNER,
-        LEFT,
-        RIGHT
-    };
-
-    // Join method
-    std::vector<Record> join(const std::string& left_table, const std::string& right_table,
-                            const std::string& left_column, const std::string& right_column,
-                            JoinType join_type = JoinType::INNER);
+    bool dropDatabase(const std::string& db_name);  // database.h
 
 private:
     std::string db_name;
     std::string data_path;
     std::unique_ptr<CatalogManager> catalog_manager;
+    std::unique_ptr<LogManager> log_manager;  // declared first: outlives the buffer pool
     std::unique_ptr<StorageManager> storage_manager;
     std::unique_ptr<IndexManager> index_manager;
+    std::unique_ptr<RecoveryManager> recovery_manager;
     std::unique_ptr<TransactionManager> transaction_manager;
+    int active_transaction_id;  // BEGIN TRANSACTION in progress, or -1
     
     void reloadCatalog();
     bool cleanup();
-
-    bool selectUsingIndex(const std::string& table_name, const std::string& index_file,
-                         const std::string& op, const std::string& value,
-                         std::vector<Record>& result);
-
-    bool selectUsingTableScan(const std::string& table_name, int col_index,
-                             const std::string& op, const std::string& value,
-                             std::vector<Record>& result);
-
-    bool compareValues(const std::string& record_value, const std::string& search_value,
-                      const std::string& op);
+    // Rebuilds index files that are missing or in an older format
+    void rebuildIndexes();
+    bool buildIndex(TableInfo* table, const IndexInfo& index);
+    IndexKey columnValues(TableInfo* table, const std::vector<std::string>& columns, const Record& record);
+
+    Planner makePlanner();
+
+    // DML helpers: locate rows by RID and patch indexes row by row
+    bool insertRecord(TableInfo* table, Record& record);
+    bool findMatchingRecords(TableInfo* table, Expression* where, std::vector<Record>& result);
+    bool updateIndexEntries(TableInfo* table, const Record* old_record, const Record* new_record);
+    // The indexes duplicate keys are checked against: one unique index per
+    // key, the hash index where a key has one
+    std::vector<const IndexInfo*> uniqueIndexes(TableInfo* table);
+    void printRecords(TableInfo* table, const std::vector<Record>& records);
 
     std::string getTablePath(const std::string& table_name);
-
-    // Helper methods for join
-    bool findJoinColumns(const TableInfo* left_table, const TableInfo* right_table,
-                        const std::string& left_column, const std::string& right_column,
-                        int& left_col_idx, int& right_col_idx);
-
-    bool evaluateCondition(const Record& record, const std::string& condition);
 }; 
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include "operators.h"
+#include "buffer_pool.h"
+
+// What EXPLAIN ANALYZE measured for one operator. Time and page counts
+// include the operator's inputs, so the root accounts for the whole query.
+struct OperatorProfile {
+    size_t rows = 0;
+    double milliseconds = 0;
+    size_t pages_read = 0;   // buffer pool misses, i.e. pages read from disk
+    size_t buffer_hits = 0;  // page requests served from the buffer pool
+};
+
+// Transparent wrapper that measures open(), next() and close() of the
+// operator it wraps. It describes itself and its inputs as the wrapped
+// operator does, so a profiled plan prints like the original one.
+class ProfileOperator : public Operator {
+public:
+    ProfileOperator(OperatorPtr child, BufferPool* buffer_pool);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override { return child->describe(); }
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { child->forEachChild(visit); }
+    bool failed() override { return child->failed(); }
+
+    const OperatorProfile& getProfile() const { return profile; }
+
+private:
+    OperatorPtr child;
+    BufferPool* buffer_pool;
+    OperatorProfile profile;
+
+    // Adds the time and page requests since the start of a call
+    class Measure {
+    public:
+        explicit Measure(ProfileOperator& owner);
+        ~Measure();
+
+    private:
+        ProfileOperator& owner;
+        std::chrono::steady_clock::time_point start;
+        size_t hits;
+        size_t misses;
+    };
+};
+
+// Wraps every operator of the plan in a ProfileOperator
+void profilePlan(OperatorPtr& root, BufferPool* buffer_pool);
+
+// Prints the plan as an indented tree, one operator per line with its
+// estimated rows and, for a profiled plan, what was measured
+void printPlan(Operator* root, std::ostream& out);
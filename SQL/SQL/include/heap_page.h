@@ -0,0 +1,209 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "page.h"
+
+// Slotted-page layout used by table (.dat) files:
+//
+//   [page LSN][num_slots][free_space_end][slot 0][slot 1]...  free  ...[tuple 1][tuple 0]
+//
+// The slot directory grows forward from the header and tuples grow backward
+// from the end of the page. A slot with offset 0 is empty; its number may be
+// reused by a later insert on the same page.
+class HeapPage {
+public:
+    struct Slot {
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    static constexpr size_t HEADER_SIZE = PAGE_LSN_SIZE + 2 * sizeof(uint16_t);
+    static constexpr size_t MAX_TUPLE_SIZE = PAGE_SIZE_BYTES - HEADER_SIZE - sizeof(Slot);
+
+    explicit HeapPage(Page& page) : page(page) {}
+
+    void init() {
+        page.clear();
+        setNumSlots(0);
+        setFreeSpaceEnd(PAGE_SIZE_BYTES);
+    }
+
+    // Pages handed out zeroed by the buffer pool have not been initialized yet
+    bool isInitialized() const { return getFreeSpaceEnd() != 0; }
+
+    uint16_t getNumSlots() const { return readU16(PAGE_LSN_SIZE); }
+
+    // Contiguous bytes between the slot directory and the tuple area
+    size_t getFreeSpace() const {
+        size_t directory_end = HEADER_SIZE + getNumSlots() * sizeof(Slot);
+        return getFreeSpaceEnd() > directory_end ? getFreeSpaceEnd() - directory_end : 0;
+    }
+
+    bool isLive(int slot) const {
+        return slot >= 0 && slot < getNumSlots() && getSlot(slot).offset != 0;
+    }
+
+    // Returns the slot number, or -1 if the tuple does not fit on this page
+    int insertTuple(const char* data, size_t size) {
+        if (size == 0 || size > MAX_TUPLE_SIZE) {
+            return -1;
+        }
+
+        int slot = findEmptySlot();
+        size_t needed = size + (slot == -1 ? sizeof(Slot) : 0);
+        if (getFreeSpace() < needed) {
+            if (getReclaimableSpace() < needed) {
+                return -1;
+            }
+            compact();
+        }
+
+        if (slot == -1) {
+            slot = getNumSlots();
+            setNumSlots(slot + 1);
+        }
+
+        uint16_t offset = static_cast<uint16_t>(getFreeSpaceEnd() - size);
+        page.writeData(offset, data, size);
+        setFreeSpaceEnd(offset);
+        setSlot(slot, {offset, static_cast<uint16_t>(size)});
+        return slot;
+    }
+
+    bool getTuple(int slot, const char*& data, size_t& size) const {
+        if (!isLive(slot)) {
+            return false;
+        }
+        Slot s = getSlot(slot);
+        data = page.getData() + s.offset;
+        size = s.length;
+        return true;
+    }
+
+    // Rewrites the tuple under the same slot number. Returns false if the
+    // new version does not fit on this page; the old version is kept then.
+    bool updateTuple(int slot, const char* data, size_t size) {
+        if (!isLive(slot) || size == 0 || size > MAX_TUPLE_SIZE) {
+            return false;
+        }
+
+        Slot s = getSlot(slot);
+        if (size <= s.length) {
+            page.writeData(s.offset, data, size);
+            setSlot(slot, {s.offset, static_cast<uint16_t>(size)});
+            return true;
+        }
+
+        if (getReclaimableSpace() + s.length < size) {
+            return false;
+        }
+
+        // Free the old version, then place the new one like an insert
+        std::vector<char> old_tuple(page.getData() + s.offset, page.getData() + s.offset + s.length);
+        setSlot(slot, {0, 0});
+        if (getFreeSpace() < size) {
+            compact();
+        }
+        if (getFreeSpace() < size) {
+            // Cannot happen given the check above, but never lose the old tuple
+            uint16_t offset = static_cast<uint16_t>(getFreeSpaceEnd() - old_tuple.size());
+            page.writeData(offset, old_tuple.data(), old_tuple.size());
+            setFreeSpaceEnd(offset);
+            setSlot(slot, {offset, static_cast<uint16_t>(old_tuple.size())});
+            return false;
+        }
+
+        uint16_t offset = static_cast<uint16_t>(getFreeSpaceEnd() - size);
+        page.writeData(offset, data, size);
+        setFreeSpaceEnd(offset);
+        setSlot(slot, {offset, static_cast<uint16_t>(size)});
+        return true;
+    }
+
+    bool deleteTuple(int slot) {
+        if (!isLive(slot)) {
+            return false;
+        }
+        setSlot(slot, {0, 0});
+
+        // Trailing empty slots can be dropped from the directory
+        uint16_t num_slots = getNumSlots();
+        while (num_slots > 0 && getSlot(num_slots - 1).offset == 0) {
+            num_slots--;
+        }
+        setNumSlots(num_slots);
+        return true;
+    }
+
+    // Slides live tuples to the end of the page so all free space is contiguous
+    void compact() {
+        struct Entry { int slot; Slot s; };
+        std::vector<Entry> live;
+        for (int i = 0; i < getNumSlots(); i++) {
+            Slot s = getSlot(i);
+            if (s.offset != 0) {
+                live.push_back({i, s});
+            }
+        }
+
+        // Move tuples nearest the end first so memmove never clobbers one
+        std::sort(live.begin(), live.end(),
+                  [](const Entry& a, const Entry& b) { return a.s.offset > b.s.offset; });
+
+        size_t end = PAGE_SIZE_BYTES;
+        for (const auto& entry : live) {
+            end -= entry.s.length;
+            page.moveData(end, entry.s.offset, entry.s.length);
+            setSlot(entry.slot, {static_cast<uint16_t>(end), entry.s.length});
+        }
+        setFreeSpaceEnd(static_cast<uint16_t>(end));
+    }
+
+private:
+    Page& page;
+
+    uint16_t readU16(size_t offset) const {
+        uint16_t value = 0;
+        page.readData(offset, &value, sizeof(uint16_t));
+        return value;
+    }
+
+    void writeU16(size_t offset, uint16_t value) {
+        page.writeData(offset, &value, sizeof(uint16_t));
+    }
+
+    uint16_t getFreeSpaceEnd() const { return readU16(PAGE_LSN_SIZE + sizeof(uint16_t)); }
+
+    void setNumSlots(uint16_t num_slots) { writeU16(PAGE_LSN_SIZE, num_slots); }
+    void setFreeSpaceEnd(uint16_t offset) { writeU16(PAGE_LSN_SIZE + sizeof(uint16_t), offset); }
+
+    Slot getSlot(int slot) const {
+        Slot s = {0, 0};
+        page.readData(HEADER_SIZE + slot * sizeof(Slot), &s, sizeof(Slot));
+        return s;
+    }
+
+    void setSlot(int slot, const Slot& s) {
+        page.writeData(HEADER_SIZE + slot * sizeof(Slot), &s, sizeof(Slot));
+    }
+
+    int findEmptySlot() const {
+        for (int i = 0; i < getNumSlots(); i++) {
+            if (getSlot(i).offset == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Free bytes on the page including holes left by deleted or shrunk tuples
+    size_t getReclaimableSpace() const {
+        size_t used = HEADER_SIZE + getNumSlots() * sizeof(Slot);
+        for (int i = 0; i < getNumSlots(); i++) {
+            used += getSlot(i).length;
+        }
+        return PAGE_SIZE_BYTES - used;
+    }
+};
@@ -1,57 +1,104 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <vector>
 #include "storage_manager.h"
 #include "catalog_manager.h"
 
-// Simple index record structure
-struct IndexRecord {
-    int key;
-    int page_id;
+// Key of an index entry, one value per indexed column
+using IndexKey = std::vector<Value>;
+
+// Orders keys column by column; a key that is a prefix of another sorts
+// before it
+int compareKeys(const IndexKey& key, const IndexKey& other);
+// Compares only the first prefix.size() values of key with prefix
+int compareKeyPrefix(const IndexKey& key, const IndexKey& prefix);
+
+// A key and the location of its row. Leaf entries of an index with
+// INCLUDE columns also carry those columns' values, so a query reading
+// only key and included columns never has to visit the heap. Internal
+// nodes keep whole entries (without included values) as separators, so
+// equal keys of a non-unique index still have one order.
+struct IndexEntry {
+    IndexKey key;
+    IndexKey included;
+    RID rid;
 };
 
+// Bounds on an index key; a missing bound leaves that side open. A bound
+// may cover only the leading columns of a composite key: low (5) and high
+// (5) select every key starting with 5, low (5, 10) and high (5) the keys
+// (5, b) with b >= 10.
+struct KeyRange {
+    bool has_low = false;
+    bool low_inclusive = true;
+    IndexKey low;
+    bool has_high = false;
+    bool high_inclusive = true;
+    IndexKey high;
+
+    bool contains(const IndexKey& key) const {
+        if (has_low) {
+            int c = compareKeyPrefix(key, low);
+            if (c < 0 || (c == 0 && !low_inclusive)) return false;
+        }
+        return !isPastEnd(key);
+    }
+    // True once key is past the upper bound, so no later key can match
+    bool isPastEnd(const IndexKey& key) const {
+        if (!has_high) return false;
+        int c = compareKeyPrefix(key, high);
+        return c > 0 || (c == 0 && !high_inclusive);
+    }
+};
+
+// B+ tree and hash indexes over columns of any type. Both hold one (key,
+// row location) entry per row, so a non-unique index keeps duplicate keys
+// as separate entries ordered by location. Keys with a NULL are not
+// indexed. Operations on a hash index (told apart by its file name) only
+// answer equality on the whole key: search with "=", and scanRange or
+// scanEntries with a range of one key.
 class IndexManager {
 public:
     IndexManager(StorageManager* storage_manager);
     ~IndexManager();
 
+    // A unique index refuses a second entry for a key
     bool createIndex(const std::string& db_name,
                     const std::string& table_name,
-                    const std::string& column_name);
+                    const std::vector<std::string>& columns,
+                    bool unique = false,
+                    bool hash = false);
+    // Creates the index and fills it with the entries next produces, in
+    // any order, until it returns false. For a B+ tree the entries are
+    // sorted, through run files on disk once they outgrow memory, and the
+    // tree is written bottom-up with full nodes, each page once.
+    bool bulkLoad(const std::string& db_name,
+                  const std::string& table_name,
+                  const std::vector<std::string>& columns,
+                  bool unique,
+                  bool hash,
+                  const std::function<bool(IndexEntry&)>& next);
     bool dropIndex(const std::string& db_name,
                   const std::string& table_name,
-                  const std::string& column_name);
-    bool insert(const std::string& index_file, int key, const Record& record);
-    bool exists(const std::string& index_file, int key);
-    std::vector<Record> search(const std::string& index_file, int key);
-    bool search(const std::string& index_file,
-                const std::string& op,
-                int value,
-                std::vector<int>& result);
-    bool remove(const std::string& index_file, int key);
+                  const std::vector<std::string>& columns,
+                  bool hash = false);
+    bool insert(const std::string& index_file, const IndexKey& key, const RID& rid,
+                const IndexKey& included = IndexKey());
+    bool exists(const std::string& index_file, const IndexKey& key);
+    // Fetches the location of the first row stored with key
+    bool lookup(const std::string& index_file, const IndexKey& key, RID& rid);
+    // Locations of the rows whose key is in range, in key order. Seeks to
+    // the leaf of the lower bound and walks the leaf chain up to the upper
+    // bound, so only the qualifying leaves are read.
+    bool scanRange(const std::string& index_file, const KeyRange& range, std::vector<RID>& result);
+    // The entries in range themselves, with their keys and included values
+    bool scanEntries(const std::string& index_file, const KeyRange& range, std::vector<IndexEntry>& result);
+    // Removes the entry of the row at rid. True once no such entry is
+    // left, including when there was none; false only on an error.
+    bool remove(const std::string& index_file, const IndexKey& key, const RID& rid);
+    bool isValidIndex(const std::string& index_file);
 
 private:
     StorageManager* storage_manager;
-    
-    // Helper methods
-    bool writeIndexRecord(const std::string& index_name, const IndexRecord& record);
-    bool readIndexRecords(const std::string& index_name, std::vector<IndexRecord>& records);
-    void sortIndexRecords(std::vector<IndexRecord>& records);
-    void searchEqual(const std::vector<IndexRecord>& records,
-                    int value,
-                    std::vector<int>& result);
-    
-    void searchGreaterThan(const std::vector<IndexRecord>& records,
-                          int value,
-                          std::vector<int>& result,
-                          bool include_equal);
-    
-    void searchLessThan(const std::vector<IndexRecord>& records,
-                       int value,
-                       std::vector<int>& result,
-                       bool include_equal);
-    
-    void searchNotEqual(const std::vector<IndexRecord>& records,
-                       int value,
-                       std::vector<int>& result);
-};
\ No newline at end of file
+};
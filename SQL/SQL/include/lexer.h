@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+
+enum class TokenType {
+    IDENTIFIER,  // names and keywords; keywords are matched on the upper-case form
+    INTEGER,
+    FLOAT,
+    STRING,      // quotes removed, '' unescaped
+    OPERATOR,    // = != <> < > <= >= + -
+    COMMA,
+    DOT,
+    LPAREN,
+    RPAREN,
+    STAR,
+    SEMICOLON,
+    END
+};
+
+struct Token {
+    TokenType type;
+    std::string text;   // as written (strings without their quotes)
+    std::string upper;  // upper-case text, for keyword comparisons
+    size_t position;    // offset in the statement, for error messages
+
+    bool isKeyword(const char* keyword) const {
+        return type == TokenType::IDENTIFIER && upper == keyword;
+    }
+};
+
+// Splits one line of SQL into tokens in a single pass
+class Lexer {
+public:
+    explicit Lexer(const std::string& input);
+
+    // Returns false with a message in error on an unterminated string or a
+    // character that cannot start a token
+    bool tokenize(std::vector<Token>& tokens, std::string& error);
+
+private:
+    const std::string& input;
+    size_t pos;
+
+    void addToken(std::vector<Token>& tokens, TokenType type, const std::string& text, size_t start);
+};
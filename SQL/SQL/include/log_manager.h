@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+
+// Log sequence numbers are byte offsets into the log as if it had never
+// been cut: the file holds the records from its base LSN on, the first one
+// right after the header. 0 means "none".
+using lsn_t = uint64_t;
+const lsn_t INVALID_LSN = 0;
+
+// Log records buffered in memory before a forced write
+const size_t LOG_BUFFER_SIZE = 64 * 1024;
+
+// The log file starts with [magic][reserved]; the first record follows it
+const size_t LOG_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+enum class LogRecordType : uint8_t {
+    BEGIN = 1,
+    COMMIT,
+    ABORT,
+    UPDATE,  // physical change to a byte range of one page
+    CLR,     // compensation record written while undoing an UPDATE
+    BEGIN_CHECKPOINT,
+    END_CHECKPOINT  // carries the active transaction and dirty page tables
+};
+
+struct DirtyPageEntry {
+    std::string filename;
+    int page_id;
+    lsn_t rec_lsn;  // first record that may not be on disk for this page
+};
+
+struct LogRecord {
+    lsn_t lsn = INVALID_LSN;
+    lsn_t prev_lsn = INVALID_LSN;  // previous record of the same transaction
+    int transaction_id = -1;
+    LogRecordType type = LogRecordType::BEGIN;
+
+    // UPDATE and CLR: the bytes at [offset, offset + length) of a page.
+    // A CLR only carries the restored bytes as its after image.
+    std::string filename;
+    int page_id = -1;
+    uint16_t offset = 0;
+    std::string before_image;
+    std::string after_image;
+    lsn_t undo_next_lsn = INVALID_LSN;  // CLR: next record of the transaction to undo
+
+    // END_CHECKPOINT: transaction -> last LSN, and the buffer pool's dirty pages
+    std::vector<std::pair<int, lsn_t>> active_transactions;
+    std::vector<DirtyPageEntry> dirty_pages;
+
+    size_t getSize() const;
+    void serialize(char* buffer) const;
+    bool deserialize(const char* buffer, size_t size);
+};
+
+// Append-only write-ahead log of one database (./data/<db>/wal.log).
+// Records are buffered and forced to disk by flush(); a transaction is
+// durable once flush() returns for its COMMIT record. Threads that ask for
+// a flush while another thread is syncing wait and are then served by a
+// single write + fsync of everything appended meanwhile (group commit).
+class LogManager {
+public:
+    // base_lsn is the LSN of the file's first record, kept by the caller
+    // (the checkpoint master record) since the log was last cut
+    explicit LogManager(const std::string& log_file, lsn_t base_lsn = LOG_HEADER_SIZE);
+    ~LogManager();
+
+    // Assigns the LSN and links prev_lsn to the transaction's last record
+    lsn_t appendLogRecord(LogRecord& record);
+    // Blocks until the record at lsn (and everything before it) is durable
+    bool flush(lsn_t lsn);
+    bool flushAll();
+    bool readLogRecord(lsn_t lsn, LogRecord& record);
+    // Cuts off a torn tail found by recovery; only valid before new appends
+    bool truncate(lsn_t lsn);
+    // Reclaims the log before lsn, which must start a record: the rest is
+    // copied to a new file (<log>.<lsn>), install(lsn) records the new base
+    // durably, and the new file then replaces the log. A crash before
+    // install leaves the old log in use; after it, the new file is
+    // installed on restart (see RecoveryManager::prepareLog).
+    bool discardBefore(lsn_t lsn, const std::function<bool(lsn_t)>& install);
+    void close();
+
+    // Last record of a transaction that has not committed or aborted yet
+    lsn_t getLastLSN(int transaction_id);
+    std::vector<std::pair<int, lsn_t>> getActiveTransactions();
+    // First record of the oldest unfinished transaction; INVALID_LSN if none
+    lsn_t getOldestActiveLSN();
+    // Recovery re-registers loser transactions so their CLRs chain correctly
+    void registerTransaction(int transaction_id, lsn_t last_lsn);
+    lsn_t getFirstLSN();
+    lsn_t getNextLSN();
+    lsn_t getFlushedLSN();
+    size_t getNumSyncs() const { return num_syncs; }
+    const std::string& getLogFile() const { return log_file; }
+
+private:
+    std::string log_file;
+    int fd;
+    std::ifstream reader;
+    std::vector<char> log_buffer;
+    lsn_t base_lsn;     // LSN of the first record in the file
+    lsn_t next_lsn;     // offset the next record will be written at
+    lsn_t flushed_lsn;  // every byte before this offset is durable
+    bool flush_in_progress;
+    size_t num_syncs;
+    std::unordered_map<int, lsn_t> active_transactions;  // transaction -> last LSN
+    std::unordered_map<int, lsn_t> first_lsns;           // transaction -> first LSN
+    std::mutex latch;
+    std::condition_variable flush_done;
+
+    bool openLog();
+    // Position of lsn in the file
+    long long fileOffset(lsn_t lsn) const { return static_cast<long long>(lsn - base_lsn + LOG_HEADER_SIZE); }
+};
@@ -0,0 +1,503 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <fstream>
+#include <unordered_map>
+#include "ast.h"
+#include "record.h"
+#include "storage_manager.h"
+#include "index_manager.h"
+
+// Pull-based (Volcano) physical operators. A query plan is a tree of
+// operators; the executor calls open() on the root, then next() until it
+// returns false, then close(). Every operator pulls rows from its children
+// one at a time, so a pipeline of scans, filters, joins and projections
+// holds only the current row. Sort, Aggregate and the build side of a join
+// are the only operators that consume their whole input in open().
+class Operator;
+using OperatorPtr = std::unique_ptr<Operator>;
+
+class Operator {
+public:
+    explicit Operator(Schema schema) : schema(std::move(schema)) {}
+    virtual ~Operator() = default;
+
+    virtual bool open() = 0;
+    // Produces the next row; false once the input is exhausted or on an
+    // error, which failed() then reports
+    virtual bool next(Record& row) = 0;
+    virtual void close() {}
+    // Whether this operator or one of its inputs stopped on an error
+    virtual bool failed() {
+        bool result = has_error;
+        forEachChild([&result](OperatorPtr& child) { result = result || child->failed(); });
+        return result;
+    }
+
+    // Layout of the rows this operator produces
+    const Schema& getSchema() const { return schema; }
+
+    // One-line label for EXPLAIN, e.g. "Filter (age > 30)"
+    virtual std::string describe() const = 0;
+    // Calls visit on the slot of each input, so a plan can be printed or
+    // its operators wrapped
+    virtual void forEachChild(const std::function<void(OperatorPtr&)>&) {}
+
+    // Rows the planner expects this operator to produce; negative when
+    // the tables involved have not been analyzed
+    double getEstimatedRows() const { return estimated_rows; }
+    void setEstimatedRows(double rows) { estimated_rows = rows; }
+
+protected:
+    Schema schema;
+    double estimated_rows = -1;
+    bool has_error = false;  // set when next() stops on an error rather than at the end
+};
+
+// Reads a heap file page by page
+class SeqScanOperator : public Operator {
+public:
+    // columns marks the ones the plan reads (empty for all); the others
+    // stay NULL. filter, bound to schema, is tested on each row as soon as
+    // the columns it reads are decoded, so rejected rows cost no more.
+    SeqScanOperator(StorageManager* storage_manager, const std::string& data_file, Schema schema,
+                    std::vector<bool> columns = {}, const Expression* filter = nullptr);
+
+    bool open() override;
+    bool next(Record& row) override;
+    std::string describe() const override;
+
+private:
+    std::string data_file;
+    std::vector<bool> columns;
+    const Expression* filter;
+    TableIterator iterator;
+};
+
+// Fetches the row an index entry points to: one descent of the B+ tree
+// and one heap page read. The plan keeps a Filter on the full predicate
+// above it for the conditions other than the key.
+class IndexLookupOperator : public Operator {
+public:
+    IndexLookupOperator(StorageManager* storage_manager, IndexManager* index_manager,
+                        const std::string& data_file, const std::string& index_file,
+                        const IndexKey& key, Schema schema);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+
+private:
+    StorageManager* storage_manager;
+    IndexManager* index_manager;
+    std::string data_file;
+    std::string index_file;
+    IndexKey key;
+    Record match;
+    bool found;
+    bool done;
+};
+
+// Walks a key range of an index and fetches each row an entry
+// points to, so rows come out in key order. The leaf walk stops at the
+// upper bound; the Filter above rechecks the full predicate.
+class IndexRangeScanOperator : public Operator {
+public:
+    IndexRangeScanOperator(StorageManager* storage_manager, IndexManager* index_manager,
+                           const std::string& data_file, const std::string& index_file,
+                           const KeyRange& range, std::vector<int> key_columns, Schema schema);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+
+private:
+    StorageManager* storage_manager;
+    IndexManager* index_manager;
+    std::string data_file;
+    std::string index_file;
+    KeyRange range;
+    std::vector<int> key_columns;  // schema positions of the index's columns
+    std::vector<RID> rids;
+    size_t position;
+};
+
+// Answers a key range from the index alone: each row is rebuilt from an
+// entry's key and included values, with NULL in the columns the index does
+// not store. The planner only uses it when the query reads no other
+// column, so the heap file is never touched.
+class IndexOnlyScanOperator : public Operator {
+public:
+    IndexOnlyScanOperator(IndexManager* index_manager, const std::string& data_file, const std::string& index_file,
+                          const KeyRange& range, std::vector<int> key_columns, std::vector<int> included_columns,
+                          Schema schema);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+
+private:
+    IndexManager* index_manager;
+    std::string data_file;  // only named by describe()
+    std::string index_file;
+    KeyRange range;
+    std::vector<int> key_columns;
+    std::vector<int> included_columns;  // schema positions of the INCLUDE columns
+    std::vector<IndexEntry> entries;
+    size_t position;
+};
+
+class FilterOperator : public Operator {
+public:
+    FilterOperator(OperatorPtr child, const Expression* predicate);
+    // Passes the rows for which every one of conjuncts holds
+    FilterOperator(OperatorPtr child, std::vector<const Expression*> conjuncts);
+
+    bool open() override { return child->open(); }
+    bool next(Record& row) override;
+    void close() override { child->close(); }
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    OperatorPtr child;
+    std::vector<const Expression*> conjuncts;  // bound to the child's schema
+};
+
+class ProjectOperator : public Operator {
+public:
+    ProjectOperator(OperatorPtr child, std::vector<const Expression*> expressions, Schema schema);
+
+    bool open() override { return child->open(); }
+    bool next(Record& row) override;
+    void close() override { child->close(); }
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    OperatorPtr child;
+    std::vector<const Expression*> expressions;
+    Record input;
+};
+
+// Joins each row of the probe input with the rows of the build input,
+// which is read into memory in open(). The right input is built unless
+// build_left is set, so the planner can build on the smaller side. Rows
+// are the left columns followed by the right columns whichever side is
+// built; the missing side of an outer join is padded with NULLs.
+// Subclasses decide which build rows are candidates for a probe row.
+class JoinOperator : public Operator {
+public:
+    JoinOperator(OperatorPtr left, OperatorPtr right, JoinType type, const Expression* condition,
+                 bool build_left = false);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override;
+
+protected:
+    std::vector<Record> build_rows;
+
+    // "Hash Join", "Nested Loop Join"
+    virtual std::string algorithm() const = 0;
+    // Fills build_rows; the default reads the whole build input
+    virtual bool readBuild();
+    virtual void build() {}
+    virtual void findCandidates(const Record& probe, std::vector<size_t>& candidates) = 0;
+    // Next row to join with build_rows; the default pulls the probe input
+    virtual bool nextProbe(Record& row) { return probeInput()->next(row); }
+    // Called once every probe row is joined with build_rows: loads the
+    // next batch of build rows and the probe rows that go with it. False
+    // when there is none.
+    virtual bool nextBatch() { return false; }
+
+    Operator* probeInput() const { return build_left ? right.get() : left.get(); }
+    Operator* buildInput() const { return build_left ? left.get() : right.get(); }
+
+private:
+    OperatorPtr left;
+    OperatorPtr right;
+    JoinType type;
+    const Expression* condition;  // bound to the joined schema
+    bool build_left;
+    size_t left_width;
+    size_t right_width;
+
+    Record probe_row;
+    bool has_probe;
+    bool probe_matched;
+    bool probe_done;
+    std::vector<size_t> candidates;
+    size_t candidate;
+    std::vector<bool> build_matched;
+    size_t unmatched;  // outer join of the build side: next build row to check once probing ends
+
+    void startBatch();
+    // Whether unmatched rows of the probe / build side are emitted NULL-padded
+    bool preservesProbe() const;
+    bool preservesBuild() const;
+    Record combine(const Record* probe, const Record* build) const;
+};
+
+// Compares every probe row with every build row; used when the ON
+// condition is not an equality between one column of each side
+class NestedLoopJoinOperator : public JoinOperator {
+public:
+    using JoinOperator::JoinOperator;
+
+protected:
+    std::string algorithm() const override { return "Nested Loop Join"; }
+    void findCandidates(const Record& probe, std::vector<size_t>& candidates) override;
+};
+
+// Equi-join: hashes the build rows on one column and probes with the
+// matching column of each probe row. NULL keys never match.
+// When the build rows outgrow MEMORY_BYTES the join turns into a Grace
+// hash join: both inputs are split on the hash of their key into
+// PARTITIONS files named <spill_prefix>.build<i> / .probe<i>, and each
+// pair is then joined in memory on its own. Rows with equal keys land in
+// the same pair, so only one build partition is held at a time. Without
+// a spill_prefix the build side is always kept in memory.
+class HashJoinOperator : public JoinOperator {
+public:
+    static constexpr size_t MEMORY_BYTES = 16 * 1024 * 1024;
+    static constexpr size_t PARTITIONS = 32;
+
+    HashJoinOperator(OperatorPtr left, OperatorPtr right, JoinType type, const Expression* condition,
+                     int left_key, int right_key, bool build_left = false,
+                     const std::string& spill_prefix = "");
+
+    void close() override;
+    std::string describe() const override;
+
+protected:
+    std::string algorithm() const override { return "Hash Join"; }
+    bool readBuild() override;
+    void build() override;
+    void findCandidates(const Record& probe, std::vector<size_t>& candidates) override;
+    bool nextProbe(Record& row) override;
+    bool nextBatch() override;
+
+private:
+    int probe_key;  // column of the probe rows
+    int build_key;  // column of the build rows
+    std::unordered_multimap<Value, size_t> table;
+
+    std::string spill_prefix;
+    bool spilled;
+    size_t partition;  // partition being joined once spilled
+    std::ifstream probe_file;
+
+    std::string partitionName(const char* side, size_t i) const;
+    size_t partitionOf(const Record& row, int key) const;
+    // Writes build_rows and the rest of both inputs to the partition files
+    bool spill();
+    bool loadPartition();
+    void removePartitions();
+};
+
+// Equi-join of two inputs in ascending order of their key columns: walks
+// both in step and pairs each group of left rows with the right rows of
+// the same key, so no hash table is built. An input the planner cannot
+// get in key order (sort_left / sort_right) is sorted in memory in open().
+// Unmatched rows of either side are NULL-padded as the join type asks;
+// NULL keys never match.
+class MergeJoinOperator : public Operator {
+public:
+    MergeJoinOperator(OperatorPtr left, OperatorPtr right, JoinType type, const Expression* condition,
+                      int left_key, int right_key, bool sort_left, bool sort_right);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override;
+
+private:
+    // One side of the join, read a row ahead
+    struct Input {
+        OperatorPtr child;
+        int key;
+        bool sort;
+        std::vector<Record> rows;  // the whole input when it is sorted here
+        size_t position = 0;
+        Record row;
+        bool has_row = false;
+
+        bool open();
+        void advance();
+        const Value& keyValue() const;
+    };
+
+    Input left;
+    Input right;
+    JoinType type;
+    const Expression* condition;  // bound to the joined schema
+    size_t left_width;
+    size_t right_width;
+
+    // Rows of both sides sharing the current key; one side is empty for a
+    // key the other lacks
+    std::vector<Record> left_group;
+    std::vector<Record> right_group;
+    std::vector<bool> right_matched;
+    size_t left_position;
+    size_t right_position;
+    bool left_matched;
+    size_t unmatched;  // next right row to check once the left group is done
+
+    // Reads the next key's rows of both sides; false when both are exhausted
+    bool nextGroups();
+};
+
+// For each row of the outer input, looks its key up in an index on the
+// inner table's join column and fetches the matching rows from the heap,
+// so the inner table is never scanned. Only the outer side can be kept
+// by an outer join, so it never runs a FULL join; NULL keys never match.
+class IndexNestedLoopJoinOperator : public Operator {
+public:
+    IndexNestedLoopJoinOperator(OperatorPtr outer, StorageManager* storage_manager, IndexManager* index_manager,
+                                const std::string& data_file, const std::string& index_file,
+                                const Schema& inner_schema, JoinType type, const Expression* condition,
+                                int outer_key, bool outer_left);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(outer); }
+
+private:
+    OperatorPtr outer;
+    StorageManager* storage_manager;
+    IndexManager* index_manager;
+    std::string data_file;  // of the inner table
+    std::string index_file;
+    JoinType type;
+    const Expression* condition;  // bound to the joined schema
+    int outer_key;
+    bool outer_left;  // the outer input is the left one
+    size_t outer_width;
+    size_t inner_width;
+
+    Record outer_row;
+    bool has_outer;
+    bool outer_matched;
+    std::vector<RID> matches;
+    size_t match;
+
+    bool preservesOuter() const { return type == (outer_left ? JoinType::LEFT : JoinType::RIGHT); }
+};
+
+// Running state of one aggregate function over a group
+struct Accumulator {
+    int64_t count = 0;  // rows for COUNT(*), non-NULL values otherwise
+    size_t numeric = 0;
+    double sum = 0;
+    bool all_int = true;
+    Value min, max;
+
+    void add(const Value& value);
+    Value result(const std::string& function) const;
+};
+
+// Groups its input on the GROUP BY expressions and emits one row per
+// group: the group values followed by one value per aggregate. Without
+// GROUP BY an empty input still produces one row.
+class AggregateOperator : public Operator {
+public:
+    AggregateOperator(OperatorPtr child, std::vector<const Expression*> group_by,
+                      std::vector<const Expression*> aggregates, Schema schema);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    OperatorPtr child;
+    std::vector<const Expression*> group_by;    // bound to the child's schema
+    std::vector<const Expression*> aggregates;  // arguments bound to the child's schema
+    std::map<std::vector<Value>, std::vector<Accumulator>> groups;
+    std::map<std::vector<Value>, std::vector<Accumulator>>::const_iterator position;
+};
+
+struct SortKey {
+    const Expression* expression;  // bound to the child's schema
+    bool ascending;
+};
+
+class SortOperator : public Operator {
+public:
+    SortOperator(OperatorPtr child, std::vector<SortKey> keys);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    OperatorPtr child;
+    std::vector<SortKey> keys;
+    std::vector<Record> rows;
+    size_t position;
+};
+
+// ORDER BY ... LIMIT: the first count rows in key order, ties kept in
+// input order as SortOperator does. Only count rows are held, in a heap
+// whose top is the last of them, so n input rows cost O(n log count)
+// instead of a sort of all n.
+class TopNOperator : public Operator {
+public:
+    TopNOperator(OperatorPtr child, std::vector<SortKey> keys, size_t count);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    struct Entry {
+        std::vector<Value> key;  // the sort keys, evaluated once
+        size_t sequence;         // input position, breaking ties
+        Record row;
+    };
+
+    OperatorPtr child;
+    std::vector<SortKey> keys;
+    size_t count;
+    std::vector<Entry> rows;  // a heap while reading, then sorted
+    size_t position;
+
+    bool before(const Entry& a, const Entry& b) const;
+};
+
+// Skips offset rows, then passes on at most limit rows and stops pulling
+// from its child, so a scan below it reads no further pages
+class LimitOperator : public Operator {
+public:
+    LimitOperator(OperatorPtr child, size_t limit, size_t offset = 0);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override { child->close(); }
+    std::string describe() const override;
+    void forEachChild(const std::function<void(OperatorPtr&)>& visit) override { visit(child); }
+
+private:
+    OperatorPtr child;
+    size_t limit;
+    size_t offset;
+    size_t produced;
+};
@@ -2,9 +2,14 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cstdint>
 
 const size_t PAGE_SIZE_BYTES = 4096;  // 4KB page size
 
+// Every page starts with the LSN of the last log record applied to it;
+// page layouts (heap pages, B+ tree nodes) begin after these bytes
+const size_t PAGE_LSN_SIZE = sizeof(uint64_t);
+
 class Page {
 public:
     Page() {
@@ -25,11 +30,17 @@ public:
     const char* getData() const { return data; }
     char* getData() { return data; }
     size_t getNumRecords() const { return num_keys; }  // For now, use num_keys as num_records
+    uint64_t getLSN() const {
+        uint64_t lsn = 0;
+        memcpy(&lsn, data, PAGE_LSN_SIZE);
+        return lsn;
+    }
 
     // Setters
     void setLeaf(bool leaf) { is_leaf = leaf; }
     void setNumKeys(int keys) { num_keys = keys; }
     void setFreeSpace(size_t space) { free_space = space; }
+    void setLSN(uint64_t lsn) { memcpy(data, &lsn, PAGE_LSN_SIZE); }
 
     // Data manipulation methods
     bool writeData(size_t offset, const void* src, size_t size) {
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "lexer.h"
+#include "ast.h"
+
+// Recursive-descent parser for the SQL dialect of the shell. Each
+// statement is parsed once into an AST; the executor binds and evaluates
+// the tree instead of looking at query text again.
+//
+//   expression := or_expr
+//   or_expr    := and_expr { OR and_expr }
+//   and_expr   := not_expr { AND not_expr }
+//   not_expr   := NOT not_expr | comparison
+//   comparison := operand [ (= | != | <> | < | > | <= | >=) operand ]
+//   operand    := literal | column | table.column | aggregate | ( expression )
+class Parser {
+public:
+    explicit Parser(const std::string& sql);
+
+    // Parses every statement of the input; statements are separated by
+    // semicolons. Returns false with a message in getError() on bad syntax.
+    bool parse(std::vector<Statement>& statements);
+    const std::string& getError() const { return error; }
+
+private:
+    std::string sql;
+    std::vector<Token> tokens;
+    size_t pos;
+    std::string error;
+
+    const Token& peek(size_t ahead = 0) const;
+    const Token& advance();
+    bool accept(TokenType type);
+    bool acceptKeyword(const char* keyword);
+    bool expect(TokenType type, const char* what);
+    bool expectKeyword(const char* keyword);
+    bool fail(const std::string& expected);
+    bool parseIdentifier(std::string& name, const char* what);
+    bool parseLiteral(Value& value);
+
+    bool parseStatement(Statement& statement);
+    bool parseSelect(SelectStatement& select);
+    bool parseTableRef(TableRef& table);
+    bool parseInsert(InsertStatement& insert);
+    bool parseUpdate(UpdateStatement& update);
+    bool parseDelete(DeleteStatement& remove);
+    bool parseCreate(Statement& statement);
+    bool parseColumnDefinition(ColumnInfo& column);
+    // (column [, column ...])
+    bool parseColumnList(std::vector<std::string>& columns);
+
+    ExpressionPtr parseExpression();
+    ExpressionPtr parseOr();
+    ExpressionPtr parseAnd();
+    ExpressionPtr parseNot();
+    ExpressionPtr parseComparison();
+    ExpressionPtr parseOperand();
+
+    static bool isReserved(const std::string& upper);
+};
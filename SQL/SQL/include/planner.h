@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include "ast.h"
+#include "operators.h"
+#include "catalog_manager.h"
+#include "storage_manager.h"
+#include "index_manager.h"
+
+// Turns a parsed query into a tree of physical operators. Planning binds
+// every expression of the statement, so the tree may only be run while the
+// statement it was built from is alive.
+class Planner {
+public:
+    Planner(CatalogManager* catalog_manager, StorageManager* storage_manager,
+            IndexManager* index_manager, const std::string& db_name);
+
+    // Scan or join -> WHERE -> GROUP BY/aggregates -> HAVING -> ORDER BY
+    // (top-N under a LIMIT) -> select list -> LIMIT/OFFSET
+    bool planSelect(SelectStatement& query, OperatorPtr& root, std::string& error);
+
+    // Access path for the rows of one table that satisfy where (null for
+    // every row): an index lookup on equality with a unique key, an index
+    // range scan on equality with leading columns of a B+ tree index and
+    // bounds on the next, or with the whole key of a hash index, else a
+    // scan. Once the table is analyzed the index is only used when the
+    // cost model rates it cheaper than the scan.
+    // needed_columns marks the columns the rest of the plan reads; given,
+    // an index holding all of them answers the query without the heap,
+    // and a scan decodes only them. Null means whole rows are needed.
+    bool planScan(TableInfo* table, const std::string& qualifier, Expression* where,
+                  OperatorPtr& root, std::string& error, const std::vector<bool>* needed_columns = nullptr);
+
+    static Schema tableSchema(const TableInfo* table, const std::string& qualifier);
+
+private:
+    // Index access for the key conditions of a WHERE clause: equality on
+    // the leading columns of the index, then bounds on the next one
+    struct IndexPath {
+        const IndexInfo* index = nullptr;  // null when WHERE has no usable key condition
+        std::vector<int> columns;  // positions of the index's columns
+        std::vector<int> included_columns;  // positions of its INCLUDE columns
+        size_t equal_columns = 0;  // leading columns fixed by equality
+        bool covering = false;  // holds every needed column: no heap access
+        KeyRange range;
+        std::vector<const Expression*> enforced;  // WHERE conjuncts the range alone guarantees
+        double rows = -1;  // estimated matching rows; negative without statistics
+        double index_cost = 0;  // 0 without statistics
+        double scan_cost = 0;
+
+        // Equality on every column of a unique index: at most one row
+        bool isPoint() const { return index->unique && equal_columns == columns.size(); }
+        // Without statistics paths are rated by how tightly they bound the
+        // key: a whole unique key, then each column fixed by equality, then
+        // a closed range on the next column over an open one. A hash index
+        // beats a B+ tree on the same equality, as it skips the descent.
+        int score() const {
+            if (isPoint()) return 1000 + index->hash;
+            return 4 * equal_columns + (range.low.size() > equal_columns) + (range.high.size() > equal_columns) +
+                   index->hash;
+        }
+    };
+
+    CatalogManager* catalog_manager;
+    StorageManager* storage_manager;
+    IndexManager* index_manager;
+    std::string db_name;
+
+    // Joins of more tables are planned in the written order
+    static constexpr size_t MAX_REORDERED_TABLES = 10;
+
+    // One side of a join: the rows of one or more tables
+    struct JoinInput {
+        OperatorPtr root;
+        const TableInfo* table = nullptr;  // the table when the input is a scan of one
+        const Expression* filter = nullptr;  // WHERE conjuncts that scan tests, bound to the table
+        TableStats stats;  // of the rows, estimated once they are joined
+        double pages = 0;  // heap pages the rows would fill
+    };
+
+    // stats receives the statistics of the joined rows
+    bool planJoin(SelectStatement& query, OperatorPtr& root, TableStats& stats, std::string& error);
+    // columns and filter as for SeqScanOperator
+    JoinInput scanInput(TableInfo* table, const Schema& schema, const std::vector<bool>& columns,
+                        const Expression* filter);
+    // Joins right, a scan of one table, into left, which then holds the
+    // joined rows. condition (null for a cross join) is bound to the joined
+    // schema; step numbers the joins of the query.
+    bool planJoinStep(JoinInput& left, JoinInput& right, JoinType type, Expression* condition, size_t step,
+                      std::string& error);
+    // table is the only input table, or null for a join; stats describe
+    // the input rows
+    bool planAggregate(SelectStatement& query, TableInfo* table, const TableStats& stats,
+                       OperatorPtr& root, Schema& output, std::string& error);
+    // False when there is no key condition or a scan is estimated cheaper
+    bool chooseIndexPath(const TableInfo* table, const Expression* where, IndexPath& path,
+                         const std::vector<bool>* needed_columns) const;
+    std::string getTablePath(const std::string& table_name) const;
+};
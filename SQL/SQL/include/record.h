@@ -3,15 +3,32 @@
 #include <vector>
 #include <cstring>
 #include <stdexcept>
+#include <iostream>
+#include <cstdint>
+#include "value.h"
+
+// Record id: the heap page holding a record and its slot on that page
+struct RID {
+    int page_id;
+    int slot;
+
+    RID() : page_id(-1), slot(-1) {}
+    RID(int page_id, int slot) : page_id(page_id), slot(slot) {}
+
+    bool isValid() const { return page_id >= 0 && slot >= 0; }
+    bool operator==(const RID& other) const {
+        return page_id == other.page_id && slot == other.slot;
+    }
+    bool operator!=(const RID& other) const { return !(*this == other); }
+};
 
 class Record {
 public:
     static const size_t MAX_VALUES = 10;
-    static const size_t MAX_STRING_LENGTH = 256;
-    std::vector<std::string> values;
-    int rid;
+    std::vector<Value> values;
+    RID rid;  // Set when the record is read from or written to a table
 
-    Record() : rid(-1) {}
+    Record() {}
     ~Record() = default;
     
     // Copy constructor
@@ -30,10 +47,12 @@ public:
         return values == other.values && rid == other.rid;
     }
 
+    // [uint16 number of values] followed by each value in its binary form.
+    // The rid is implied by where the record is stored, so it is not serialized
     size_t getSize() const {
-        size_t size = sizeof(int) + sizeof(size_t);  // rid + number of values
+        size_t size = sizeof(uint16_t);
         for (const auto& value : values) {
-            size += sizeof(size_t) + value.length();  // length + string content
+            size += value.getSerializedSize();
         }
         return size;
     }
@@ -41,75 +60,48 @@ public:
     void serialize(char* buffer) const {
         size_t pos = 0;
         
-        // Write RID
-        memcpy(buffer + pos, &rid, sizeof(int));
-        pos += sizeof(int);
-        
         // Write number of values
-        size_t num_values = values.size();
-        memcpy(buffer + pos, &num_values, sizeof(size_t));
-        pos += sizeof(size_t);
+        uint16_t num_values = static_cast<uint16_t>(values.size());
+        memcpy(buffer + pos, &num_values, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
         
         // Write each value
         for (const auto& value : values) {
-            size_t len = value.length();
-            memcpy(buffer + pos, &len, sizeof(size_t));
-            pos += sizeof(size_t);
-            memcpy(buffer + pos, value.c_str(), len);
-            pos += len;
+            pos += value.serialize(buffer + pos);
         }
     }
 
     bool deserialize(const char* buffer, size_t buffer_size) {
-        try {
-            if (buffer_size < sizeof(int) + sizeof(size_t)) {
-                return false;
-            }
+        if (buffer_size < sizeof(uint16_t)) {
+            return false;
+        }
 
-            size_t pos = 0;
-            
-            // Read RID
-            memcpy(&rid, buffer + pos, sizeof(int));
-            pos += sizeof(int);
-            
-            // Read number of values
-            size_t num_values;
-            memcpy(&num_values, buffer + pos, sizeof(size_t));
-            pos += sizeof(size_t);
-            
-            if (num_values > MAX_VALUES) {
-                std::cerr << "Too many values in record: " << num_values << std::endl;
+        size_t pos = 0;
+        
+        // Read number of values
+        uint16_t num_values;
+        memcpy(&num_values, buffer + pos, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        
+        if (num_values > MAX_VALUES) {
+            std::cerr << "Too many values in record: " << num_values << std::endl;
+            return false;
+        }
+        
+        values.clear();
+        values.resize(num_values);
+        
+        // Read each value
+        for (size_t i = 0; i < num_values; i++) {
+            size_t consumed = values[i].deserialize(buffer + pos, buffer_size - pos);
+            if (consumed == 0) {
+                std::cerr << "Malformed value " << i << " in record" << std::endl;
                 return false;
             }
-            
-            values.clear();
-            values.reserve(num_values);
-            
-            // Read each value
-            for (size_t i = 0; i < num_values; i++) {
-                if (pos + sizeof(size_t) > buffer_size) {
-                    std::cerr << "Buffer overflow reading string length" << std::endl;
-                    return false;
-                }
-                
-                size_t len;
-                memcpy(&len, buffer + pos, sizeof(size_t));
-                pos += sizeof(size_t);
-                
-                if (len > MAX_STRING_LENGTH || pos + len > buffer_size) {
-                    std::cerr << "String too long or buffer overflow: " << len << std::endl;
-                    return false;
-                }
-                
-                values.push_back(std::string(buffer + pos, len));
-                pos += len;
-            }
-            
-            return true;
-        } catch (const std::exception& e) {
-            std::cerr << "Error deserializing record: " << e.what() << std::endl;
-            return false;
+            pos += consumed;
         }
+        
+        return true;
     }
 
     // Helper functions
@@ -129,15 +121,14 @@ public:
         return record.deserialize(buffer, buffer_size);
     }
 
-    // Helper to parse a column value as double (for SUM/AVG)
+    // Helper to read a column value as double (for SUM/AVG)
     double getNumericValue(size_t column_index) const {
         if (column_index >= values.size()) {
             throw std::out_of_range("Column index out of range");
         }
-        try {
-            return std::stod(values[column_index]);
-        } catch (...) {
+        if (!values[column_index].isNumeric()) {
             throw std::runtime_error("Non-numeric value");
         }
+        return values[column_index].asDouble();
     }
 }; 
\ No newline at end of file
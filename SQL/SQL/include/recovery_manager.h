@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <map>
+#include "storage_manager.h"
+#include "log_manager.h"
+
+// Take a fuzzy checkpoint after this much log has been written
+const lsn_t CHECKPOINT_INTERVAL_BYTES = 4 * 1024 * 1024;
+
+// ARIES-style restart recovery over the write-ahead log.
+//
+// Checkpoints are fuzzy: BEGIN_CHECKPOINT, then an END_CHECKPOINT holding
+// the active transaction table and the buffer pool's dirty page table,
+// then the master record (./data/<db>/wal.master) is pointed at the begin
+// record. Data pages are not flushed, except those dirty since before the
+// previous checkpoint, so redo never starts further back than about two
+// checkpoint intervals. The log before the oldest recLSN of a dirty page
+// and the first record of any unfinished transaction is then reclaimed;
+// the master record keeps the LSN the log file now starts at.
+//
+// recover() runs analysis from the last checkpoint, repeats history from
+// the oldest recLSN, and rolls back transactions that never finished,
+// logging CLRs so a crash during recovery is itself recoverable.
+class RecoveryManager {
+public:
+    RecoveryManager(StorageManager* storage_manager, LogManager* log_manager,
+                    const std::string& master_file);
+
+    // Run before the log is opened: finishes a log replacement a crash
+    // interrupted and returns the LSN the log file starts at
+    static lsn_t prepareLog(const std::string& log_file, const std::string& master_file);
+
+    // Returns false if the log could not be read; max_transaction_id is the
+    // highest transaction id found so new transactions do not reuse one
+    bool recover(int& max_transaction_id);
+    // flush_all writes back every dirty page first (sharp checkpoint)
+    bool checkpoint(bool flush_all = false);
+    void maybeCheckpoint();
+
+private:
+    struct TransactionEntry {
+        lsn_t last_lsn;
+    };
+
+    StorageManager* storage_manager;
+    LogManager* log_manager;
+    std::string master_file;
+    lsn_t last_checkpoint_lsn;
+
+    // [magic][checkpoint LSN][base LSN of the log file]; the base is
+    // missing from masters written before the log was ever reclaimed
+    static bool readMaster(const std::string& master_file, lsn_t& checkpoint_lsn, lsn_t& base_lsn);
+    bool writeMaster(lsn_t checkpoint_lsn, lsn_t base_lsn) const;
+
+    bool analysis(lsn_t start_lsn, std::map<int, TransactionEntry>& transactions,
+                  std::map<std::string, DirtyPageEntry>& dirty_pages, int& max_transaction_id);
+    bool redo(const std::map<std::string, DirtyPageEntry>& dirty_pages, size_t& redone);
+    bool undo(const std::map<int, TransactionEntry>& transactions);
+
+    static std::string pageKey(const std::string& filename, int page_id);
+};
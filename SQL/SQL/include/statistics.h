@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "value.h"
+#include "record.h"
+
+struct Expression;
+
+// Per-column statistics gathered by ANALYZE
+struct ColumnStats {
+    int64_t distinct_count = 0;
+    int64_t null_count = 0;
+    Value min, max;
+    // Equi-depth histogram: upper bound of each bucket, ascending. Every
+    // bucket holds about the same number of non-NULL rows, so skewed
+    // columns get narrow buckets where the values are dense.
+    std::vector<Value> histogram;
+    // Share of non-NULL values, in heap order, that are not below the
+    // previous one: 1 when the rows are stored in this column's order, so
+    // reading them in index order touches each heap page once
+    double ordered = 0;
+};
+
+struct TableStats {
+    bool analyzed = false;  // false until the first ANALYZE
+    int64_t row_count = 0;
+    int64_t page_count = 0;
+    std::vector<ColumnStats> columns;
+};
+
+// Collects TableStats from one pass over a table's rows. Row and NULL
+// counts, min, max and ordering are exact; histograms and distinct counts
+// come from a uniform sample of at most SAMPLE_SIZE values per column, so
+// memory stays bounded however large the table is.
+class StatisticsBuilder {
+public:
+    static constexpr size_t HISTOGRAM_BUCKETS = 32;
+    static constexpr size_t SAMPLE_SIZE = 30000;
+
+    explicit StatisticsBuilder(size_t num_columns);
+
+    void add(const Record& record);
+    TableStats finish(int64_t page_count);
+
+private:
+    struct ColumnSample {
+        std::vector<Value> values;  // reservoir of non-NULL values
+        int64_t seen = 0;           // non-NULL values so far
+        int64_t null_count = 0;
+        int64_t steps = 0;          // values not below the previous one
+        Value min, max, previous;
+    };
+
+    int64_t row_count;
+    std::vector<ColumnSample> columns;
+    std::mt19937_64 random;  // fixed seed: ANALYZE of the same rows gives the same statistics
+};
+
+// Cardinality estimation. Predicates must be bound to the table's schema.
+// Without statistics the usual textbook defaults are used: 1/10 for
+// equality and 1/3 for ranges.
+namespace Selectivity {
+    double estimate(const TableStats& stats, const Expression* predicate);
+    // Selectivity of the AND of predicates
+    double estimateAll(const TableStats& stats, const std::vector<const Expression*>& predicates);
+    double estimateRows(const TableStats& stats, const Expression* predicate);
+    // Number of groups GROUP BY forms out of input_rows rows
+    double estimateGroups(const TableStats& stats, const std::vector<const Expression*>& group_by,
+                          double input_rows);
+}
+
+// Statistics of the cross product of two tables, with the columns in
+// joined row order, so join conditions can be estimated like filters
+TableStats joinStats(const TableStats& left, const TableStats& right);
+// Statistics of a subset of the rows product describes, holding rows of
+// them (e.g. what a join keeps of a cross product); column fractions stay
+// the same
+TableStats scaleStats(const TableStats& product, double rows);
+
+// Cost model in units of one page read; a row costs CPU_ROW_COST to
+// process once its page is in memory
+namespace Cost {
+    const double CPU_ROW_COST = 0.01;
+    const double INDEX_FANOUT = 128;  // entries per B+ tree node for a short key
+
+    double tableScan(const TableStats& stats);
+    // Descends an index, then reads the heap page of each match
+    double indexLookup(const TableStats& stats, double matching_rows);
+    // Descends an index and reads only the leaves holding the matches
+    double indexOnlyScan(const TableStats& stats, double matching_rows);
+    // Reads a hash directory page and the key's bucket, then the heap page
+    // of each match; hashOnlyLookup skips the heap
+    double hashLookup(double matching_rows);
+    double hashOnlyLookup(double matching_rows);
+    // Reads a whole table in the order of an index on column, which
+    // costs one heap page per row unless the table is stored in that order
+    double indexOrderScan(const TableStats& stats, size_t column);
+    double sort(double rows);
+    // One probe of an index join: the lookup, then the heap pages of the
+    // matches, which share pages when the table is stored in key order
+    double indexJoinLookup(const TableStats& stats, size_t column, double matching_rows, bool hash);
+    // spilled_pages: pages partitioned to disk and read back
+    double hashJoin(double probe_rows, double build_rows, double spilled_pages = 0);
+    double nestedLoopJoin(double probe_rows, double build_rows);
+    // Joins two inputs already in key order
+    double mergeJoin(double left_rows, double right_rows);
+}
+
+// One-line text form of a Value for the catalog file ("I 42", "S abc", "N")
+std::string encodeStatsValue(const Value& value);
+bool decodeStatsValue(const std::string& text, Value& value);
@@ -4,32 +4,107 @@
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <functional>
+#include <set>
+#include <unordered_map>
 #include "page.h"
 #include "record.h"
+#include "buffer_pool.h"
+#include "log_manager.h"
 
 const size_t PAGE_SIZE = 4096;  // 4KB pages
 
+class StorageManager;
+
+// Narrows a table scan: only the columns set in columns are decoded (the
+// others read as NULL), and the rows filter rejects are dropped before
+// the rest of their columns are decoded. filter may only read the columns
+// set in filter_columns; they are decoded first.
+struct ScanProjection {
+    std::vector<bool> columns;  // empty decodes every column
+    std::vector<bool> filter_columns;
+    std::function<bool(const Record&)> filter;  // null keeps every row
+};
+
+// Page-at-a-time cursor over a table file. Only the records of the current
+// page are held in memory; each page is pinned just long enough to decode it.
+class TableIterator {
+public:
+    TableIterator(StorageManager* storage_manager, const std::string& file_path);
+
+    // Applies to the pages read from now on
+    void setProjection(ScanProjection projection) { this->projection = std::move(projection); }
+
+    // Returns false once every page has been read
+    bool next(Record& record);
+    void reset();
+    int getPagesRead() const { return pages_read; }
+
+private:
+    StorageManager* storage_manager;
+    std::string file_path;
+    int next_page_id;
+    size_t position;
+    int pages_read;
+    std::vector<Record> page_records;
+    ScanProjection projection;
+};
+
 class StorageManager {
 public:
-    StorageManager();
+    explicit StorageManager(size_t buffer_pool_frames = DEFAULT_BUFFER_POOL_FRAMES);
     ~StorageManager();
 
     bool createTable(const std::string& db_name, const std::string& table_name);
     bool dropTable(const std::string& db_name, const std::string& table_name);
-    bool insertRecord(const std::string& db_name, const std::string& table_name, const Record& record);
-    bool getRecord(const std::string& db_name, const std::string& table_name, int key, Record& record);
+    // Table files are slotted heap pages (see heap_page.h); records are
+    // addressed by RID and touch a single page on insert, update and delete
+    bool insertRecord(const std::string& db_name, const std::string& table_name, const Record& record,
+                      RID* rid = nullptr);
+    bool getRecord(const std::string& db_name, const std::string& table_name, const RID& rid, Record& record);
+    // Reads one record of a table file: a single page fetch
+    bool getRecord(const std::string& file_path, const RID& rid, Record& record);
+    // Prefer scan() for anything that may touch a whole table
+    TableIterator scan(const std::string& file_path) { return TableIterator(this, file_path); }
     std::vector<Record> getAllRecords(const std::string& file_path);
+    bool getPageRecords(const std::string& file_path, int page_id, std::vector<Record>& records,
+                        const ScanProjection* projection = nullptr);
     std::string getTablePath(const std::string& db_name, const std::string& table_name) const;
     
     // Add missing methods
     bool updateRecord(const std::string& db_name, const std::string& table_name, const Record& old_record, const Record& new_record);
+    // new_rid differs from rid when the record no longer fits on its page
+    bool updateRecord(const std::string& db_name, const std::string& table_name, const RID& rid,
+                      const Record& new_record, RID* new_rid = nullptr);
     bool deleteRecord(const std::string& db_name, const std::string& table_name, const Record& record);
+    bool deleteRecord(const std::string& db_name, const std::string& table_name, const RID& rid);
     std::vector<Record> selectRecords(const std::string& db_name, const std::string& table_name, const std::string& condition);
     
     // Add page management methods
     bool writePage(const std::string& filename, int page_id, const Page& page);
     bool readPage(const std::string& filename, int page_id, Page& page);
     bool writeAllRecords(const std::string& filename, const std::vector<Record>& records);
+    int getNumPages(const std::string& filename);
+    // Rewrites a table file from the old length-prefixed format, typing each
+    // value by its column; true if converted
+    bool upgradeLegacyTable(const std::string& filename, const std::vector<ValueType>& column_types);
+    bool flushFile(const std::string& filename);
+    // Drops cached pages of a file that is about to be removed or truncated
+    void discardFile(const std::string& filename);
+    BufferPool* getBufferPool() { return buffer_pool.get(); }
+
+    // Write-ahead logging. While the calling thread has a current transaction,
+    // every page change made through this class (heap and index pages) is
+    // logged as an UPDATE record and the page is stamped with its LSN.
+    void setLogManager(LogManager* manager);
+    LogManager* getLogManager() { return log_manager; }
+    static void setCurrentTransaction(int transaction_id);
+    static int getCurrentTransaction();
+    // Restores the before image of an UPDATE record and logs a CLR for it
+    bool undoLogRecord(const LogRecord& record);
+    // Reapplies the after image of an UPDATE or CLR if the page predates it
+    bool redoLogRecord(const LogRecord& record);
     
     // Add database management methods
     bool createDatabase(const std::string& db_name);
@@ -37,9 +112,24 @@ public:
     bool createFile(const std::string& filename);
     
     // Add helper methods
-    bool compareValues(const std::string& record_value, const std::string& search_value, const std::string& op);
+    bool compareValues(const Value& record_value, const Value& search_value, const std::string& op);
 
 private:
+    std::unique_ptr<BufferPool> buffer_pool;
+    LogManager* log_manager;
+    std::unordered_map<std::string, int> page_counts;  // includes pages only in the pool
+    // Pages of each table file that rows were deleted or moved from since
+    // it was opened; inserts try them before the last page and extending
+    // the file. A page leaves the set once a record fails to fit on it.
+    std::unordered_map<std::string, std::set<int>> free_space_hints;
+
     static const int PAGE_SIZE_BYTES = 4096;
     static const int MAX_RECORDS_PER_PAGE = 100;
+
+    bool isLogging() const;
+    // Inserts a serialized record into an existing heap page; the slot, or
+    // -1 if it does not fit or the page cannot be read
+    int insertIntoPage(const std::string& file_path, int page_id, const char* data, size_t size);
+    // Logs the bytes that differ between before and page, then stamps the LSN
+    void logPageChange(const std::string& filename, int page_id, const char* before, Page& page);
 }; 
\ No newline at end of file
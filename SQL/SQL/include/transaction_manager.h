@@ -10,6 +10,7 @@
 #include "storage_manager.h"
 #include "catalog_manager.h"
 #include "index_manager.h"
+#include "log_manager.h"
 
 // Transaction states
 enum class TransactionState {
@@ -67,10 +68,13 @@ class TransactionManager {
 public:
     TransactionManager(StorageManager* storage_manager,
                       CatalogManager* catalog_manager,
-                      IndexManager* index_manager);
+                      IndexManager* index_manager,
+                      LogManager* log_manager = nullptr);
     ~TransactionManager();
 
-    // Transaction management
+    // Transaction management. begin makes the transaction current for the
+    // calling thread; commit forces its COMMIT record to the log, abort
+    // undoes its logged changes newest first.
     int beginTransaction();
     bool commitTransaction(int transaction_id);
     bool abortTransaction(int transaction_id);
@@ -88,11 +92,14 @@ public:
 
     // Set current database
     void setCurrentDatabase(const std::string& db_name) { current_db_name = db_name; }
+    // Keeps ids of transactions found in the log from being handed out again
+    void setNextTransactionId(int transaction_id) { next_transaction_id = transaction_id; }
 
 private:
     StorageManager* storage_manager;
     CatalogManager* catalog_manager;
     IndexManager* index_manager;
+    LogManager* log_manager;
     
     std::mutex transaction_mutex;
     std::mutex lock_mutex;
@@ -107,6 +114,7 @@ private:
     bool hasLock(int transaction_id, const std::string& resource, LockMode mode);
     bool canAcquireLock(int transaction_id, const std::string& resource, LockMode mode);
     void waitForLock(int transaction_id, const std::string& resource, LockMode mode);
+    bool rollback(int transaction_id);
 };
 
 #endif // TRANSACTION_MANAGER_H 
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+
+// Column types a value can have; the tag is stored in front of each
+// serialized value
+enum class ValueType : uint8_t {
+    NULL_VALUE = 0,
+    INT,
+    DOUBLE,
+    VARCHAR,
+    CHAR
+};
+
+// A single typed column value. Numbers are kept in native form so
+// predicates, aggregates and sorts never re-parse text; strings are stored
+// without their quotes.
+//
+// On disk: [uint8 type] then int32 (INT), double (DOUBLE), or
+// [uint16 length][bytes] (VARCHAR, CHAR); NULL has no payload.
+class Value {
+public:
+    Value() : type(ValueType::NULL_VALUE), int_value(0) {}
+    explicit Value(int32_t value) : type(ValueType::INT), int_value(value) {}
+    explicit Value(double value) : type(ValueType::DOUBLE), double_value(value) {}
+    explicit Value(const std::string& value, ValueType string_type = ValueType::VARCHAR)
+        : type(string_type), int_value(0), string_value(value) {}
+
+    // Maps a catalog type name ("INT", "VARCHAR(50)", "CHAR(2)", ...) to a
+    // value type; max_length is the declared length, 0 if none
+    static ValueType typeFromName(const std::string& type_name, int* max_length = nullptr);
+    static const char* typeName(ValueType type);
+
+    // Converts the text of a literal to the given column type. Quotes
+    // around strings are stripped; returns false with a message in error if
+    // the text is not a valid value of that type
+    static bool parse(const std::string& text, ValueType type, int max_length,
+                      Value& value, std::string* error = nullptr);
+    // Converts an already typed literal to a column type, e.g. the INT
+    // literal 5 to DOUBLE or to the VARCHAR '5'; false if it does not fit
+    bool castTo(ValueType type, int max_length, Value& value, std::string* error = nullptr) const;
+    // Types a literal whose column is not known: quoted text is a string,
+    // digits an INT or DOUBLE, anything else a VARCHAR
+    static Value fromLiteral(const std::string& text);
+
+    ValueType getType() const { return type; }
+    bool isNull() const { return type == ValueType::NULL_VALUE; }
+    bool isNumeric() const { return type == ValueType::INT || type == ValueType::DOUBLE; }
+    bool isString() const { return type == ValueType::VARCHAR || type == ValueType::CHAR; }
+
+    int32_t asInt() const;
+    double asDouble() const;
+    const std::string& asString() const { return string_value; }
+    std::string toString() const;
+
+    // Numbers compare numerically across INT and DOUBLE and strings
+    // lexicographically; NULL sorts first, then numbers, then strings
+    int compare(const Value& other) const;
+    // Evaluates "this op other" for =, !=, <>, <, >, <=, >=
+    bool compare(const std::string& op, const Value& other) const;
+
+    bool operator==(const Value& other) const { return compare(other) == 0; }
+    bool operator!=(const Value& other) const { return compare(other) != 0; }
+    bool operator<(const Value& other) const { return compare(other) < 0; }
+    bool operator>(const Value& other) const { return compare(other) > 0; }
+    bool operator<=(const Value& other) const { return compare(other) <= 0; }
+    bool operator>=(const Value& other) const { return compare(other) >= 0; }
+
+    // Equal values hash equally, so 1 and 1.0 land in the same bucket
+    size_t hash() const;
+
+    size_t getSerializedSize() const;
+    size_t serialize(char* buffer) const;
+    // Returns the number of bytes consumed, or 0 if the buffer is malformed
+    size_t deserialize(const char* buffer, size_t buffer_size);
+    // Length of the serialized value at buffer without decoding it; 0 if
+    // the buffer is malformed
+    static size_t skip(const char* buffer, size_t buffer_size);
+
+private:
+    ValueType type;
+    union {
+        int32_t int_value;
+        double double_value;
+    };
+    std::string string_value;
+};
+
+std::ostream& operator<<(std::ostream& os, const Value& value);
+
+namespace std {
+    template <>
+    struct hash<Value> {
+        size_t operator()(const Value& value) const { return value.hash(); }
+    };
+}
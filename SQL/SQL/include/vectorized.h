@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include "operators.h"
+
+// Vectorized scan -> filter -> aggregate. Rows are read in batches of
+// BATCH_SIZE and stored column by column in typed contiguous arrays, so
+// predicates and aggregates run as tight loops over plain ints and doubles
+// (which the compiler can auto-vectorize) instead of building and
+// comparing a Value per row. A selection vector lists the rows of a batch
+// that are still alive after filtering. There are only comparison kernels:
+// the grammar has no arithmetic expressions, so nothing could use an
+// arithmetic one until the parser gains them.
+constexpr size_t BATCH_SIZE = 1024;
+
+struct ColumnVector {
+    ValueType type = ValueType::NULL_VALUE;  // declared column type
+    bool loaded = false;                     // false for columns the query does not read
+    std::vector<int32_t> ints;               // INT
+    std::vector<double> doubles;             // DOUBLE
+    std::vector<std::string> strings;        // VARCHAR, CHAR
+    std::vector<uint8_t> nulls;              // 1 where the value is NULL
+
+    Value get(size_t row) const;
+};
+
+struct RowBatch {
+    std::vector<ColumnVector> columns;
+    size_t size = 0;
+    std::vector<uint32_t> selection;  // rows that passed the filter, ascending
+    size_t selected = 0;
+};
+
+// Fills batches from a heap file, converting only the columns in the mask
+class BatchScanner {
+public:
+    BatchScanner(StorageManager* storage_manager, const std::string& data_file,
+                 const std::vector<ValueType>& types, const std::vector<bool>& mask);
+
+    void reset() { iterator.reset(); }
+    // Selects every row of the new batch; false once the file is exhausted
+    bool next(RowBatch& batch);
+
+private:
+    TableIterator iterator;
+    std::vector<ValueType> types;
+    std::vector<bool> mask;
+    Record record;
+};
+
+// A bound WHERE clause compiled to column kernels. Comparisons between a
+// column and a literal or between two columns of the same kind, combined
+// with AND, OR and NOT, are supported; NULL makes a comparison false, as
+// in Expression::isTrue.
+class BatchPredicate {
+public:
+    virtual ~BatchPredicate() = default;
+
+    // Null if the expression uses anything the kernels do not cover
+    static std::unique_ptr<BatchPredicate> compile(const Expression* expression,
+                                                   const std::vector<ValueType>& types);
+
+    // Sets mask[i] to 1 for each row i of the batch that satisfies the predicate
+    virtual void evaluate(const RowBatch& batch, uint8_t* mask) const = 0;
+    // Marks the columns the predicate reads
+    virtual void collectColumns(std::vector<bool>& mask) const = 0;
+};
+
+// Replaces SeqScan -> Filter -> Aggregate for a single table when WHERE
+// compiles to kernels and every GROUP BY key and aggregate argument is a
+// plain column. Produces the same rows as AggregateOperator.
+class BatchAggregateOperator : public Operator {
+public:
+    // Null if the query cannot run vectorized. where, group_by and the
+    // aggregate arguments must be bound to the table's schema.
+    static OperatorPtr create(StorageManager* storage_manager, const std::string& data_file,
+                              const TableInfo* table, const Expression* where,
+                              const std::vector<const Expression*>& group_by,
+                              const std::vector<const Expression*>& aggregates, const Schema& schema);
+
+    bool open() override;
+    bool next(Record& row) override;
+    void close() override;
+    std::string describe() const override { return description; }
+
+private:
+    BatchAggregateOperator(StorageManager* storage_manager, const std::string& data_file,
+                           const std::vector<ValueType>& types, const std::vector<bool>& mask,
+                           std::unique_ptr<BatchPredicate> predicate, std::vector<int> group_by,
+                           std::vector<std::string> functions, std::vector<int> arguments, Schema schema);
+
+    BatchScanner scanner;
+    std::unique_ptr<BatchPredicate> predicate;
+    std::vector<int> group_by;             // column of each GROUP BY key
+    std::vector<std::string> functions;    // COUNT, SUM, AVG, MIN or MAX
+    std::vector<int> arguments;            // column of each aggregate, -1 for COUNT(*)
+    std::map<std::vector<Value>, std::vector<Accumulator>> groups;
+    std::map<std::vector<Value>, std::vector<Accumulator>>::const_iterator position;
+    std::string description;
+};
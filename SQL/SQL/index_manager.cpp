@@ -1,5 +1,6 @@
 #include "index_manager.h"
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <map>
 #include <fstream>
@@ -8,42 +9,365 @@
 #include <vector>
 #include "database.h"
 #include <filesystem>
+#include <memory>
+#include <queue>
 
 // Forward declarations
 class BPlusTree;
 struct IndexNode;
 
+// Page 0 of every index file holds this header (after the page LSN); tree
+// nodes live on pages 1..n
+struct IndexMetaPage {
+    uint32_t magic;
+    int root_page_id;
+    int num_pages;
+    int unique;
+};
+
+// "BPT6"; "BPT5" entries had no included values, "BPT4" keys were a
+// single value, "BPT3" files only held int keys, "BPT2" leaves held only
+// the heap page of a row and "BPT1" files predate page LSNs. Older files
+// are rebuilt when a database opens.
+const uint32_t BPTREE_MAGIC = 0x42505436;
+
+// Largest serialized key and included values of one entry an index
+// accepts, e.g. two VARCHARs of 250 characters. Nodes split once they
+// could not take one more entry of this size.
+const size_t MAX_INDEX_KEY_SIZE = 512;
+const size_t MAX_INDEX_ENTRY_SIZE = MAX_INDEX_KEY_SIZE + 3 * sizeof(int);
+
 // IndexNode definition
 struct IndexNode {
     bool is_leaf;
     int next_leaf;
-    std::vector<int> keys;
-    std::vector<int> children;
-    
+    std::vector<IndexEntry> entries;
+    std::vector<int> children;  // child page ids (internal nodes only)
+
     IndexNode() : is_leaf(true), next_leaf(-1) {}
 };
 
+int compareKeys(const IndexKey& key, const IndexKey& other) {
+    size_t common = std::min(key.size(), other.size());
+    for (size_t i = 0; i < common; i++) {
+        int c = key[i].compare(other[i]);
+        if (c != 0) return c;
+    }
+    if (key.size() == other.size()) return 0;
+    return key.size() < other.size() ? -1 : 1;
+}
+
+int compareKeyPrefix(const IndexKey& key, const IndexKey& prefix) {
+    for (size_t i = 0; i < prefix.size() && i < key.size(); i++) {
+        int c = key[i].compare(prefix[i]);
+        if (c != 0) return c;
+    }
+    return 0;
+}
+
+namespace {
+    // Orders entries by key, then by row location
+    bool entryLess(const IndexEntry& a, const IndexEntry& b) {
+        int c = compareKeys(a.key, b.key);
+        if (c != 0) return c < 0;
+        if (a.rid.page_id != b.rid.page_id) return a.rid.page_id < b.rid.page_id;
+        return a.rid.slot < b.rid.slot;
+    }
+
+    // A value count, then each value
+    size_t keySize(const IndexKey& key) {
+        size_t size = 1;
+        for (const Value& value : key) {
+            size += value.getSerializedSize();
+        }
+        return size;
+    }
+
+    size_t entrySize(const IndexEntry& entry) {
+        return keySize(entry.key) + keySize(entry.included) + 2 * sizeof(int);
+    }
+
+    // Hash indexes are told apart by their file name (see indexFileName)
+    bool isHashFile(const std::string& path) {
+        const std::string suffix = ".hash.idx";
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // True for a range of exactly one whole key, the only one a hash index
+    // can answer
+    bool isPointRange(const KeyRange& range) {
+        return range.has_low && range.has_high && range.low_inclusive && range.high_inclusive &&
+               compareKeys(range.low, range.high) == 0;
+    }
+
+    bool hasNull(const IndexKey& key) {
+        return std::any_of(key.begin(), key.end(), [](const Value& value) { return value.isNull(); });
+    }
+
+    // Bytes serializeNode writes for node
+    size_t nodeSize(const IndexNode& node) {
+        size_t size = PAGE_LSN_SIZE + sizeof(bool) + 3 * sizeof(int) + node.children.size() * sizeof(int);
+        for (const IndexEntry& entry : node.entries) {
+            size += entrySize(entry);
+        }
+        return size;
+    }
+
+    // An entry as its key and its included values (each a uint8 value
+    // count and the serialized values) followed by its (page, slot);
+    // returns the bytes written, entrySize(entry)
+    size_t serializeEntry(const IndexEntry& entry, char* buffer) {
+        size_t offset = 0;
+        for (const IndexKey* values : {&entry.key, &entry.included}) {
+            buffer[offset++] = static_cast<char>(values->size());
+            for (const Value& value : *values) {
+                offset += value.serialize(buffer + offset);
+            }
+        }
+        memcpy(buffer + offset, &entry.rid.page_id, sizeof(int));
+        memcpy(buffer + offset + sizeof(int), &entry.rid.slot, sizeof(int));
+        return offset + 2 * sizeof(int);
+    }
+
+    // Returns the bytes read, or 0 if buffer does not hold a whole entry
+    size_t deserializeEntry(const char* buffer, size_t buffer_size, IndexEntry& entry) {
+        size_t offset = 0;
+        for (IndexKey* values : {&entry.key, &entry.included}) {
+            if (offset >= buffer_size) return 0;
+            values->resize(static_cast<uint8_t>(buffer[offset++]));
+            for (Value& value : *values) {
+                size_t used = value.deserialize(buffer + offset, buffer_size - offset);
+                if (used == 0) return 0;
+                offset += used;
+            }
+        }
+        if (offset + 2 * sizeof(int) > buffer_size) return 0;
+        memcpy(&entry.rid.page_id, buffer + offset, sizeof(int));
+        memcpy(&entry.rid.slot, buffer + offset + sizeof(int), sizeof(int));
+        return offset + 2 * sizeof(int);
+    }
+
+    // Serialized bytes of entries a bulk load sorts in memory before it
+    // spills them to a run file
+    const size_t SORT_RUN_BYTES = 16 * 1024 * 1024;
+
+    // External merge sort of index entries: entries are collected until
+    // they reach SORT_RUN_BYTES, then sorted and written to a run file
+    // next to the index; next() merges the runs. Inputs that fit in one
+    // run never touch the disk.
+    class EntrySorter {
+    public:
+        explicit EntrySorter(const std::string& run_prefix) : run_prefix(run_prefix) {}
+        ~EntrySorter() {
+            runs.clear();
+            for (size_t i = 0; i < num_runs; i++) {
+                std::filesystem::remove(runName(i));
+            }
+        }
+
+        bool add(IndexEntry entry) {
+            buffered_bytes += entrySize(entry);
+            buffer.push_back(std::move(entry));
+            return buffered_bytes < SORT_RUN_BYTES || spill();
+        }
+
+        // Call once every entry is added, before next()
+        bool finish() {
+            std::sort(buffer.begin(), buffer.end(), entryLess);
+            if (num_runs == 0) {
+                return true;
+            }
+            if (!buffer.empty() && !spill()) {
+                return false;
+            }
+            for (size_t i = 0; i < num_runs; i++) {
+                runs.emplace_back(runName(i), std::ios::binary);
+                IndexEntry entry;
+                if (!runs.back()) {
+                    std::cerr << "Failed to open sort run: " << runName(i) << std::endl;
+                    return false;
+                }
+                if (!readRun(i, entry)) {
+                    return false;  // Runs are never empty
+                }
+                heads.push(Head{std::move(entry), i});
+            }
+            return true;
+        }
+
+        // The entries in entryLess order; false once they are exhausted
+        // or a run file cannot be read
+        bool next(IndexEntry& entry) {
+            if (num_runs == 0) {
+                if (position == buffer.size()) return false;
+                entry = std::move(buffer[position++]);
+                return true;
+            }
+            if (heads.empty()) return false;
+            Head head = heads.top();
+            heads.pop();
+            entry = std::move(head.entry);
+            if (readRun(head.run, head.entry)) {
+                heads.push(std::move(head));
+            }
+            return true;
+        }
+
+        bool failed() const { return read_failed; }
+
+    private:
+        struct Head {
+            IndexEntry entry;
+            size_t run;
+            // Smallest entry on top of the priority queue
+            bool operator<(const Head& other) const { return entryLess(other.entry, entry); }
+        };
+
+        std::string run_prefix;
+        std::vector<IndexEntry> buffer;
+        size_t buffered_bytes = 0;
+        size_t position = 0;
+        size_t num_runs = 0;
+        std::vector<std::ifstream> runs;
+        std::priority_queue<Head> heads;
+        bool read_failed = false;
+
+        std::string runName(size_t run) const { return run_prefix + ".run" + std::to_string(run); }
+
+        // Each entry is stored as its uint16 length and serializeEntry bytes
+        bool spill() {
+            std::sort(buffer.begin(), buffer.end(), entryLess);
+            std::ofstream file(runName(num_runs), std::ios::binary | std::ios::trunc);
+            char data[MAX_INDEX_ENTRY_SIZE];
+            for (const IndexEntry& entry : buffer) {
+                uint16_t length = serializeEntry(entry, data);
+                file.write(reinterpret_cast<const char*>(&length), sizeof(uint16_t));
+                file.write(data, length);
+            }
+            num_runs++;
+            buffer.clear();
+            buffered_bytes = 0;
+            if (!file) {
+                std::cerr << "Failed to write sort run: " << runName(num_runs - 1) << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // False at the end of the run, or on a corrupt run (then failed())
+        bool readRun(size_t run, IndexEntry& entry) {
+            uint16_t length;
+            char data[MAX_INDEX_ENTRY_SIZE];
+            if (!runs[run].read(reinterpret_cast<char*>(&length), sizeof(uint16_t))) {
+                return false;
+            }
+            if (length > MAX_INDEX_ENTRY_SIZE || !runs[run].read(data, length) ||
+                deserializeEntry(data, length, entry) != length) {
+                std::cerr << "Corrupt sort run: " << runName(run) << std::endl;
+                read_failed = true;
+                return false;
+            }
+            return true;
+        }
+    };
+}
+
 // BPlusTree class definition
 class BPlusTree {
 private:
     StorageManager* storage_manager;
     std::string index_file;
-    int order;
     int root_page_id;
+    int num_pages;
+    bool unique;
 
-    bool insertNonFull(int page_id, int key, int value);
-    void splitNode(IndexNode& node, int page_id);
-    int searchInNode(int page_id, int key);
+    bool insertNonFull(int page_id, const IndexEntry& entry);
+    IndexEntry splitNode(IndexNode& node, int page_id, int& new_page_id);
+    int findLeaf(const IndexEntry* entry, IndexNode& node);
+    int allocatePage();
+    bool isFull(const IndexNode& node) const;
+    bool readNode(int page_id, IndexNode& node);
+    bool writeNode(int page_id, const IndexNode& node);
+    bool writeMeta();
     void serializeNode(const IndexNode& node, Page& page);
-    void deserializeNode(const Page& page, IndexNode& node);
+    bool deserializeNode(const Page& page, IndexNode& node);
+
+public:
+    BPlusTree(StorageManager* sm, const std::string& filename);
+    bool insert(const IndexKey& key, const RID& rid, const IndexKey& included);
+    bool remove(const IndexKey& key, const RID& rid);
+    bool search(const IndexKey& key, RID& rid);
+    bool exists(const IndexKey& key);
+    // Stops after limit matches
+    bool scanRange(const KeyRange& range, std::vector<IndexEntry>& result, size_t limit = SIZE_MAX);
+    bool scanRange(const KeyRange& range, std::vector<RID>& result);
+
+    static bool initialize(StorageManager* sm, const std::string& filename, bool unique);
+    // Writes a new tree bottom-up from entries next produces in entryLess
+    // order
+    static bool build(StorageManager* sm, const std::string& filename, bool unique,
+                      const std::function<bool(IndexEntry&)>& next);
+    static bool isValid(StorageManager* sm, const std::string& filename);
+};
+
+// Extendible hash index. Page 0 holds the header; the directory of
+// 2^global_depth bucket page ids fills consecutive pages after it, slot i
+// belonging to the keys whose hash ends in the bits of i. A bucket whose
+// page fills up is split on one more hash bit, doubling the directory
+// when the bucket already uses every bit. Keys that share a whole hash
+// (duplicates of a non-unique index) cannot be split apart and go to
+// overflow pages chained from the bucket. A lookup reads one directory
+// page and the key's bucket; an insert into a non-unique index reads the
+// bucket's first and last pages only, so long duplicate chains stay cheap
+// to grow.
+class HashIndex {
+private:
+    // A bucket page or one of its overflow pages
+    struct Bucket {
+        int local_depth = 0;  // hash bits every key on the page shares
+        int next_overflow = -1;
+        int last_overflow = -1;  // first page of a chain only: its last page
+        std::vector<IndexEntry> entries;
+    };
+
+    StorageManager* storage_manager;
+    std::string index_file;
+    int global_depth;
+    int num_pages;
+    bool unique;
+    int directory_page;
+    int directory_pages;
+
+    int getSlot(uint32_t slot);
+    bool setSlots(uint32_t first, uint32_t step, int page_id);
+    bool doubleDirectory();
+    bool readChain(int page_id, std::vector<int>& pages, std::vector<Bucket>& buckets);
+    bool writeChain(int page_id, int local_depth, std::vector<IndexEntry>& entries, std::vector<int>& spare);
+    bool split(int page_id, uint32_t hash);
+    int allocatePage();
+    bool readBucket(int page_id, Bucket& bucket);
+    bool writeBucket(int page_id, const Bucket& bucket);
+    bool writeMeta();
 
 public:
-    BPlusTree(StorageManager* sm, const std::string& filename, int tree_order);
-    bool insert(int key, int value);
-    int search(int key);
-    bool exists(int key);
+    HashIndex(StorageManager* sm, const std::string& filename);
+    bool insert(const IndexEntry& entry);
+    bool remove(const IndexKey& key, const RID& rid);
+    // Entries with key in row location order, stopping after limit
+    bool find(const IndexKey& key, std::vector<IndexEntry>& result, size_t limit = SIZE_MAX);
+
+    static bool initialize(StorageManager* sm, const std::string& filename, bool unique);
+    static bool isValid(StorageManager* sm, const std::string& filename);
 };
 
+// Resolve index paths given relative to ./data/
+static std::string getFullPath(const std::string& path) {
+    if (path.substr(0, 7) == "./data/") {
+        return path;
+    }
+    return "./data/" + path;
+}
+
 // IndexManager implementation
 IndexManager::IndexManager(StorageManager* storage_manager) 
     : storage_manager(storage_manager) {
@@ -54,41 +378,89 @@ IndexManager::~IndexManager() {
 
 bool IndexManager::createIndex(const std::string& db_name,
                              const std::string& table_name,
-                             const std::string& column_name) {
-    std::string index_file = "./data/" + db_name + "/" + table_name + "_" + column_name + ".idx";
+                             const std::vector<std::string>& columns,
+                             bool unique,
+                             bool hash) {
+    std::string index_file = "./data/" + db_name + "/" + indexFileName(table_name, columns, hash);
     
     std::cout << "Creating index file: " << index_file << std::endl;
     
-    // Create empty index file
-    std::ofstream file(index_file, std::ios::binary);
-    if (!file) {
+    bool created = hash ? HashIndex::initialize(storage_manager, index_file, unique)
+                        : BPlusTree::initialize(storage_manager, index_file, unique);
+    if (!created) {
         std::cerr << "Failed to create index file: " << index_file << std::endl;
         return false;
     }
     
-    file.close();
-    
-    std::cout << "Successfully created file: " << index_file << std::endl;
-    
-    // For backward compatibility, still call writePage
-    Page page;
-    page.clear();
-    page.setNumKeys(0);
-    
-    if (!storage_manager->writePage(index_file, 0, page)) {
-        std::cerr << "Failed to write index page" << std::endl;
-        return false;
-    }
-    
     std::cout << "Successfully created index file" << std::endl;
     return true;
 }
 
+bool IndexManager::bulkLoad(const std::string& db_name,
+                            const std::string& table_name,
+                            const std::vector<std::string>& columns,
+                            bool unique,
+                            bool hash,
+                            const std::function<bool(IndexEntry&)>& next) {
+    std::string index_file = "./data/" + db_name + "/" + indexFileName(table_name, columns, hash);
+
+    std::cout << "Building index file: " << index_file << std::endl;
+
+    // Hash buckets take the entries in any order; the tree is built from
+    // sorted ones
+    EntrySorter sorter(index_file);
+    std::unique_ptr<HashIndex> hash_index;
+    try {
+        if (hash) {
+            if (!HashIndex::initialize(storage_manager, index_file, unique)) {
+                std::cerr << "Failed to create index file: " << index_file << std::endl;
+                return false;
+            }
+            hash_index = std::make_unique<HashIndex>(storage_manager, index_file);
+        }
+
+        IndexEntry entry;
+        size_t count = 0;
+        while (next(entry)) {
+            if (hasNull(entry.key)) {
+                continue;
+            }
+            if (keySize(entry.key) + keySize(entry.included) > MAX_INDEX_KEY_SIZE) {
+                std::cerr << "Key too long for index: " << index_file << std::endl;
+                return false;
+            }
+            if (!(hash_index ? hash_index->insert(entry) : sorter.add(std::move(entry)))) {
+                return false;
+            }
+            count++;
+        }
+
+        if (!hash_index) {
+            if (!sorter.finish()) {
+                return false;
+            }
+            auto sorted = [&sorter](IndexEntry& out) { return sorter.next(out); };
+            if (!BPlusTree::build(storage_manager, index_file, unique, sorted) || sorter.failed()) {
+                std::cerr << "Failed to build index file: " << index_file << std::endl;
+                return false;
+            }
+        }
+
+        std::cout << "Indexed " << count << " rows" << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error building index: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool IndexManager::dropIndex(const std::string& db_name, 
                            const std::string& table_name, 
-                           const std::string& column_name) {
-    std::string index_file = "./data/" + db_name + "/" + table_name + "_" + column_name + ".idx";
+                           const std::vector<std::string>& columns,
+                           bool hash) {
+    std::string index_file = "./data/" + db_name + "/" + indexFileName(table_name, columns, hash);
     
+    storage_manager->discardFile(index_file);
     if (std::remove(index_file.c_str()) != 0) {
         std::cerr << "Failed to remove index file: " << index_file << std::endl;
         return false;
@@ -97,479 +469,1124 @@ bool IndexManager::dropIndex(const std::string& db_name,
     return true;
 }
 
-bool IndexManager::insert(const std::string& index_file, int key, const Record& record) {
-    // Fix path to include ./data/ prefix if not already included
-    std::string full_path = index_file;
-    if (full_path.substr(0, 7) != "./data/") {
-        full_path = "./data/" + index_file;
-    }
-    
-    std::cout << "Inserting into index file: " << full_path << std::endl;
-    
-    // Load all existing keys from index
-    std::vector<int> keys;
-    std::vector<Record> records;
-    
-    if (std::filesystem::exists(full_path)) {
-        std::ifstream file(full_path, std::ios::binary);
-        if (file) {
-            // Read all keys from index
-            int k;
-            while (file >> k) {
-                keys.push_back(k);
-                file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            }
-            file.close();
-        }
-    }
-    
-    // Add the new key if it doesn't exist
-    if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
-        keys.push_back(key);
-        records.push_back(record);
+bool IndexManager::isValidIndex(const std::string& index_file) {
+    std::string full_path = getFullPath(index_file);
+    return isHashFile(full_path) ? HashIndex::isValid(storage_manager, full_path)
+                                 : BPlusTree::isValid(storage_manager, full_path);
+}
+
+bool IndexManager::insert(const std::string& index_file, const IndexKey& key, const RID& rid,
+                          const IndexKey& included) {
+    std::string full_path = getFullPath(index_file);
+    if (hasNull(key)) {
+        return true;
     }
-    
-    // Write keys back to index file
-    std::ofstream out_file(full_path, std::ios::binary);
-    if (!out_file) {
-        std::cerr << "Failed to open index file for writing: " << full_path << std::endl;
+    if (keySize(key) + keySize(included) > MAX_INDEX_KEY_SIZE) {
+        std::cerr << "Key too long for index: " << full_path << std::endl;
         return false;
     }
     
-    // Sort keys for faster searching
-    std::sort(keys.begin(), keys.end());
-    
-    for (int k : keys) {
-        out_file << k << std::endl;
+    // Missing indexes are built when the database is opened (see
+    // Database::rebuildIndexes), which knows whether they are unique
+    if (!std::filesystem::exists(full_path)) {
+        std::cerr << "Index file does not exist: " << full_path << std::endl;
+        return false;
     }
-    
-    out_file.close();
-    if (!out_file) {
-        std::cerr << "Error writing to index file" << std::endl;
+
+    try {
+        bool hash = isHashFile(full_path);
+        bool inserted = false;
+        if (hash) {
+            HashIndex index(storage_manager, full_path);
+            inserted = index.insert(IndexEntry{key, included, rid});
+        } else {
+            BPlusTree tree(storage_manager, full_path);
+            inserted = tree.insert(key, rid, included);
+        }
+        if (!inserted) {
+            std::cerr << "Failed to insert key " << key.front() << " into index: " << full_path << std::endl;
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error inserting into index: " << e.what() << std::endl;
         return false;
     }
-    
-    std::cout << "Successfully updated index file with key: " << key << std::endl;
-    return true;
 }
 
-bool IndexManager::exists(const std::string& index_file, int key) {
-    // Fix path to include ./data/ prefix if not already included
-    std::string full_path = index_file;
-    if (full_path.substr(0, 7) != "./data/") {
-        full_path = "./data/" + index_file;
-    }
+bool IndexManager::exists(const std::string& index_file, const IndexKey& key) {
+    RID rid;
+    std::string full_path = getFullPath(index_file);
     
     if (!std::filesystem::exists(full_path)) {
         std::cout << "Index file does not exist: " << full_path << std::endl;
         return false;
     }
     
-    std::ifstream file(full_path, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open index file: " << full_path << std::endl;
+    return lookup(full_path, key, rid);
+}
+
+bool IndexManager::lookup(const std::string& index_file, const IndexKey& key, RID& rid) {
+    std::string full_path = getFullPath(index_file);
+
+    if (!std::filesystem::exists(full_path)) {
         return false;
     }
-    
-    int k;
-    while (file >> k) {
-        if (k == key) {
-            file.close();
+
+    try {
+        if (isHashFile(full_path)) {
+            HashIndex index(storage_manager, full_path);
+            std::vector<IndexEntry> found;
+            if (!index.find(key, found, 1) || found.empty()) {
+                return false;
+            }
+            rid = found.front().rid;
             return true;
         }
-        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        BPlusTree tree(storage_manager, full_path);
+        return tree.search(key, rid);
+    } catch (const std::exception& e) {
+        std::cerr << "Error searching index: " << e.what() << std::endl;
+        return false;
     }
-    
-    file.close();
-    return false;
 }
 
-bool IndexManager::search(const std::string& index_file, 
-                        const std::string& op, 
-                        int value, 
-                        std::vector<int>& result) {
-    if (!std::filesystem::exists(index_file)) {
-        std::cout << "Index file does not exist: " << index_file << std::endl;
+bool IndexManager::scanRange(const std::string& index_file, const KeyRange& range, std::vector<RID>& result) {
+    std::vector<IndexEntry> entries;
+    if (!scanEntries(index_file, range, entries)) {
         return false;
     }
-    
-    std::ifstream file(index_file, std::ios::binary);
-    if (!file) {
-        std::cerr << "Failed to open index file: " << index_file << std::endl;
+    for (const IndexEntry& entry : entries) {
+        result.push_back(entry.rid);
+    }
+    return true;
+}
+
+bool IndexManager::scanEntries(const std::string& index_file, const KeyRange& range,
+                               std::vector<IndexEntry>& result) {
+    std::string full_path = getFullPath(index_file);
+
+    if (!std::filesystem::exists(full_path)) {
         return false;
     }
-    
-    // Read all keys from index
-    std::vector<int> all_keys;
-    int k;
-    while (file >> k) {
-        all_keys.push_back(k);
-        file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    try {
+        if (isHashFile(full_path)) {
+            if (!isPointRange(range)) {
+                std::cerr << "Hash index supports only equality: " << full_path << std::endl;
+                return false;
+            }
+            HashIndex index(storage_manager, full_path);
+            return index.find(range.low, result);
+        }
+        BPlusTree tree(storage_manager, full_path);
+        return tree.scanRange(range, result);
+    } catch (const std::exception& e) {
+        std::cerr << "Error scanning index: " << e.what() << std::endl;
+        return false;
     }
-    file.close();
-    
-    std::cout << "Found " << all_keys.size() << " records in index" << std::endl;
-    
-    // Filter keys based on operator
-    for (int key : all_keys) {
-        bool match = false;
-        
-        if (op == "=") match = (key == value);
-        else if (op == "<") match = (key < value);
-        else if (op == ">") match = (key > value);
-        else if (op == "<=") match = (key <= value);
-        else if (op == ">=") match = (key >= value);
-        else if (op == "!=") match = (key != value);
-        
-        if (match) {
-            result.push_back(key);
+}
+
+bool IndexManager::remove(const std::string& index_file, const IndexKey& key, const RID& rid) {
+    std::string full_path = getFullPath(index_file);
+
+    if (hasNull(key)) {
+        return true;  // NULL keys are never indexed
+    }
+    if (!std::filesystem::exists(full_path)) {
+        std::cerr << "Index file does not exist: " << full_path << std::endl;
+        return false;
+    }
+
+    try {
+        if (isHashFile(full_path)) {
+            HashIndex index(storage_manager, full_path);
+            return index.remove(key, rid);
         }
+        BPlusTree tree(storage_manager, full_path);
+        return tree.remove(key, rid);
+    } catch (const std::exception& e) {
+        std::cerr << "Error removing key from index: " << e.what() << std::endl;
+        return false;
     }
-    
-    std::cout << "Found " << result.size() << " matching records" << std::endl;
-    return true;
 }
 
 // BPlusTree implementation
-BPlusTree::BPlusTree(StorageManager* sm, const std::string& filename, int tree_order) 
-    : storage_manager(sm), index_file(filename), order(tree_order) {
-    try {
-        std::cout << "Initializing B+ tree for file: " << filename << std::endl;
-        
-        Page root_page;
-        bool root_exists = storage_manager->readPage(index_file, 0, root_page);
-        
-        if (!root_exists) {
-            std::cout << "Creating new root node" << std::endl;
-    // Initialize empty root node
+BPlusTree::BPlusTree(StorageManager* sm, const std::string& filename) 
+    : storage_manager(sm), index_file(filename) {
+    Page meta_page;
+    if (!storage_manager->readPage(index_file, 0, meta_page)) {
+        throw std::runtime_error("Failed to read index header: " + index_file);
+    }
+
+    IndexMetaPage meta;
+    meta_page.readData(PAGE_LSN_SIZE, &meta, sizeof(IndexMetaPage));
+    if (meta.magic != BPTREE_MAGIC) {
+        throw std::runtime_error("Not a B+ tree index file: " + index_file);
+    }
+
+    root_page_id = meta.root_page_id;
+    num_pages = meta.num_pages;
+    unique = meta.unique != 0;
+}
+
+bool BPlusTree::initialize(StorageManager* sm, const std::string& filename, bool unique) {
+    // Create (or truncate) the file so writePage can open it
+    sm->discardFile(filename);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.close();
+
+    // Header page followed by an empty root leaf on page 1
+    IndexMetaPage meta;
+    meta.magic = BPTREE_MAGIC;
+    meta.root_page_id = 1;
+    meta.num_pages = 2;
+    meta.unique = unique ? 1 : 0;
+
+    Page meta_page;
+    meta_page.writeData(PAGE_LSN_SIZE, &meta, sizeof(IndexMetaPage));
+    if (!sm->writePage(filename, 0, meta_page)) {
+        return false;
+    }
+
+    BPlusTree tree(sm, filename);
     IndexNode root;
-    root.is_leaf = true;
-    root.next_leaf = -1;
-    
-            // Initialize the page
-            root_page.clear();
-            root_page.setFreeSpace(PAGE_SIZE);
-            
-            serializeNode(root, root_page);
-            if (!storage_manager->writePage(index_file, 0, root_page)) {
-                throw std::runtime_error("Failed to write initial root page");
+    return tree.writeNode(1, root);
+}
+
+bool BPlusTree::isValid(StorageManager* sm, const std::string& filename) {
+    if (!std::filesystem::exists(filename)) {
+        return false;
+    }
+    Page meta_page;
+    if (!sm->readPage(filename, 0, meta_page)) {
+        return false;
+    }
+    IndexMetaPage meta;
+    meta_page.readData(PAGE_LSN_SIZE, &meta, sizeof(IndexMetaPage));
+    return meta.magic == BPTREE_MAGIC;
+}
+
+// Leaves are filled to the page in key order on pages 1, 2, ..., so a
+// range scan reads them sequentially; each level of internal nodes is then
+// built over the one below until a single root is left. Every page is
+// written once, where inserting the entries one by one would descend the
+// tree and rewrite a leaf for each.
+bool BPlusTree::build(StorageManager* sm, const std::string& filename, bool unique,
+                      const std::function<bool(IndexEntry&)>& next) {
+    if (!initialize(sm, filename, unique)) {
+        return false;
+    }
+    BPlusTree tree(sm, filename);
+
+    // The first entry under each node of the level being built and the
+    // node's page; the parent level separates its children by them
+    std::vector<IndexEntry> lows;
+    std::vector<int> pages;
+
+    IndexNode leaf;
+    size_t leaf_size = nodeSize(leaf);
+    int page_id = 1;
+    IndexKey previous_key;
+    IndexEntry entry;
+    while (next(entry)) {
+        if (unique && !previous_key.empty() && compareKeys(entry.key, previous_key) == 0) {
+            std::cerr << "Duplicate key " << entry.key.front() << " in unique index: " << filename << std::endl;
+            return false;
+        }
+        if (unique) {
+            previous_key = entry.key;
+        }
+
+        if (!leaf.entries.empty() && leaf_size + entrySize(entry) > PAGE_SIZE_BYTES) {
+            leaf.next_leaf = page_id + 1;
+            if (!tree.writeNode(page_id, leaf)) {
+                return false;
             }
+            lows.push_back(IndexEntry{leaf.entries.front().key, IndexKey(), leaf.entries.front().rid});
+            pages.push_back(page_id++);
+            leaf.entries.clear();
+            leaf_size = nodeSize(leaf);
         }
-    root_page_id = 0;
-        std::cout << "B+ tree initialized successfully" << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "Error initializing B+ tree: " << e.what() << std::endl;
-        throw;
+        leaf_size += entrySize(entry);
+        leaf.entries.push_back(std::move(entry));
+    }
+    leaf.next_leaf = -1;
+    if (!tree.writeNode(page_id, leaf)) {
+        return false;
+    }
+    if (!leaf.entries.empty()) {
+        lows.push_back(IndexEntry{leaf.entries.front().key, IndexKey(), leaf.entries.front().rid});
+    }
+    pages.push_back(page_id);
+    tree.num_pages = page_id + 1;
+
+    while (pages.size() > 1) {
+        std::vector<IndexNode> nodes;
+        std::vector<IndexEntry> node_lows;
+        size_t size = 0;
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (!nodes.empty() && size + entrySize(lows[i]) + sizeof(int) <= PAGE_SIZE_BYTES) {
+                size += entrySize(lows[i]) + sizeof(int);
+                nodes.back().entries.push_back(lows[i]);
+                nodes.back().children.push_back(pages[i]);
+                continue;
+            }
+            nodes.emplace_back();
+            nodes.back().is_leaf = false;
+            nodes.back().children.push_back(pages[i]);
+            node_lows.push_back(lows[i]);
+            size = nodeSize(nodes.back());
+        }
+
+        // A last node left with a single child takes one from its neighbour
+        if (nodes.size() > 1 && nodes.back().children.size() == 1) {
+            IndexNode& neighbour = nodes[nodes.size() - 2];
+            IndexNode& last = nodes.back();
+            last.entries.insert(last.entries.begin(), node_lows.back());
+            last.children.insert(last.children.begin(), neighbour.children.back());
+            node_lows.back() = neighbour.entries.back();
+            neighbour.entries.pop_back();
+            neighbour.children.pop_back();
+        }
+
+        pages.clear();
+        for (const IndexNode& node : nodes) {
+            int node_page = tree.num_pages++;
+            if (!tree.writeNode(node_page, node)) {
+                return false;
+            }
+            pages.push_back(node_page);
+        }
+        lows = std::move(node_lows);
+    }
+
+    tree.root_page_id = pages.front();
+    return tree.writeMeta();
+}
+
+bool BPlusTree::writeMeta() {
+    IndexMetaPage meta;
+    meta.magic = BPTREE_MAGIC;
+    meta.root_page_id = root_page_id;
+    meta.num_pages = num_pages;
+    meta.unique = unique ? 1 : 0;
+
+    Page meta_page;
+    meta_page.writeData(PAGE_LSN_SIZE, &meta, sizeof(IndexMetaPage));
+    return storage_manager->writePage(index_file, 0, meta_page);
+}
+
+int BPlusTree::allocatePage() {
+    int page_id = num_pages++;
+    if (!writeMeta()) {
+        throw std::runtime_error("Failed to update index header");
     }
+    return page_id;
+}
+
+// Full once the node could not take one more entry of the largest size,
+// so a split always leaves room in the half the insert descends into
+bool BPlusTree::isFull(const IndexNode& node) const {
+    return nodeSize(node) + MAX_INDEX_ENTRY_SIZE > PAGE_SIZE_BYTES;
+}
+
+bool BPlusTree::readNode(int page_id, IndexNode& node) {
+    Page page;
+    if (!storage_manager->readPage(index_file, page_id, page)) {
+        return false;
+    }
+    return deserializeNode(page, node);
+}
+
+bool BPlusTree::writeNode(int page_id, const IndexNode& node) {
+    Page page;
+    serializeNode(node, page);
+    return storage_manager->writePage(index_file, page_id, page);
 }
 
-bool BPlusTree::exists(int key) {
-    return search(key) != -1;
+bool BPlusTree::exists(const IndexKey& key) {
+    RID rid;
+    return search(key, rid);
 }
 
-bool BPlusTree::insert(int key, int value) {
+bool BPlusTree::insert(const IndexKey& key, const RID& rid, const IndexKey& included) {
     try {
-        std::cout << "Inserting key: " << key << " with value: " << value << std::endl;
-        
-        // Read root page
-        Page root_page;
-        if (!storage_manager->readPage(index_file, root_page_id, root_page)) {
+        if (unique && exists(key)) {
+            std::cerr << "Duplicate key " << key.front() << " in unique index: " << index_file << std::endl;
+            return false;
+        }
+
+        IndexNode root;
+        if (!readNode(root_page_id, root)) {
             throw std::runtime_error("Failed to read root page during insert");
         }
 
-    IndexNode root;
-    deserializeNode(root_page, root);
-
-        // If root is full, create new root
-        if (static_cast<int>(root.keys.size()) == (2 * order - 1)) {
-            std::cout << "Splitting root node" << std::endl;
-            
-            // Create new root
-        IndexNode new_root;
-        new_root.is_leaf = false;
-        new_root.children.push_back(root_page_id);
-
-            // Save old root
-            Page old_root_page;
-            serializeNode(root, old_root_page);
-            if (!storage_manager->writePage(index_file, root_page_id + 1, old_root_page)) {
-                throw std::runtime_error("Failed to write old root during split");
-            }
-
-            // Split old root
-            splitNode(root, root_page_id + 1);
-
-            // Save new root
-            Page new_root_page;
-            serializeNode(new_root, new_root_page);
-            if (!storage_manager->writePage(index_file, root_page_id, new_root_page)) {
+        // Split a full root first so the descent below never meets a full node
+        if (isFull(root)) {
+            int new_page_id;
+            IndexEntry separator = splitNode(root, root_page_id, new_page_id);
+
+            IndexNode new_root;
+            new_root.is_leaf = false;
+            new_root.entries.push_back(separator);
+            new_root.children.push_back(root_page_id);
+            new_root.children.push_back(new_page_id);
+
+            int new_root_id = allocatePage();
+            if (!writeNode(new_root_id, new_root)) {
                 throw std::runtime_error("Failed to write new root");
             }
-    }
+            root_page_id = new_root_id;
+            if (!writeMeta()) {
+                throw std::runtime_error("Failed to update index header");
+            }
+        }
 
-    return insertNonFull(root_page_id, key, value);
+        return insertNonFull(root_page_id, IndexEntry{key, included, rid});
     } catch (const std::exception& e) {
         std::cerr << "Error in insert: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool BPlusTree::insertNonFull(int page_id, int key, int value) {
-    try {
-    Page current_page;
-        if (!storage_manager->readPage(index_file, page_id, current_page)) {
-            throw std::runtime_error("Failed to read page during insert");
-        }
-
+bool BPlusTree::insertNonFull(int page_id, const IndexEntry& entry) {
     IndexNode node;
-    deserializeNode(current_page, node);
+    if (!readNode(page_id, node)) {
+        throw std::runtime_error("Failed to read page during insert");
+    }
 
-        // If this is a leaf node
     if (node.is_leaf) {
-            // Insert key and value
-            auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
-            size_t pos = it - node.keys.begin();
-            
-            node.keys.insert(it, key);
-            node.children.insert(node.children.begin() + pos, value);
-
-        serializeNode(node, current_page);
-            return storage_manager->writePage(index_file, page_id, current_page);
+        auto it = std::lower_bound(node.entries.begin(), node.entries.end(), entry, entryLess);
+        if (it != node.entries.end() && !entryLess(entry, *it)) {
+            return false;  // The row is already indexed
         }
+        node.entries.insert(it, entry);
+        return writeNode(page_id, node);
+    }
 
-        // If this is not a leaf node
-        int i = node.keys.size() - 1;
-        while (i >= 0 && key < node.keys[i]) {
-            i--;
-        }
-        i++;
+    // Entries equal to a separator live in the right subtree
+    size_t i = std::upper_bound(node.entries.begin(), node.entries.end(), entry, entryLess) - node.entries.begin();
 
-        Page child_page;
-        if (!storage_manager->readPage(index_file, node.children[i], child_page)) {
-            throw std::runtime_error("Failed to read child page");
-        }
+    IndexNode child;
+    if (!readNode(node.children[i], child)) {
+        throw std::runtime_error("Failed to read child page");
+    }
 
-        IndexNode child;
-        deserializeNode(child_page, child);
+    if (isFull(child)) {
+        int new_page_id;
+        IndexEntry separator = splitNode(child, node.children[i], new_page_id);
 
-        if (static_cast<int>(child.keys.size()) == (2 * order - 1)) {
-            splitNode(child, node.children[i]);
-            if (key > node.keys[i]) {
-                i++;
-            }
+        node.entries.insert(node.entries.begin() + i, separator);
+        node.children.insert(node.children.begin() + i + 1, new_page_id);
+        if (!writeNode(page_id, node)) {
+            throw std::runtime_error("Failed to write parent after split");
         }
 
-        return insertNonFull(node.children[i], key, value);
-    } catch (const std::exception& e) {
-        std::cerr << "Error in insertNonFull: " << e.what() << std::endl;
-        return false;
+        if (!entryLess(entry, separator)) {
+            i++;
+        }
     }
+
+    return insertNonFull(node.children[i], entry);
 }
 
-void BPlusTree::splitNode(IndexNode& node, int page_id) {
-    try {
+// Splits node (stored at page_id) into halves of about equal bytes, writes
+// both and returns the separator the parent must insert in front of
+// new_page_id
+IndexEntry BPlusTree::splitNode(IndexNode& node, int page_id, int& new_page_id) {
     IndexNode new_node;
     new_node.is_leaf = node.is_leaf;
+    new_page_id = allocatePage();
 
-        int mid = order - 1;
-    
-    // Move half of the keys to new node
-    new_node.keys.assign(node.keys.begin() + mid + 1, node.keys.end());
-    node.keys.resize(mid);
-
-    // Move half of the children to new node
-    if (!node.is_leaf) {
-        new_node.children.assign(node.children.begin() + mid + 1, 
-                               node.children.end());
-        node.children.resize(mid + 1);
+    size_t total = 0;
+    for (const IndexEntry& entry : node.entries) {
+        total += entrySize(entry);
     }
+    size_t mid = 0;
+    size_t left = 0;
+    while (mid < node.entries.size() && 2 * (left + entrySize(node.entries[mid])) <= total) {
+        left += entrySize(node.entries[mid++]);
+    }
+    // Both halves keep at least one entry; an internal node also gives one up
+    size_t last = node.entries.size() - (node.is_leaf ? 1 : 2);
+    mid = std::max<size_t>(1, std::min(mid, last));
 
-    // Handle leaf node connections
+    IndexEntry separator;
     if (node.is_leaf) {
+        // Leaves keep every entry; the first entry of the right half is copied up
+        new_node.entries.assign(node.entries.begin() + mid, node.entries.end());
+        node.entries.resize(mid);
+        separator = new_node.entries.front();
+        separator.included.clear();
+
         new_node.next_leaf = node.next_leaf;
-        node.next_leaf = page_id + 1;
+        node.next_leaf = new_page_id;
+    } else {
+        // Internal nodes move the middle entry up
+        separator = node.entries[mid];
+        new_node.entries.assign(node.entries.begin() + mid + 1, node.entries.end());
+        new_node.children.assign(node.children.begin() + mid + 1, node.children.end());
+        node.entries.resize(mid);
+        node.children.resize(mid + 1);
     }
 
-    // Save both nodes
-    Page page, new_page;
-    serializeNode(node, page);
-    serializeNode(new_node, new_page);
-        
-        if (!storage_manager->writePage(index_file, page_id, page)) {
-            throw std::runtime_error("Failed to write split node");
+    if (!writeNode(page_id, node)) {
+        throw std::runtime_error("Failed to write split node");
+    }
+    if (!writeNode(new_page_id, new_node)) {
+        throw std::runtime_error("Failed to write new split node");
+    }
+    return separator;
+}
+
+bool BPlusTree::search(const IndexKey& key, RID& rid) {
+    KeyRange range;
+    range.has_low = range.has_high = true;
+    range.low = range.high = key;
+
+    std::vector<IndexEntry> found;
+    if (!scanRange(range, found, 1) || found.empty()) {
+        return false;
+    }
+    rid = found.front().rid;
+    return true;
+}
+
+// Returns the page id of the leaf that would hold entry, or of the leftmost
+// leaf for a null entry, and reads that leaf into node
+int BPlusTree::findLeaf(const IndexEntry* entry, IndexNode& node) {
+    int page_id = root_page_id;
+    while (true) {
+        if (!readNode(page_id, node)) {
+            throw std::runtime_error("Failed to read page during search");
         }
-        if (!storage_manager->writePage(index_file, page_id + 1, new_page)) {
-            throw std::runtime_error("Failed to write new split node");
+        if (node.is_leaf) {
+            return page_id;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error in splitNode: " << e.what() << std::endl;
-        throw;
+        size_t i = entry ? std::upper_bound(node.entries.begin(), node.entries.end(), *entry, entryLess) -
+                               node.entries.begin()
+                         : 0;
+        page_id = node.children[i];
     }
 }
 
-int BPlusTree::search(int key) {
+bool BPlusTree::remove(const IndexKey& key, const RID& rid) {
+    // Lazy deletion: the entry is dropped from its leaf and underfull
+    // nodes are left in place rather than merged
+    IndexEntry target{key, IndexKey(), rid};
+    IndexNode leaf;
+    int leaf_id;
     try {
-    return searchInNode(root_page_id, key);
+        leaf_id = findLeaf(&target, leaf);
     } catch (const std::exception& e) {
-        std::cerr << "Error in search: " << e.what() << std::endl;
-        return -1;
+        std::cerr << "Error in remove: " << e.what() << std::endl;
+        return false;
     }
-}
 
-int BPlusTree::searchInNode(int page_id, int key) {
-    Page current_page;
-    if (!storage_manager->readPage(index_file, page_id, current_page)) {
-        throw std::runtime_error("Failed to read page during search");
+    auto it = std::lower_bound(leaf.entries.begin(), leaf.entries.end(), target, entryLess);
+    if (it == leaf.entries.end() || entryLess(target, *it)) {
+        return true;  // No such entry
     }
 
+    leaf.entries.erase(it);
+    return writeNode(leaf_id, leaf);
+}
+
+// Seeks to the leaf that would hold the lower bound and follows the leaf
+// chain until the first key past the upper bound
+bool BPlusTree::scanRange(const KeyRange& range, std::vector<IndexEntry>& result, size_t limit) {
+    // A prefix sorts before every key it starts and RID() before every
+    // real row location, so the seek lands on the first entry of the lower
+    // bound. An exclusive bound skips the entries equal to it on the walk.
+    IndexEntry low{range.low, IndexKey(), RID()};
     IndexNode node;
-    deserializeNode(current_page, node);
+    try {
+        findLeaf(range.has_low ? &low : nullptr, node);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in scan: " << e.what() << std::endl;
+        return false;
+    }
 
-    if (node.is_leaf) {
-        auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
-        if (it != node.keys.end() && *it == key) {
-            return node.children[it - node.keys.begin()];
+    size_t matched = 0;
+    while (true) {
+        for (const IndexEntry& entry : node.entries) {
+            if (range.isPastEnd(entry.key)) {
+                return true;
+            }
+            if (range.contains(entry.key)) {
+                result.push_back(entry);
+                if (++matched == limit) {
+                    return true;
+                }
+            }
+        }
+        if (node.next_leaf == -1) {
+            return true;
+        }
+        if (!readNode(node.next_leaf, node)) {
+            return false;
         }
-        return -1;
     }
+}
 
-    int i = 0;
-    while (i < static_cast<int>(node.keys.size()) && key > node.keys[i]) {
-        i++;
+bool BPlusTree::scanRange(const KeyRange& range, std::vector<RID>& result) {
+    std::vector<IndexEntry> entries;
+    if (!scanRange(range, entries)) {
+        return false;
     }
-
-    return searchInNode(node.children[i], key);
+    for (const IndexEntry& entry : entries) {
+        result.push_back(entry.rid);
+    }
+    return true;
 }
 
+// Layout after the page LSN: is_leaf, next_leaf, the entry count, each
+// entry as serializeEntry writes it, then the child count and child page
+// ids
 void BPlusTree::serializeNode(const IndexNode& node, Page& page) {
-    try {
-        // Clear the page
-        page.clear();
-        
-        // Write is_leaf flag
-        page.writeData(0, &node.is_leaf, sizeof(bool));
-        
-        // Write next_leaf
-        page.writeData(sizeof(bool), &node.next_leaf, sizeof(int));
-        
-        // Write number of keys
-    int num_keys = node.keys.size();
-        page.writeData(sizeof(bool) + sizeof(int), &num_keys, sizeof(int));
+    // Clear the page
+    page.clear();
+    page.setLeaf(node.is_leaf);
+    page.setNumKeys(node.entries.size());
     
-        // Write keys
-        size_t offset = sizeof(bool) + 2 * sizeof(int);
-    for (int key : node.keys) {
-            page.writeData(offset, &key, sizeof(int));
-            offset += sizeof(int);
-    }
+    // Write is_leaf flag
+    size_t offset = PAGE_LSN_SIZE;
+    page.writeData(offset, &node.is_leaf, sizeof(bool));
+    offset += sizeof(bool);
+    
+    // Write next_leaf
+    page.writeData(offset, &node.next_leaf, sizeof(int));
+    offset += sizeof(int);
     
-        // Write number of children
+    // Write number of entries
+    int num_keys = node.entries.size();
+    page.writeData(offset, &num_keys, sizeof(int));
+    offset += sizeof(int);
+
+    // Write entries
+    for (const IndexEntry& entry : node.entries) {
+        offset += serializeEntry(entry, page.getData() + offset);
+    }
+
+    // Write number of children and their page ids
     int num_children = node.children.size();
-        page.writeData(offset, &num_children, sizeof(int));
-        offset += sizeof(int);
+    page.writeData(offset, &num_children, sizeof(int));
+    offset += sizeof(int);
+    if (num_children > 0) {
+        page.writeData(offset, node.children.data(), num_children * sizeof(int));
+    }
+    offset += num_children * sizeof(int);
     
-        // Write children
-    for (int child : node.children) {
-            page.writeData(offset, &child, sizeof(int));
-            offset += sizeof(int);
+    page.setFreeSpace(PAGE_SIZE - offset);
+}
+
+bool BPlusTree::deserializeNode(const Page& page, IndexNode& node) {
+    // Read is_leaf flag
+    size_t offset = PAGE_LSN_SIZE;
+    page.readData(offset, &node.is_leaf, sizeof(bool));
+    offset += sizeof(bool);
+
+    // Read next_leaf
+    page.readData(offset, &node.next_leaf, sizeof(int));
+    offset += sizeof(int);
+
+    // Read number of entries
+    int num_keys = 0;
+    page.readData(offset, &num_keys, sizeof(int));
+    offset += sizeof(int);
+
+    // Read entries
+    node.entries.resize(num_keys);
+    for (IndexEntry& entry : node.entries) {
+        size_t used = deserializeEntry(page.getData() + offset, PAGE_SIZE_BYTES - offset, entry);
+        if (used == 0) {
+            std::cerr << "Corrupt index page in " << index_file << std::endl;
+            return false;
         }
-        
-        page.setFreeSpace(PAGE_SIZE - offset);
-    } catch (const std::exception& e) {
-        std::cerr << "Error in serializeNode: " << e.what() << std::endl;
-        throw;
+        offset += used;
+    }
+    
+    // Read number of children and their page ids
+    int num_children = 0;
+    page.readData(offset, &num_children, sizeof(int));
+    offset += sizeof(int);
+    node.children.resize(num_children);
+    if (num_children > 0) {
+        page.readData(offset, node.children.data(), num_children * sizeof(int));
     }
+    return true;
 }
 
-void BPlusTree::deserializeNode(const Page& page, IndexNode& node) {
-    try {
-        // Read is_leaf flag
-        page.readData(0, &node.is_leaf, sizeof(bool));
-    
-        // Read next_leaf
-        page.readData(sizeof(bool), &node.next_leaf, sizeof(int));
-    
-        // Read number of keys
-        int num_keys;
-        page.readData(sizeof(bool) + sizeof(int), &num_keys, sizeof(int));
-    
-        // Read keys
-        size_t offset = sizeof(bool) + 2 * sizeof(int);
-    node.keys.clear();
-    for (int i = 0; i < num_keys; i++) {
-            int key;
-            page.readData(offset, &key, sizeof(int));
-            node.keys.push_back(key);
-            offset += sizeof(int);
-        }
-        
-        // Read number of children
-        int num_children;
-        page.readData(offset, &num_children, sizeof(int));
-        offset += sizeof(int);
-        
-        // Read children
-    node.children.clear();
-    for (int i = 0; i < num_children; i++) {
-            int child;
-            page.readData(offset, &child, sizeof(int));
-            node.children.push_back(child);
-            offset += sizeof(int);
+// HashIndex implementation
+
+// Page 0 of a hash index file holds this header (after the page LSN)
+struct HashMetaPage {
+    uint32_t magic;
+    int global_depth;
+    int num_pages;
+    int unique;
+    int directory_page;
+    int directory_pages;
+};
+
+// "HSH1"
+const uint32_t HASH_MAGIC = 0x48534831;
+
+// Directory slots per page, and the most hash bits the directory uses
+// (2^20 slots fill about a thousand pages)
+const uint32_t DIRECTORY_SLOTS = (PAGE_SIZE_BYTES - PAGE_LSN_SIZE) / sizeof(int);
+const int MAX_GLOBAL_DEPTH = 20;
+
+namespace {
+    // FNV-1a over the key's values, then a final mix so the low bits the
+    // directory uses depend on every byte. Numbers hash by their double
+    // value, so an INT and an equal DOUBLE agree as they do in compare().
+    uint32_t hashKey(const IndexKey& key) {
+        uint32_t hash = 2166136261u;
+        auto mix = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+        };
+        for (const Value& value : key) {
+            if (value.isNumeric()) {
+                double number = value.asDouble() + 0.0;  // -0.0 hashes as 0.0
+                mix(&number, sizeof(double));
+            } else {
+                uint32_t length = value.asString().size();
+                mix(&length, sizeof(uint32_t));
+                mix(value.asString().data(), length);
+            }
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error in deserializeNode: " << e.what() << std::endl;
-        throw;
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    // Bytes a bucket page needs for entries: local depth, the two overflow
+    // links, entry count, then the entries as serializeEntry writes them
+    size_t bucketSize(const std::vector<IndexEntry>& entries) {
+        size_t size = PAGE_LSN_SIZE + 4 * sizeof(int);
+        for (const IndexEntry& entry : entries) {
+            size += entrySize(entry);
+        }
+        return size;
     }
 }
 
-bool IndexManager::remove(const std::string& index_file, int key) {
-    try {
-        // Read the index page
-        Page index_page;
-        if (!storage_manager->readPage(index_file, 0, index_page)) {
-            std::cerr << "Failed to read index page" << std::endl;
+HashIndex::HashIndex(StorageManager* sm, const std::string& filename)
+    : storage_manager(sm), index_file(filename) {
+    Page meta_page;
+    if (!storage_manager->readPage(index_file, 0, meta_page)) {
+        throw std::runtime_error("Failed to read index header: " + index_file);
+    }
+
+    HashMetaPage meta;
+    meta_page.readData(PAGE_LSN_SIZE, &meta, sizeof(HashMetaPage));
+    if (meta.magic != HASH_MAGIC) {
+        throw std::runtime_error("Not a hash index file: " + index_file);
+    }
+
+    global_depth = meta.global_depth;
+    num_pages = meta.num_pages;
+    unique = meta.unique != 0;
+    directory_page = meta.directory_page;
+    directory_pages = meta.directory_pages;
+}
+
+// Header, a one-slot directory on page 1 and an empty bucket on page 2
+bool HashIndex::initialize(StorageManager* sm, const std::string& filename, bool unique) {
+    sm->discardFile(filename);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.close();
+
+    HashMetaPage meta;
+    meta.magic = HASH_MAGIC;
+    meta.global_depth = 0;
+    meta.num_pages = 3;
+    meta.unique = unique ? 1 : 0;
+    meta.directory_page = 1;
+    meta.directory_pages = 1;
+
+    Page meta_page;
+    meta_page.writeData(PAGE_LSN_SIZE, &meta, sizeof(HashMetaPage));
+    if (!sm->writePage(filename, 0, meta_page)) {
+        return false;
+    }
+
+    Page directory;
+    int bucket_page = 2;
+    directory.writeData(PAGE_LSN_SIZE, &bucket_page, sizeof(int));
+    if (!sm->writePage(filename, 1, directory)) {
+        return false;
+    }
+
+    HashIndex index(sm, filename);
+    return index.writeBucket(bucket_page, Bucket());
+}
+
+bool HashIndex::isValid(StorageManager* sm, const std::string& filename) {
+    if (!std::filesystem::exists(filename)) {
+        return false;
+    }
+    Page meta_page;
+    if (!sm->readPage(filename, 0, meta_page)) {
+        return false;
+    }
+    HashMetaPage meta;
+    meta_page.readData(PAGE_LSN_SIZE, &meta, sizeof(HashMetaPage));
+    return meta.magic == HASH_MAGIC;
+}
+
+bool HashIndex::writeMeta() {
+    HashMetaPage meta;
+    meta.magic = HASH_MAGIC;
+    meta.global_depth = global_depth;
+    meta.num_pages = num_pages;
+    meta.unique = unique ? 1 : 0;
+    meta.directory_page = directory_page;
+    meta.directory_pages = directory_pages;
+
+    Page meta_page;
+    meta_page.writeData(PAGE_LSN_SIZE, &meta, sizeof(HashMetaPage));
+    return storage_manager->writePage(index_file, 0, meta_page);
+}
+
+int HashIndex::allocatePage() {
+    int page_id = num_pages++;
+    if (!writeMeta()) {
+        throw std::runtime_error("Failed to update index header");
+    }
+    return page_id;
+}
+
+// Bucket page id in a directory slot
+int HashIndex::getSlot(uint32_t slot) {
+    Page page;
+    if (!storage_manager->readPage(index_file, directory_page + slot / DIRECTORY_SLOTS, page)) {
+        throw std::runtime_error("Failed to read hash directory");
+    }
+    int page_id;
+    page.readData(PAGE_LSN_SIZE + (slot % DIRECTORY_SLOTS) * sizeof(int), &page_id, sizeof(int));
+    return page_id;
+}
+
+// Points the slots first, first + step, ... at page_id, writing each
+// directory page once
+bool HashIndex::setSlots(uint32_t first, uint32_t step, int page_id) {
+    uint32_t size = 1u << global_depth;
+    Page page;
+    int current = -1;
+    for (uint32_t slot = first; slot < size; slot += step) {
+        int directory = directory_page + slot / DIRECTORY_SLOTS;
+        if (directory != current) {
+            if (current != -1 && !storage_manager->writePage(index_file, current, page)) {
+                return false;
+            }
+            if (!storage_manager->readPage(index_file, directory, page)) {
+                return false;
+            }
+            current = directory;
+        }
+        page.writeData(PAGE_LSN_SIZE + (slot % DIRECTORY_SLOTS) * sizeof(int), &page_id, sizeof(int));
+    }
+    return current == -1 || storage_manager->writePage(index_file, current, page);
+}
+
+// Each slot s gains a twin s + 2^global_depth pointing at the same bucket.
+// A directory outgrowing its pages moves to new ones at the end of the
+// file; the old pages are not reused.
+bool HashIndex::doubleDirectory() {
+    uint32_t size = 1u << global_depth;
+    std::vector<int> slots(size);
+    for (uint32_t slot = 0; slot < size; slot++) {
+        slots[slot] = getSlot(slot);
+    }
+
+    int pages_needed = (2 * size + DIRECTORY_SLOTS - 1) / DIRECTORY_SLOTS;
+    if (pages_needed > directory_pages) {
+        directory_page = num_pages;
+        directory_pages = pages_needed;
+        num_pages += pages_needed;
+    }
+    global_depth++;
+    slots.insert(slots.end(), slots.begin(), slots.end());
+
+    for (int i = 0; i < directory_pages; i++) {
+        Page page;
+        size_t first = i * DIRECTORY_SLOTS;
+        size_t count = std::min<size_t>(DIRECTORY_SLOTS, slots.size() - std::min(first, slots.size()));
+        if (count > 0) {
+            page.writeData(PAGE_LSN_SIZE, slots.data() + first, count * sizeof(int));
+        }
+        if (!storage_manager->writePage(index_file, directory_page + i, page)) {
             return false;
         }
+    }
+    return writeMeta();
+}
 
-        // Find and remove the key
-        std::vector<int> keys;
-        size_t offset = 0;
-        while (offset < PAGE_SIZE_BYTES - index_page.getFreeSpace()) {
-            IndexRecord record;
-            index_page.readData(offset, &record, sizeof(IndexRecord));
-            if (record.key != key) {
-                keys.push_back(record.key);
+bool HashIndex::readBucket(int page_id, Bucket& bucket) {
+    Page page;
+    if (!storage_manager->readPage(index_file, page_id, page)) {
+        return false;
+    }
+    size_t offset = PAGE_LSN_SIZE;
+    int num_entries = 0;
+    page.readData(offset, &bucket.local_depth, sizeof(int));
+    page.readData(offset + sizeof(int), &bucket.next_overflow, sizeof(int));
+    page.readData(offset + 2 * sizeof(int), &bucket.last_overflow, sizeof(int));
+    page.readData(offset + 3 * sizeof(int), &num_entries, sizeof(int));
+    offset += 4 * sizeof(int);
+
+    bucket.entries.resize(num_entries);
+    for (IndexEntry& entry : bucket.entries) {
+        size_t used = deserializeEntry(page.getData() + offset, PAGE_SIZE_BYTES - offset, entry);
+        if (used == 0) {
+            std::cerr << "Corrupt index page in " << index_file << std::endl;
+            return false;
+        }
+        offset += used;
+    }
+    return true;
+}
+
+bool HashIndex::writeBucket(int page_id, const Bucket& bucket) {
+    Page page;
+    size_t offset = PAGE_LSN_SIZE;
+    int num_entries = bucket.entries.size();
+    page.writeData(offset, &bucket.local_depth, sizeof(int));
+    page.writeData(offset + sizeof(int), &bucket.next_overflow, sizeof(int));
+    page.writeData(offset + 2 * sizeof(int), &bucket.last_overflow, sizeof(int));
+    page.writeData(offset + 3 * sizeof(int), &num_entries, sizeof(int));
+    offset += 4 * sizeof(int);
+    for (const IndexEntry& entry : bucket.entries) {
+        offset += serializeEntry(entry, page.getData() + offset);
+    }
+    return storage_manager->writePage(index_file, page_id, page);
+}
+
+// Reads the bucket at page_id and its overflow pages
+bool HashIndex::readChain(int page_id, std::vector<int>& pages, std::vector<Bucket>& buckets) {
+    while (page_id != -1) {
+        buckets.emplace_back();
+        if (!readBucket(page_id, buckets.back())) {
+            return false;
+        }
+        pages.push_back(page_id);
+        page_id = buckets.back().next_overflow;
+    }
+    return true;
+}
+
+// Stores entries in the bucket at page_id, continuing on overflow pages
+// taken from spare (or new ones) when they do not fit
+bool HashIndex::writeChain(int page_id, int local_depth, std::vector<IndexEntry>& entries,
+                           std::vector<int>& spare) {
+    std::vector<Bucket> chain(1);
+    std::vector<int> pages = {page_id};
+    for (IndexEntry& entry : entries) {
+        if (!chain.back().entries.empty() &&
+            bucketSize(chain.back().entries) + entrySize(entry) > PAGE_SIZE_BYTES) {
+            if (spare.empty()) {
+                pages.push_back(allocatePage());
+            } else {
+                pages.push_back(spare.back());
+                spare.pop_back();
             }
-            offset += sizeof(IndexRecord);
+            chain.back().next_overflow = pages.back();
+            chain.emplace_back();
         }
+        chain.back().entries.push_back(std::move(entry));
+    }
 
-        // Write back the remaining keys
-        index_page.clear();
-        offset = 0;
-        for (int k : keys) {
-            IndexRecord rec{k, 0};  // page_id is 0 since we're using a simple index
-            index_page.writeData(offset, &rec, sizeof(IndexRecord));
-            offset += sizeof(IndexRecord);
+    if (pages.size() > 1) {
+        chain.front().last_overflow = pages.back();
+    }
+    for (size_t i = 0; i < chain.size(); i++) {
+        chain[i].local_depth = local_depth;
+        if (!writeBucket(pages[i], chain[i])) {
+            return false;
         }
-        index_page.setFreeSpace(PAGE_SIZE_BYTES - offset);
+    }
+    return true;
+}
+
+// Splits the bucket that hash maps to, first page at page_id, on its next
+// hash bit; false when the directory cannot grow any more
+bool HashIndex::split(int page_id, uint32_t hash) {
+    std::vector<int> pages;
+    std::vector<Bucket> buckets;
+    if (!readChain(page_id, pages, buckets)) {
+        throw std::runtime_error("Failed to read bucket to split");
+    }
 
-        // Write the updated page back
-        if (!storage_manager->writePage(index_file, 0, index_page)) {
-            std::cerr << "Failed to write index page" << std::endl;
+    int local_depth = buckets.front().local_depth;
+    if (local_depth == global_depth) {
+        if (global_depth == MAX_GLOBAL_DEPTH) {
             return false;
         }
+        if (!doubleDirectory()) {
+            throw std::runtime_error("Failed to grow hash directory");
+        }
+    }
 
-        return true;
+    std::vector<IndexEntry> stay;
+    std::vector<IndexEntry> moved;
+    for (Bucket& bucket : buckets) {
+        for (IndexEntry& entry : bucket.entries) {
+            bool high = (hashKey(entry.key) >> local_depth) & 1;
+            (high ? moved : stay).push_back(std::move(entry));
+        }
+    }
+
+    // Overflow pages of the old chain are reused by both halves
+    std::vector<int> spare(pages.begin() + 1, pages.end());
+    int new_page_id = allocatePage();
+    if (!writeChain(page_id, local_depth + 1, stay, spare) ||
+        !writeChain(new_page_id, local_depth + 1, moved, spare)) {
+        throw std::runtime_error("Failed to write split bucket");
+    }
+
+    // The slots of the old bucket with the new bit set now belong to the new one
+    uint32_t low_bits = hash & ((1u << local_depth) - 1);
+    if (!setSlots(low_bits | (1u << local_depth), 1u << (local_depth + 1), new_page_id)) {
+        throw std::runtime_error("Failed to update hash directory");
+    }
+    return true;
+}
+
+bool HashIndex::insert(const IndexEntry& entry) {
+    uint32_t hash = hashKey(entry.key);
+    try {
+        while (true) {
+            int page_id = getSlot(hash & ((1u << global_depth) - 1));
+            Bucket bucket;
+            if (!readBucket(page_id, bucket)) {
+                return false;
+            }
+
+            if (unique) {
+                std::vector<IndexEntry> found;
+                if (!find(entry.key, found, 1)) {
+                    return false;
+                }
+                if (!found.empty()) {
+                    std::cerr << "Duplicate key " << entry.key.front() << " in unique index: " << index_file
+                              << std::endl;
+                    return false;
+                }
+            }
+
+            // The entry goes to the first page of the chain, else to its last
+            if (bucketSize(bucket.entries) + entrySize(entry) <= PAGE_SIZE_BYTES) {
+                bucket.entries.push_back(entry);
+                return writeBucket(page_id, bucket);
+            }
+            Bucket last;
+            if (bucket.last_overflow != -1) {
+                if (!readBucket(bucket.last_overflow, last)) {
+                    return false;
+                }
+                if (bucketSize(last.entries) + entrySize(entry) <= PAGE_SIZE_BYTES) {
+                    last.entries.push_back(entry);
+                    return writeBucket(bucket.last_overflow, last);
+                }
+            }
+
+            // A full bucket is split, unless no hash bit could separate the
+            // keys on its first page from the entry; then the entry starts
+            // a new overflow page
+            bool shared_hash = std::all_of(bucket.entries.begin(), bucket.entries.end(),
+                                           [hash](const IndexEntry& other) { return hashKey(other.key) == hash; });
+            if (!shared_hash && split(page_id, hash)) {
+                continue;
+            }
+            Bucket overflow;
+            overflow.local_depth = bucket.local_depth;
+            overflow.entries.push_back(entry);
+            int overflow_page = allocatePage();
+            if (!writeBucket(overflow_page, overflow)) {
+                return false;
+            }
+            if (bucket.last_overflow != -1) {
+                last.next_overflow = overflow_page;
+                if (!writeBucket(bucket.last_overflow, last)) {
+                    return false;
+                }
+            } else {
+                bucket.next_overflow = overflow_page;
+            }
+            bucket.last_overflow = overflow_page;
+            return writeBucket(page_id, bucket);
+        }
     } catch (const std::exception& e) {
-        std::cerr << "Error removing key from index: " << e.what() << std::endl;
+        std::cerr << "Error in insert: " << e.what() << std::endl;
         return false;
     }
 }
 
-// Add this helper function to your utilities
-std::string getFullPath(const std::string& path) {
-    if (path.substr(0, 7) == "./data/") {
-        return path;
+bool HashIndex::remove(const IndexKey& key, const RID& rid) {
+    // Lazy deletion: emptied buckets are neither merged nor freed
+    try {
+        int page_id = getSlot(hashKey(key) & ((1u << global_depth) - 1));
+        while (page_id != -1) {
+            Bucket bucket;
+            if (!readBucket(page_id, bucket)) {
+                return false;
+            }
+            for (auto it = bucket.entries.begin(); it != bucket.entries.end(); ++it) {
+                if (it->rid == rid && compareKeys(it->key, key) == 0) {
+                    bucket.entries.erase(it);
+                    return writeBucket(page_id, bucket);
+                }
+            }
+            page_id = bucket.next_overflow;
+        }
+        return true;  // No such entry
+    } catch (const std::exception& e) {
+        std::cerr << "Error in remove: " << e.what() << std::endl;
+        return false;
     }
-    return "./data/" + path;
-}
\ No newline at end of file
+}
+
+bool HashIndex::find(const IndexKey& key, std::vector<IndexEntry>& result, size_t limit) {
+    try {
+        int page_id = getSlot(hashKey(key) & ((1u << global_depth) - 1));
+        std::vector<IndexEntry> found;
+        while (page_id != -1) {
+            Bucket bucket;
+            if (!readBucket(page_id, bucket)) {
+                return false;
+            }
+            for (IndexEntry& entry : bucket.entries) {
+                if (compareKeys(entry.key, key) == 0) {
+                    found.push_back(std::move(entry));
+                }
+            }
+            page_id = bucket.next_overflow;
+        }
+
+        // Buckets keep entries in arrival order; report them as the B+ tree would
+        std::sort(found.begin(), found.end(), entryLess);
+        if (found.size() > limit) {
+            found.resize(limit);
+        }
+        result.insert(result.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in lookup: " << e.what() << std::endl;
+        return false;
+    }
+}
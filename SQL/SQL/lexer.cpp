@@ -0,0 +1,115 @@
+#include "lexer.h"
+#include <cctype>
+#include <algorithm>
+
+Lexer::Lexer(const std::string& input) : input(input), pos(0) {}
+
+void Lexer::addToken(std::vector<Token>& tokens, TokenType type, const std::string& text, size_t start) {
+    Token token;
+    token.type = type;
+    token.text = text;
+    token.upper = text;
+    if (type == TokenType::IDENTIFIER) {
+        std::transform(token.upper.begin(), token.upper.end(), token.upper.begin(), ::toupper);
+    }
+    token.position = start;
+    tokens.push_back(token);
+}
+
+bool Lexer::tokenize(std::vector<Token>& tokens, std::string& error) {
+    tokens.clear();
+    pos = 0;
+
+    while (pos < input.length()) {
+        char c = input[pos];
+        size_t start = pos;
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pos++;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (pos < input.length() &&
+                   (std::isalnum(static_cast<unsigned char>(input[pos])) || input[pos] == '_')) {
+                pos++;
+            }
+            addToken(tokens, TokenType::IDENTIFIER, input.substr(start, pos - start), start);
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '.' && pos + 1 < input.length() &&
+                    std::isdigit(static_cast<unsigned char>(input[pos + 1])))) {
+            bool is_float = false;
+            while (pos < input.length() && std::isdigit(static_cast<unsigned char>(input[pos]))) pos++;
+            if (pos < input.length() && input[pos] == '.') {
+                is_float = true;
+                pos++;
+                while (pos < input.length() && std::isdigit(static_cast<unsigned char>(input[pos]))) pos++;
+            }
+            if (pos < input.length() && (input[pos] == 'e' || input[pos] == 'E')) {
+                size_t exponent = pos + 1;
+                if (exponent < input.length() && (input[exponent] == '+' || input[exponent] == '-')) exponent++;
+                if (exponent < input.length() && std::isdigit(static_cast<unsigned char>(input[exponent]))) {
+                    is_float = true;
+                    pos = exponent;
+                    while (pos < input.length() && std::isdigit(static_cast<unsigned char>(input[pos]))) pos++;
+                }
+            }
+            addToken(tokens, is_float ? TokenType::FLOAT : TokenType::INTEGER,
+                     input.substr(start, pos - start), start);
+        } else if (c == '\'' || c == '"') {
+            // A doubled quote inside a string stands for one quote character
+            std::string text;
+            pos++;
+            bool closed = false;
+            while (pos < input.length()) {
+                if (input[pos] == c) {
+                    if (pos + 1 < input.length() && input[pos + 1] == c) {
+                        text += c;
+                        pos += 2;
+                        continue;
+                    }
+                    pos++;
+                    closed = true;
+                    break;
+                }
+                text += input[pos++];
+            }
+            if (!closed) {
+                error = "Unterminated string starting at position " + std::to_string(start);
+                return false;
+            }
+            addToken(tokens, TokenType::STRING, text, start);
+        } else if (c == '<' || c == '>' || c == '!' || c == '=') {
+            std::string op(1, c);
+            if (pos + 1 < input.length()) {
+                char next = input[pos + 1];
+                if (next == '=' || (c == '<' && next == '>')) {
+                    op += next;
+                }
+            }
+            if (op == "!") {
+                error = "Unexpected '!' at position " + std::to_string(start);
+                return false;
+            }
+            pos += op.length();
+            addToken(tokens, TokenType::OPERATOR, op, start);
+        } else {
+            TokenType type;
+            switch (c) {
+            case ',': type = TokenType::COMMA; break;
+            case '.': type = TokenType::DOT; break;
+            case '(': type = TokenType::LPAREN; break;
+            case ')': type = TokenType::RPAREN; break;
+            case '*': type = TokenType::STAR; break;
+            case ';': type = TokenType::SEMICOLON; break;
+            case '+':
+            case '-': type = TokenType::OPERATOR; break;
+            default:
+                error = std::string("Unexpected character '") + c + "' at position " + std::to_string(start);
+                return false;
+            }
+            pos++;
+            addToken(tokens, type, std::string(1, c), start);
+        }
+    }
+
+    addToken(tokens, TokenType::END, "", input.length());
+    return true;
+}
@@ -0,0 +1,494 @@
+#include "log_manager.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const uint32_t LOG_MAGIC = 0x57414C31;  // "WAL1"
+    // [total size][checksum] in front of every record
+    const size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+    uint32_t checksum(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;  // FNV-1a
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    bool hasPageImage(LogRecordType type) {
+        return type == LogRecordType::UPDATE || type == LogRecordType::CLR;
+    }
+
+    template <typename T>
+    void put(char*& pos, const T& value) {
+        memcpy(pos, &value, sizeof(T));
+        pos += sizeof(T);
+    }
+
+    void putBytes(char*& pos, const std::string& bytes) {
+        uint16_t length = static_cast<uint16_t>(bytes.size());
+        put(pos, length);
+        memcpy(pos, bytes.data(), length);
+        pos += length;
+    }
+
+    template <typename T>
+    bool get(const char*& pos, const char* end, T& value) {
+        if (pos + sizeof(T) > end) return false;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getBytes(const char*& pos, const char* end, std::string& bytes) {
+        uint16_t length = 0;
+        if (!get(pos, end, length) || pos + length > end) return false;
+        bytes.assign(pos, length);
+        pos += length;
+        return true;
+    }
+
+    // Thin wrappers so the log can be fsync'ed on both platforms
+#ifdef _WIN32
+    int openFile(const std::string& name) {
+        return _open(name.c_str(), _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+    long long fileSize(int fd) { return _lseeki64(fd, 0, SEEK_END); }
+    bool syncFile(int fd) { return _commit(fd) == 0; }
+    bool truncateFile(int fd, long long size) { return _chsize_s(fd, size) == 0; }
+    void closeFile(int fd) { _close(fd); }
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            int written = _write(fd, data, static_cast<unsigned int>(size));
+            if (written <= 0) return false;
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+#else
+    int openFile(const std::string& name) {
+        return ::open(name.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    }
+    long long fileSize(int fd) { return ::lseek(fd, 0, SEEK_END); }
+    bool syncFile(int fd) { return ::fsync(fd) == 0; }
+    bool truncateFile(int fd, long long size) { return ::ftruncate(fd, size) == 0; }
+    void closeFile(int fd) { ::close(fd); }
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) return false;
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+#endif
+}
+
+size_t LogRecord::getSize() const {
+    size_t size = RECORD_HEADER_SIZE + sizeof(lsn_t) + sizeof(int) + sizeof(uint8_t);
+    if (hasPageImage(type)) {
+        size += sizeof(uint16_t) + filename.size();
+        size += sizeof(int) + sizeof(uint16_t);
+        size += sizeof(uint16_t) + before_image.size();
+        size += sizeof(uint16_t) + after_image.size();
+        size += sizeof(lsn_t);
+    }
+    if (type == LogRecordType::END_CHECKPOINT) {
+        size += sizeof(uint32_t) + active_transactions.size() * (sizeof(int) + sizeof(lsn_t));
+        size += sizeof(uint32_t);
+        for (const auto& entry : dirty_pages) {
+            size += sizeof(uint16_t) + entry.filename.size() + sizeof(int) + sizeof(lsn_t);
+        }
+    }
+    return size;
+}
+
+void LogRecord::serialize(char* buffer) const {
+    char* pos = buffer + RECORD_HEADER_SIZE;
+    put(pos, prev_lsn);
+    put(pos, transaction_id);
+    put(pos, static_cast<uint8_t>(type));
+    if (hasPageImage(type)) {
+        putBytes(pos, filename);
+        put(pos, page_id);
+        put(pos, offset);
+        putBytes(pos, before_image);
+        putBytes(pos, after_image);
+        put(pos, undo_next_lsn);
+    }
+    if (type == LogRecordType::END_CHECKPOINT) {
+        put(pos, static_cast<uint32_t>(active_transactions.size()));
+        for (const auto& [transaction, last_lsn] : active_transactions) {
+            put(pos, transaction);
+            put(pos, last_lsn);
+        }
+        put(pos, static_cast<uint32_t>(dirty_pages.size()));
+        for (const auto& entry : dirty_pages) {
+            putBytes(pos, entry.filename);
+            put(pos, entry.page_id);
+            put(pos, entry.rec_lsn);
+        }
+    }
+
+    uint32_t size = static_cast<uint32_t>(pos - buffer);
+    uint32_t sum = checksum(buffer + RECORD_HEADER_SIZE, size - RECORD_HEADER_SIZE);
+    memcpy(buffer, &size, sizeof(uint32_t));
+    memcpy(buffer + sizeof(uint32_t), &sum, sizeof(uint32_t));
+}
+
+bool LogRecord::deserialize(const char* buffer, size_t size) {
+    if (size < RECORD_HEADER_SIZE) {
+        return false;
+    }
+    uint32_t stored_size = 0;
+    uint32_t stored_sum = 0;
+    memcpy(&stored_size, buffer, sizeof(uint32_t));
+    memcpy(&stored_sum, buffer + sizeof(uint32_t), sizeof(uint32_t));
+    if (stored_size != size ||
+        checksum(buffer + RECORD_HEADER_SIZE, size - RECORD_HEADER_SIZE) != stored_sum) {
+        return false;  // Torn or corrupted record
+    }
+
+    const char* pos = buffer + RECORD_HEADER_SIZE;
+    const char* end = buffer + size;
+    uint8_t raw_type = 0;
+    if (!get(pos, end, prev_lsn) || !get(pos, end, transaction_id) || !get(pos, end, raw_type)) {
+        return false;
+    }
+    type = static_cast<LogRecordType>(raw_type);
+    if (hasPageImage(type)) {
+        return getBytes(pos, end, filename) && get(pos, end, page_id) && get(pos, end, offset) &&
+               getBytes(pos, end, before_image) && getBytes(pos, end, after_image) &&
+               get(pos, end, undo_next_lsn);
+    }
+    if (type == LogRecordType::END_CHECKPOINT) {
+        uint32_t count = 0;
+        if (!get(pos, end, count)) return false;
+        active_transactions.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            int transaction = 0;
+            lsn_t last_lsn = INVALID_LSN;
+            if (!get(pos, end, transaction) || !get(pos, end, last_lsn)) return false;
+            active_transactions.emplace_back(transaction, last_lsn);
+        }
+        if (!get(pos, end, count)) return false;
+        dirty_pages.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            DirtyPageEntry entry;
+            if (!getBytes(pos, end, entry.filename) || !get(pos, end, entry.page_id) ||
+                !get(pos, end, entry.rec_lsn)) {
+                return false;
+            }
+            dirty_pages.push_back(entry);
+        }
+    }
+    return true;
+}
+
+LogManager::LogManager(const std::string& log_file, lsn_t base_lsn)
+    : log_file(log_file), fd(-1), base_lsn(std::max<lsn_t>(base_lsn, LOG_HEADER_SIZE)), next_lsn(this->base_lsn),
+      flushed_lsn(this->base_lsn), flush_in_progress(false), num_syncs(0) {
+    if (!openLog()) {
+        std::cerr << "Failed to open log file: " << log_file << std::endl;
+    }
+}
+
+LogManager::~LogManager() {
+    close();
+}
+
+bool LogManager::openLog() {
+    fd = openFile(log_file);
+    if (fd < 0) {
+        return false;
+    }
+
+    long long size = fileSize(fd);
+    if (size < static_cast<long long>(LOG_HEADER_SIZE)) {
+        // New (or header-less) log: start it with the magic number
+        char header[LOG_HEADER_SIZE] = {};
+        memcpy(header, &LOG_MAGIC, sizeof(uint32_t));
+        if (size != 0 || !writeAll(fd, header, LOG_HEADER_SIZE) || !syncFile(fd)) {
+            closeFile(fd);
+            fd = -1;
+            return false;
+        }
+        size = LOG_HEADER_SIZE;
+    } else {
+        std::ifstream file(log_file, std::ios::binary);
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+        if (magic != LOG_MAGIC) {
+            closeFile(fd);
+            fd = -1;
+            return false;
+        }
+    }
+
+    next_lsn = flushed_lsn = base_lsn + static_cast<lsn_t>(size) - LOG_HEADER_SIZE;
+    return true;
+}
+
+lsn_t LogManager::appendLogRecord(LogRecord& record) {
+    std::unique_lock<std::mutex> lock(latch);
+    auto it = active_transactions.find(record.transaction_id);
+    record.prev_lsn = it != active_transactions.end() ? it->second : INVALID_LSN;
+    record.lsn = next_lsn;
+    if (record.transaction_id != -1) {
+        first_lsns.emplace(record.transaction_id, record.lsn);
+    }
+
+    size_t size = record.getSize();
+    size_t start = log_buffer.size();
+    log_buffer.resize(start + size);
+    record.serialize(log_buffer.data() + start);
+    next_lsn += size;
+
+    if (record.transaction_id == -1) {
+        // Checkpoint records belong to no transaction
+    } else if (record.type == LogRecordType::COMMIT || record.type == LogRecordType::ABORT) {
+        active_transactions.erase(record.transaction_id);
+        first_lsns.erase(record.transaction_id);
+    } else {
+        active_transactions[record.transaction_id] = record.lsn;
+    }
+
+    // Large transactions write out their log as they go
+    bool buffer_full = log_buffer.size() >= LOG_BUFFER_SIZE;
+    lock.unlock();
+    if (buffer_full) {
+        flush(record.lsn);
+    }
+    return record.lsn;
+}
+
+bool LogManager::flush(lsn_t lsn) {
+    std::unique_lock<std::mutex> lock(latch);
+    while (flushed_lsn <= lsn) {
+        if (flush_in_progress) {
+            // Another thread is syncing; its batch (or the next one) covers us
+            flush_done.wait(lock);
+            continue;
+        }
+        if (log_buffer.empty()) {
+            return true;  // Nothing appended past what is already durable
+        }
+
+        // Become the leader: take everything buffered so far and sync it once
+        flush_in_progress = true;
+        std::vector<char> batch;
+        batch.swap(log_buffer);
+        lsn_t batch_end = next_lsn;
+        lock.unlock();
+
+        bool written = fd >= 0 && writeAll(fd, batch.data(), batch.size()) && syncFile(fd);
+
+        lock.lock();
+        flush_in_progress = false;
+        if (written) {
+            flushed_lsn = batch_end;
+            num_syncs++;
+        } else {
+            log_buffer.insert(log_buffer.begin(), batch.begin(), batch.end());
+        }
+        flush_done.notify_all();
+
+        if (!written) {
+            std::cerr << "Failed to write log file: " << log_file << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogManager::flushAll() {
+    lsn_t last;
+    {
+        std::lock_guard<std::mutex> lock(latch);
+        last = next_lsn - 1;
+    }
+    return flush(last);
+}
+
+bool LogManager::readLogRecord(lsn_t lsn, LogRecord& record) {
+    if (lsn == INVALID_LSN || !flush(lsn)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(latch);
+    if (!reader.is_open()) {
+        reader.open(log_file, std::ios::binary);
+        if (!reader) {
+            return false;
+        }
+    }
+
+    if (lsn < base_lsn) {
+        return false;  // Reclaimed
+    }
+    reader.clear();
+    reader.seekg(fileOffset(lsn));
+    uint32_t size = 0;
+    reader.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+    if (!reader || size < RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    std::vector<char> buffer(size);
+    memcpy(buffer.data(), &size, sizeof(uint32_t));
+    reader.read(buffer.data() + sizeof(uint32_t), size - sizeof(uint32_t));
+    if (!reader || !record.deserialize(buffer.data(), size)) {
+        return false;
+    }
+    record.lsn = lsn;
+    return true;
+}
+
+bool LogManager::truncate(lsn_t lsn) {
+    std::lock_guard<std::mutex> lock(latch);
+    if (fd < 0 || lsn < base_lsn || lsn > next_lsn || !log_buffer.empty()) {
+        return false;
+    }
+    if (!truncateFile(fd, fileOffset(lsn)) || !syncFile(fd)) {
+        return false;
+    }
+    if (reader.is_open()) {
+        reader.close();
+    }
+    next_lsn = flushed_lsn = lsn;
+    return true;
+}
+
+bool LogManager::discardBefore(lsn_t lsn, const std::function<bool(lsn_t)>& install) {
+    if (!flushAll()) {
+        return false;
+    }
+    // Holding the latch keeps flushes off the old file until it is replaced;
+    // records appended meanwhile stay buffered and go to the new one
+    std::unique_lock<std::mutex> lock(latch);
+    flush_done.wait(lock, [this] { return !flush_in_progress; });
+    if (lsn <= base_lsn) {
+        return true;  // Nothing to reclaim
+    }
+    if (fd < 0 || lsn > flushed_lsn) {
+        return false;
+    }
+
+    std::string new_file = log_file + "." + std::to_string(lsn);
+    std::error_code ec;
+    std::filesystem::remove(new_file, ec);
+    int new_fd = openFile(new_file);
+    if (new_fd < 0) {
+        std::cerr << "Failed to create log file: " << new_file << std::endl;
+        return false;
+    }
+    char header[LOG_HEADER_SIZE] = {};
+    memcpy(header, &LOG_MAGIC, sizeof(uint32_t));
+    bool copied = writeAll(new_fd, header, LOG_HEADER_SIZE);
+    std::ifstream old_log(log_file, std::ios::binary);
+    old_log.seekg(fileOffset(lsn));
+    std::vector<char> chunk(LOG_BUFFER_SIZE);
+    for (lsn_t remaining = flushed_lsn - lsn; copied && remaining > 0;) {
+        size_t size = static_cast<size_t>(std::min<lsn_t>(remaining, chunk.size()));
+        copied = old_log.read(chunk.data(), size) && writeAll(new_fd, chunk.data(), size);
+        remaining -= size;
+    }
+    copied = copied && syncFile(new_fd);
+    closeFile(new_fd);
+    if (!copied || !install(lsn)) {
+        std::cerr << "Failed to write log file: " << new_file << std::endl;
+        std::filesystem::remove(new_file, ec);
+        return false;
+    }
+
+    if (reader.is_open()) {
+        reader.close();
+    }
+    closeFile(fd);
+    std::filesystem::rename(new_file, log_file, ec);
+    if (ec) {
+        // The old log is still whole; keep using it. If the master cannot
+        // be put back either, the copy stays for prepareLog to install on
+        // restart, until the next checkpoint records the old base again.
+        std::cerr << "Failed to replace log file: " << ec.message() << std::endl;
+        if (install(base_lsn)) {
+            std::filesystem::remove(new_file, ec);
+        }
+        fd = openFile(log_file);
+        return false;
+    }
+    base_lsn = lsn;
+    fd = openFile(log_file);
+    if (fd < 0) {
+        std::cerr << "Failed to open log file: " << log_file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void LogManager::close() {
+    flushAll();
+    std::lock_guard<std::mutex> lock(latch);
+    if (reader.is_open()) {
+        reader.close();
+    }
+    if (fd >= 0) {
+        closeFile(fd);
+        fd = -1;
+    }
+}
+
+lsn_t LogManager::getLastLSN(int transaction_id) {
+    std::lock_guard<std::mutex> lock(latch);
+    auto it = active_transactions.find(transaction_id);
+    return it != active_transactions.end() ? it->second : INVALID_LSN;
+}
+
+std::vector<std::pair<int, lsn_t>> LogManager::getActiveTransactions() {
+    std::lock_guard<std::mutex> lock(latch);
+    return std::vector<std::pair<int, lsn_t>>(active_transactions.begin(), active_transactions.end());
+}
+
+lsn_t LogManager::getOldestActiveLSN() {
+    std::lock_guard<std::mutex> lock(latch);
+    lsn_t oldest = INVALID_LSN;
+    for (const auto& [transaction, first_lsn] : first_lsns) {
+        if (oldest == INVALID_LSN || first_lsn < oldest) oldest = first_lsn;
+    }
+    return oldest;
+}
+
+void LogManager::registerTransaction(int transaction_id, lsn_t last_lsn) {
+    std::lock_guard<std::mutex> lock(latch);
+    active_transactions[transaction_id] = last_lsn;
+    // Where its records start is unknown, so none of the log is reclaimed
+    // until it ends
+    first_lsns[transaction_id] = base_lsn;
+}
+
+lsn_t LogManager::getFirstLSN() {
+    std::lock_guard<std::mutex> lock(latch);
+    return base_lsn;
+}
+
+lsn_t LogManager::getNextLSN() {
+    std::lock_guard<std::mutex> lock(latch);
+    return next_lsn;
+}
+
+lsn_t LogManager::getFlushedLSN() {
+    std::lock_guard<std::mutex> lock(latch);
+    return flushed_lsn;
+}
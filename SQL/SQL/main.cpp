@@ -5,7 +5,7 @@
 #include <algorithm>
 #include <fstream>
 #include "database.h"
-#include <regex>
+#include "parser.h"
 #include <filesystem>
 
 void printHelp()
@@ -58,12 +58,19 @@ void printHelp()
     std::cout << "   Example: SELECT department, COUNT(*) FROM employees GROUP BY department HAVING COUNT(*) > 5\n\n";
     
     std::cout << "5. ORDER BY:\n";
-    std::cout << "   SELECT * FROM <table> ORDER BY <column> [ASC|DESC]\n";
+    std::cout << "   SELECT * FROM <table> ORDER BY <column> [ASC|DESC] [LIMIT n [OFFSET m]]\n";
     std::cout << "   Example: SELECT * FROM employees ORDER BY salary DESC\n\n";
     
     std::cout << "6. JOIN Queries:\n";
-    std::cout << "   SELECT * FROM <table1> JOIN <table2> ON <table1.column> = <table2.column>\n";
-    std::cout << "   Example: SELECT * FROM employees JOIN departments ON employees.dept_id = departments.id\n\n";
+    std::cout << "   SELECT * FROM <table1> [INNER|LEFT|RIGHT|FULL] JOIN <table2> ON <table1.column> = <table2.column>\n";
+    std::cout << "          [JOIN <table3> ON ...]...\n";
+    std::cout << "   Example: SELECT * FROM employees JOIN departments ON employees.dept_id = departments.id\n";
+    std::cout << "   Inner joins over analyzed tables are reordered to keep intermediate results small\n\n";
+
+    std::cout << "7. Query Plans:\n";
+    std::cout << "   EXPLAIN <select>          - Show the plan with estimated row counts\n";
+    std::cout << "   EXPLAIN ANALYZE <select>  - Run the query and show rows, time and pages per operator\n";
+    std::cout << "   Example: EXPLAIN ANALYZE SELECT * FROM employees WHERE id = 1\n\n";
 
     std::cout << "Data Modification Commands:\n";
     std::cout << "-------------------------\n";
@@ -75,8 +82,12 @@ void printHelp()
 
     std::cout << "Index Management:\n";
     std::cout << "----------------\n";
-    std::cout << "CREATE INDEX ON <table>(<column>)\n";
-    std::cout << "  Example: CREATE INDEX ON employees(salary)\n\n";
+    std::cout << "CREATE INDEX ON <table>(<column>[, <column>...]) [USING BTREE|HASH] [INCLUDE (<column>[, ...])]\n";
+    std::cout << "  Example: CREATE INDEX ON employees(salary)\n";
+    std::cout << "  Example: CREATE INDEX ON employees(department, salary)\n";
+    std::cout << "  Example: CREATE INDEX ON employees(department) INCLUDE (name)\n";
+    std::cout << "  Example: CREATE INDEX ON employees(email) USING HASH\n\n";
+    std::cout << "ANALYZE <table>            - Gather statistics for the query optimizer\n\n";
 
     std::cout << "System Commands:\n";
     std::cout << "---------------\n";
@@ -102,94 +113,15 @@ void printHelp()
     std::cout << "      Use semicolons to separate multiple commands.\n";
 }
 
-// Helper function to split string by delimiter
-std::vector<std::string> split(const std::string &str, char delimiter)
-{
-    std::vector<std::string> tokens;
-    std::string token;
-    std::istringstream tokenStream(str);
-    while (std::getline(tokenStream, token, delimiter))
-    {
-        // Trim whitespace
-        token.erase(0, token.find_first_not_of(" \t"));
-        token.erase(token.find_last_not_of(" \t") + 1);
-        if (!token.empty())
-        {
-            tokens.push_back(token);
-        }
-    }
-    return tokens;
-}
-
-// Helper function to parse column definitions
-std::vector<ColumnInfo> parseColumnDefs(const std::string &columnDefs)
-{
-    std::vector<ColumnInfo> columns;
-    std::istringstream ss(columnDefs);
-    std::string token;
-    std::string current_def;
-
-    while (std::getline(ss, token, ','))
-    {
-        // Trim whitespace from token
-        token.erase(0, token.find_first_not_of(" \t"));
-        token.erase(token.find_last_not_of(" \t") + 1);
-
-        std::istringstream def_stream(token);
-        ColumnInfo col;
-
-        std::string name, type, constraint;
-        def_stream >> name >> type;
-        col.name = name;
-
-        // Handle VARCHAR(n)
-        if (type.substr(0, 7) == "VARCHAR(")
-        {
-            col.type = "VARCHAR";
-            col.size = std::stoi(type.substr(7, type.length() - 8));
-        }
-        else
-        {
-            col.type = type;
-            if (type == "INT")
-                col.size = sizeof(int);
-        }
-
-        // Parse constraints
-        std::string word;
-        while (def_stream >> word)
-        {
-            if (word == "PRIMARY" && def_stream >> word && word == "KEY")
-            {
-                col.is_primary_key = true;
-            }
-            else if (word == "FOREIGN" && def_stream >> word && word == "KEY")
-            {
-                col.is_foreign_key = true;
-                // Parse REFERENCES
-                if (def_stream >> word && word == "REFERENCES")
-                {
-                    std::string ref_def;
-                    def_stream >> ref_def;
-                    // Parse table(column)
-                    size_t open_paren = ref_def.find('(');
-                    size_t close_paren = ref_def.find(')');
-                    if (open_paren != std::string::npos && close_paren != std::string::npos)
-                    {
-                        col.references_table = ref_def.substr(0, open_paren);
-                        col.references_column = ref_def.substr(open_paren + 1,
-                                                               close_paren - open_paren - 1);
-                    }
-                }
-            }
-        }
-        columns.push_back(col);
-    }
-    return columns;
-}
 bool Database::dropDatabase(const std::string& db_name) {  // database.cpp
     std::string db_path = "./data/" + db_name;
     try {
+        // Cached pages and open handles must not outlive the files
+        if (active_transaction_id != -1) {
+            abortTransaction(active_transaction_id);
+        }
+        storage_manager->getBufferPool()->discardAll();
+        log_manager->close();
         if (std::filesystem::remove_all(db_path)) {
             std::cout << "Database dropped: " << db_name << std::endl;
             return true;
@@ -199,205 +131,109 @@ bool Database::dropDatabase(const std::string& db_name) {  // database.cpp
         return false;
     }
 }
-bool handleCreateTable(Database &db, const std::string &command)
-{
-    std::regex create_pattern(
-        R"(CREATE\s+TABLE\s+(\w+)\s*\(([\s\S]+)\))",
-        std::regex_constants::icase);
-
-    std::smatch matches;
-    if (std::regex_search(command, matches, create_pattern))
-    {
-        std::string table_name = matches[1];
-        std::string column_defs = matches[2];
-
-        std::vector<ColumnInfo> columns = parseColumnDefs(column_defs);
-        return db.createTable(table_name, columns);
-    }
-    return false;
-}
-
-void executeSelect(Database &db, const std::string &query)
-{
-    std::vector<std::string> tokens = split(query, ' ');
-    if (tokens.size() < 4)
-    {
-        std::cout << "Invalid SELECT syntax\n";
-        return;
-    }
-
-    // Find the FROM clause position
-    size_t from_pos = query.find("FROM");
-    if (from_pos == std::string::npos)
-    {
-        std::cout << "Invalid SELECT syntax: missing FROM clause\n";
-        return;
-    }
-
-    // Extract table name and query clauses
-    std::string query_clauses = query.substr(from_pos);
-    std::vector<std::string> from_tokens = split(query_clauses, ' ');
-    if (from_tokens.size() < 2)
-    {
-        std::cout << "Invalid SELECT syntax: missing table name\n";
-        return;
-    }
-
-    std::string table_name = from_tokens[1];
-    
-    // Execute the query with all clauses
-    if (!db.selectWithClauses(table_name, query_clauses))
-    {
-        std::cout << "Error executing SELECT query\n";
-    }
-}
 
 int main()
 {
     Database* current_db = nullptr;
     int current_transaction_id = -1;
 
-    // Regex patterns for transaction commands
-    std::regex begin_transaction_pattern(R"(BEGIN\s+TRANSACTION)", std::regex_constants::icase);
-    std::regex commit_pattern(R"(COMMIT)", std::regex_constants::icase);
-    std::regex rollback_pattern(R"(ROLLBACK)", std::regex_constants::icase);
-
     std::string input;
     std::string current_db_name;
 
     std::cout << "Simple DBMS v1.0\n";
     std::cout << "Type 'HELP' for commands\n";
 
-    while (true)
+    bool running = true;
+    while (running)
     {
     std::cout << (current_db_name.empty() ? "dbms" : current_db_name) << "> " << std::flush;
-        std::getline(std::cin, input);
-
-        // Convert input to uppercase for case-insensitive commands
-        std::string upperInput = input;
-        std::transform(upperInput.begin(), upperInput.end(), upperInput.begin(), ::toupper);
-
-        if (upperInput == "EXIT")
+        if (!std::getline(std::cin, input))
         {
             break;
         }
 
-        if (upperInput == "HELP")
+        // Statements are parsed once, up front; nothing runs if any of them
+        // is malformed
+        Parser parser(input);
+        std::vector<Statement> statements;
+        if (!parser.parse(statements))
         {
-            printHelp();
+            std::cout << "Error: " << parser.getError() << std::endl;
             continue;
         }
 
-        try
+        for (Statement &statement : statements)
         {
-            std::istringstream iss(input);
-            std::string command;
-            iss >> command;
-            std::transform(command.begin(), command.end(), command.begin(), ::toupper);
-
-            if (command == "CREATE")
+            bool needs_db = statement.type != StatementType::HELP &&
+                            statement.type != StatementType::EXIT &&
+                            statement.type != StatementType::CREATE_DATABASE &&
+                            statement.type != StatementType::USE_DATABASE;
+            if (needs_db && !current_db)
             {
-                std::string type;
-                iss >> type;
-                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+                std::cout << "Error: No database selected\n";
+                break;
+            }
 
-                if (type == "DATABASE")
+            try
+            {
+                switch (statement.type)
                 {
-                    std::string db_name;
-                    iss >> db_name;
-                    if (db_name.empty())
-                    {
-                        std::cout << "Error: Database name required\n";
-                        continue;
-                    }
+                case StatementType::HELP:
+                    printHelp();
+                    break;
+
+                case StatementType::EXIT:
+                    running = false;
+                    break;
 
+                case StatementType::CREATE_DATABASE:
                     if (current_db)
                     {
                         delete current_db;
                     }
-                    current_db = new Database(db_name);
-                    current_db_name = db_name;
-                    std::cout << "Database created: " << db_name << std::endl;
-                }
-                else if (type == "TABLE")
-                {
-                    if (!current_db)
-                    {
-                        std::cout << "Error: No database selected\n";
-                        continue;
-                    }
+                    current_db = new Database(statement.name);
+                    current_db_name = statement.name;
+                    std::cout << "Database created: " << statement.name << std::endl;
+                    break;
 
-                    std::string table_name;
-                    iss >> table_name;
-
-                    // Read column definitions
-                    std::string columnDefs;
-                    std::getline(iss, columnDefs);
-
-                    // Remove parentheses
-                    size_t first = columnDefs.find('(');
-                    size_t last = columnDefs.find_last_of(')');
-                    if (first == std::string::npos || last == std::string::npos)
-                    {
-                        std::cout << "Error: Invalid column definitions format\n";
-                        continue;
-                    }
-
-                    columnDefs = columnDefs.substr(first + 1, last - first - 1);
-                    std::vector<ColumnInfo> columns = parseColumnDefs(columnDefs);
-
-                    if (columns.empty())
+                case StatementType::USE_DATABASE:
+                    if (current_db)
                     {
-                        std::cout << "Error: No columns defined\n";
-                        continue;
+                        delete current_db;
                     }
+                    current_db = new Database(statement.name);
+                    current_db_name = statement.name;
+                    std::cout << "Using database: " << statement.name << std::endl;
+                    break;
 
-                    if (current_db->createTable(table_name, columns))
+                case StatementType::CREATE_TABLE:
+                    if (current_db->createTable(statement.create_table.table, statement.create_table.columns))
                     {
-                        std::cout << "Table created: " << table_name << std::endl;
+                        std::cout << "Table created: " << statement.create_table.table << std::endl;
                     }
                     else
                     {
                         std::cout << "Error creating table\n";
                     }
-                }
-                else if (type == "INDEX")
-                {
-                    if (!current_db)
-                    {
-                        std::cout << "Error: No database selected\n";
-                        continue;
-                    }
-
-                    std::string on, table_name, column_name;
-                    iss >> on;
-                    if (on != "ON")
-                    {
-                        std::cout << "Error: Invalid syntax. Use 'CREATE INDEX ON table(column)'\n";
-                        continue;
-                    }
-
-                    std::string tableAndColumn;
-                    iss >> tableAndColumn;
-
-                    size_t openParen = tableAndColumn.find('(');
-                    size_t closeParen = tableAndColumn.find(')');
+                    break;
 
-                    if (openParen == std::string::npos || closeParen == std::string::npos)
-                    {
-                        std::cout << "Error: Invalid syntax. Use 'CREATE INDEX ON table(column)'\n";
-                        continue;
-                    }
-
-                    table_name = tableAndColumn.substr(0, openParen);
-                    column_name = tableAndColumn.substr(openParen + 1, closeParen - openParen - 1);
-
-                    if (current_db->createIndex(table_name, column_name))
+                case StatementType::CREATE_INDEX:
+                {
+                    const std::string &table_name = statement.create_index.table;
+                    const std::vector<std::string> &columns = statement.create_index.columns;
+                    if (current_db->createIndex(table_name, columns, statement.create_index.included,
+                                                statement.create_index.hash))
                     {
-                        std::cout << "Index created successfully on " << table_name << "(" << column_name << ")\n";
+                        std::string column_list;
+                        for (const auto &column : columns)
+                        {
+                            column_list += (column_list.empty() ? "" : ", ") + column;
+                        }
+                        std::cout << "Index created successfully on " << table_name << "(" << column_list << ")\n";
 
                         // Verify index file exists
-                        std::string index_file = "./data/" + current_db_name + "/" + table_name + "_" + column_name + ".idx";
+                        std::string index_file = "./data/" + current_db_name + "/" +
+                                                 indexFileName(table_name, columns, statement.create_index.hash);
                         std::ifstream f(index_file.c_str());
                         if (f.good())
                         {
@@ -412,387 +248,86 @@ int main()
                     {
                         std::cout << "Error creating index\n";
                     }
-                }
-            }
-            else if (command == "USE")
-            {
-                std::string type, db_name;
-                iss >> type >> db_name;
-                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
-
-                if (type != "DATABASE")
-                {
-                    std::cout << "Error: Invalid syntax. Use 'USE DATABASE <name>'\n";
-                    continue;
+                    break;
                 }
 
-                if (current_db)
-                {
-                    delete current_db;
-                }
-                current_db = new Database(db_name);
-                current_db_name = db_name;
-                std::cout << "Using database: " << db_name << std::endl;
-            }
-            else if (command == "INSERT")
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string into, table_name, values;
-                iss >> into;
-                if (into != "INTO")
-                {
-                    std::cout << "Error: Invalid syntax. Use 'INSERT INTO table VALUES (...)'\n";
-                    continue;
-                }
-
-                iss >> table_name >> values;
-
-                // Parse values
-                size_t first = input.find('(');
-                size_t last = input.find_last_of(')');
-                if (first == std::string::npos || last == std::string::npos)
-                {
-                    std::cout << "Error: Invalid values format\n";
-                    continue;
-                }
-
-                std::string valueStr = input.substr(first + 1, last - first - 1);
-                std::vector<std::string> valueTokens = split(valueStr, ',');
-
-                if (current_db->insert(table_name, valueTokens))
-                {
-                    std::cout << "Record inserted successfully\n";
-                }
-                else
-                {
-                    std::cout << "Error inserting record\n";
-                }
-            }
-            else if (command == "SELECT")
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string rest_of_query;
-                std::getline(iss, rest_of_query);
-
-                // Check if this is a join query
-                if (rest_of_query.find("JOIN") != std::string::npos)
-                {
-                    // Parse join query (existing code)
-                    std::smatch matches;
-                    std::regex join_pattern(
-                        R"(^\s*\*\s+FROM\s+(\w+)\s+JOIN\s+(\w+)\s+ON\s+(\w+)\.(\w+)\s*=\s*(\w+)\.(\w+))");
-
-                    if (std::regex_search(rest_of_query, matches, join_pattern))
+                case StatementType::ANALYZE:
+                    if (current_db->analyze(statement.name))
                     {
-                        std::string left_table = matches[1];
-                        std::string right_table = matches[2];
-                        std::string left_table_col_ref = matches[3];
-                        std::string left_column = matches[4];
-                        std::string right_table_col_ref = matches[5];
-                        std::string right_column = matches[6];
-
-                        if (left_table != left_table_col_ref ||
-                            right_table != right_table_col_ref)
-                        {
-                            std::cout << "Error: Mismatched table references in join\n";
-                            continue;
-                        }
-
-                        current_db->join(left_table, right_table, left_column, right_column);
+                        std::cout << "Table analyzed: " << statement.name << std::endl;
                     }
                     else
                     {
-                        std::cout << "Error: Invalid join syntax\n";
-                        continue;
+                        std::cout << "Error analyzing table\n";
                     }
-                }
-                else
-                {
-                    // New parser for aggregate functions and regular selects
-                    std::regex simple_select(R"(^\s*\*\s+FROM\s+(\w+)\s*(WHERE\s+(.*))?)", std::regex_constants::icase);
-                    std::regex agg_select(R"(^\s*(COUNT\(\*\)|SUM\((\w+)\)|AVG\((\w+)\)|MIN\((\w+)\)|MAX\((\w+)\))\s+FROM\s+(\w+)\s*(WHERE\s+(.*))?)", std::regex_constants::icase);
-                    std::regex group_by_pattern(R"(^\s*(\w+)\s*,\s*(COUNT\(\*\)|SUM\((\w+)\)|AVG\((\w+)\)|MIN\((\w+)\)|MAX\((\w+)\))\s+FROM\s+(\w+)(\s+WHERE\s+(.*?))?(?:\s+GROUP\s+BY\s+(\w+))(?:\s+HAVING\s+(.*?))?\s*$)", std::regex_constants::icase);
-                                        
-                    std::smatch matches;
-
-                    if (std::regex_search(rest_of_query, matches, simple_select))
-                    {
-                        // Existing simple SELECT handling
-                        std::string table_name = matches[1];
-                        std::string where_clause = matches[3];
+                    break;
 
-                        if (where_clause.empty())
-                        {
-                            current_db->select(table_name);
-                        }
-                        else
-                        {
-                            std::vector<std::string> where_parts = split(where_clause, ' ');
-                            if (where_parts.size() >= 3)
-                            {
-                                std::vector<Record> results;
-                                current_db->selectWithCondition(table_name, where_parts[0], where_parts[1], where_parts[2], results);
-                            }
-                        }
-                    }
-                    else if (std::regex_search(rest_of_query, matches, agg_select))
+                case StatementType::INSERT:
+                    for (const auto &row : statement.insert.rows)
                     {
-                        // Extract components correctly
-                        std::string agg_func = matches[1].str();
-                        std::string table_name = matches[6].str();
-                        std::string where_clause = matches[8].str();
-
-                        std::vector<Record> results;
-                        if (where_clause.empty())
+                        if (current_db->insert(statement.insert.table, row))
                         {
-                            current_db->selectWithCondition(table_name, agg_func, "", "", results);
+                            std::cout << "Record inserted successfully\n";
                         }
                         else
                         {
-                            std::vector<std::string> where_parts = split(where_clause, ' ');
-                            if (where_parts.size() >= 3)
-                            {
-                                current_db->selectWithCondition(table_name, agg_func, where_parts[0], where_parts[2], results);
-                            }
+                            std::cout << "Error inserting record\n";
                         }
                     }
-                    else if (std::regex_search(rest_of_query, matches, group_by_pattern))
+                    break;
+
+                case StatementType::SELECT:
+                    if (!current_db->executeSelect(statement.select))
                     {
-                        std::string group_column = matches[10].str();  // GROUP BY column
-    std::string agg_function = matches[2].str();   // Aggregate function
-    std::string table_name = matches[7].str();     // Table name
-    std::string where_clause = matches[9].str();   // WHERE clause (may be empty)
-                        std::string having_clause = matches[12].str(); // HAVING clause (may be empty)
-    
-    // Debug output
-    std::cout << "DEBUG - Parsed GROUP BY query:\n"
-              << "Table: " << table_name << "\n"
-              << "Group Column: " << group_column << "\n"
-              << "Agg Function: " << agg_function << "\n"
-              << "Where Clause: " << (where_clause.empty() ? "(none)" : where_clause) << "\n"
-              << "Having Clause: " << (having_clause.empty() ? "(none)" : having_clause) << "\n";
-    
-              std::vector<Record> results = current_db->groupQuery(
-                table_name, group_column, agg_function, where_clause, having_clause);
-
-                        // Display results
-                        std::cout << "\nQuery Results (" << results.size() << " groups):\n";
-                        std::cout << "----------------------------------------\n";
-                        std::cout << std::setw(15) << std::left << group_column << " | ";
-                        std::cout << std::setw(15) << std::left << agg_function << "\n";
-                        std::cout << "----------------------------------------\n";
-                        for (const auto &record : results)
-                        {
-                            std::cout << std::setw(15) << std::left << record.values[0] << " | ";
-                            std::cout << std::setw(15) << std::left << record.values[1] << "\n";
-                        }
-                        std::cout << "----------------------------------------\n";
+                        std::cout << "Error executing SELECT query\n";
                     }
+                    break;
 
-                    else
+                case StatementType::EXPLAIN:
+                    if (!current_db->explainSelect(statement.select, statement.explain_analyze))
                     {
-                        std::cout << "Invalid SELECT syntax. Supported formats:\n"
-                                  << "  SELECT * FROM table [WHERE cond]\n"
-                                  << "  SELECT COUNT(*) FROM table\n"
-                                  << "  SELECT SUM(column) FROM table\n"
-                                  << "  SELECT * FROM table1 JOIN table2 ON...\n";
+                        std::cout << "Error explaining SELECT query\n";
                     }
-                }
-            }
-            else if (command == "UPDATE")
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string table_name, set, set_clause, where, where_clause;
-                iss >> table_name >> set;
-
-                if (set != "SET")
-                {
-                    std::cout << "Error: Invalid syntax. Use 'UPDATE table SET column = value WHERE condition'\n";
-                    continue;
-                }
-
-                // Get SET clause
-                size_t wherePos = input.find(" WHERE ");
-                if (wherePos == std::string::npos)
-                {
-                    std::cout << "Error: WHERE clause required\n";
-                    continue;
-                }
-
-                set_clause = input.substr(input.find("SET ") + 4, wherePos - (input.find("SET ") + 4));
-                where_clause = input.substr(wherePos + 7);
-
-                if (current_db->update(table_name, set_clause, where_clause))
-                {
-                    std::cout << "Records updated successfully\n";
-                }
-                else
-                {
-                    std::cout << "Error updating records\n";
-                }
-            }
-            else if (command == "DELETE")
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string from, table_name, where, condition;
-                iss >> from;
+                    break;
 
-                if (from != "FROM")
-                {
-                    std::cout << "Error: Invalid syntax. Use 'DELETE FROM table WHERE condition'\n";
-                    continue;
-                }
-
-                iss >> table_name >> where;
-                if (where != "WHERE")
-                {
-                    std::cout << "Error: WHERE clause required\n";
-                    continue;
-                }
-
-                std::getline(iss, condition);
-                condition = condition.substr(condition.find_first_not_of(" \t"));
-
-                if (current_db->remove(table_name, condition))
-                {
-                    std::cout << "Records deleted successfully\n";
-                }
-                else
-                {
-                    std::cout << "Error deleting records\n";
-                }
-            }
-            else if (command == "DROP")
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string type, table_name;
-                iss >> type;
-                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
-
-                if (type != "TABLE")
-                {
-                    std::cout << "Error: Invalid syntax. Use 'DROP TABLE <name>'\n";
-                    continue;
-                }
-
-                iss >> table_name;
-                if (current_db->dropTable(table_name))
-                {
-                    std::cout << "Table dropped: " << table_name << std::endl;
-                }
-                else
-                {
-                    std::cout << "Error dropping table\n";
-                }
-            }
-            else if (command == "BEGIN") {
-                std::string type;
-                iss >> type;
-                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
-                
-                if (type == "TRANSACTION") {
-                    if (!current_db) {
-                        std::cout << "Error: No database selected\n";
-                        continue;
+                case StatementType::UPDATE:
+                    if (current_db->update(statement.update.table, statement.update.assignments,
+                                           statement.update.where.get()))
+                    {
+                        std::cout << "Records updated successfully\n";
                     }
-                    int transaction_id = current_db->beginTransaction();
-                    if (transaction_id != -1) {
-                        current_transaction_id = transaction_id;
-                        std::cout << "Transaction started with ID: " << transaction_id << std::endl;
-                    } else {
-                        std::cout << "Failed to start transaction\n";
+                    else
+                    {
+                        std::cout << "Error updating records\n";
                     }
-                } else {
-                    std::cout << "Unknown command. Type 'HELP' for available commands\n";
-                }
-            }
-            else if (command == "COMMIT") {
-                if (!current_db) {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-                if (current_transaction_id == -1) {
-                    std::cout << "No active transaction\n";
-                } else {
-                    if (current_db->commitTransaction(current_transaction_id)) {
-                        std::cout << "Transaction committed successfully\n";
-                        current_transaction_id = -1;
-                    } else {
-                        std::cout << "Failed to commit transaction\n";
+                    break;
+
+                case StatementType::DELETE:
+                    if (current_db->remove(statement.remove.table, statement.remove.where.get()))
+                    {
+                        std::cout << "Records deleted successfully\n";
                     }
-                }
-            }
-            else if (command == "ROLLBACK") {
-                if (!current_db) {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-                if (current_transaction_id == -1) {
-                    std::cout << "No active transaction\n";
-                } else {
-                    if (current_db->abortTransaction(current_transaction_id)) {
-                        std::cout << "Transaction rolled back successfully\n";
-                        current_transaction_id = -1;
-                    } else {
-                        std::cout << "Failed to roll back transaction\n";
+                    else
+                    {
+                        std::cout << "Error deleting records\n";
                     }
-                }
-            }
-            else if (command == "DROP")   // main
-            {
-                if (!current_db)
-                {
-                    std::cout << "Error: No database selected\n";
-                    continue;
-                }
-
-                std::string type, name;
-                iss >> type;
-                std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+                    break;
 
-                if (type == "TABLE")
-                {
-                    iss >> name;
-                    if (current_db->dropTable(name))
+                case StatementType::DROP_TABLE:
+                    if (current_db->dropTable(statement.name))
                     {
-                        std::cout << "Table dropped: " << name << std::endl;
+                        std::cout << "Table dropped: " << statement.name << std::endl;
                     }
                     else
                     {
                         std::cout << "Error dropping table\n";
                     }
-                }
-                else if (type == "DATABASE")
-                {
-                    iss >> name;
-                    if (name == current_db_name)
+                    break;
+
+                case StatementType::DROP_DATABASE:
+                    if (statement.name == current_db_name)
                     {
-                        if (current_db->dropDatabase(name))
+                        if (current_db->dropDatabase(statement.name))
                         {
                             delete current_db;
                             current_db = nullptr;
@@ -807,20 +342,65 @@ int main()
                     {
                         std::cout << "Cannot drop database - not currently using it\n";
                     }
-                }
-                else
+                    break;
+
+                case StatementType::BEGIN:
                 {
-                    std::cout << "Error: Invalid syntax. Use 'DROP TABLE <name>' or 'DROP DATABASE <name>'\n";
+                    int transaction_id = current_db->beginTransaction();
+                    if (transaction_id != -1)
+                    {
+                        current_transaction_id = transaction_id;
+                        std::cout << "Transaction started with ID: " << transaction_id << std::endl;
+                    }
+                    else
+                    {
+                        std::cout << "Failed to start transaction\n";
+                    }
+                    break;
+                }
+
+                case StatementType::COMMIT:
+                    if (current_transaction_id == -1)
+                    {
+                        std::cout << "No active transaction\n";
+                    }
+                    else if (current_db->commitTransaction(current_transaction_id))
+                    {
+                        std::cout << "Transaction committed successfully\n";
+                        current_transaction_id = -1;
+                    }
+                    else
+                    {
+                        std::cout << "Failed to commit transaction\n";
+                    }
+                    break;
+
+                case StatementType::ROLLBACK:
+                    if (current_transaction_id == -1)
+                    {
+                        std::cout << "No active transaction\n";
+                    }
+                    else if (current_db->abortTransaction(current_transaction_id))
+                    {
+                        std::cout << "Transaction rolled back successfully\n";
+                        current_transaction_id = -1;
+                    }
+                    else
+                    {
+                        std::cout << "Failed to roll back transaction\n";
+                    }
+                    break;
                 }
             }
-            else
+            catch (const std::exception &e)
             {
-                std::cout << "Unknown command. Type 'HELP' for available commands\n";
+                std::cout << "Error: " << e.what() << std::endl;
+            }
+
+            if (!running)
+            {
+                break;
             }
-        }
-        catch (const std::exception &e)
-        {
-            std::cout << "Error: " << e.what() << std::endl;
         }
     }
 
@@ -830,4 +410,4 @@ int main()
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,1161 @@
+#include "operators.h"
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    // Marks the row positions a bound expression reads
+    void markBoundColumns(const Expression* expression, std::vector<bool>& columns) {
+        if (expression->column_index >= 0) {
+            if (static_cast<size_t>(expression->column_index) < columns.size()) {
+                columns[expression->column_index] = true;
+            }
+            return;
+        }
+        for (const auto& child : expression->children) {
+            markBoundColumns(child.get(), columns);
+        }
+    }
+
+    // "./data/db/users.dat" -> "users"
+    std::string fileStem(const std::string& path) {
+        size_t start = path.find_last_of('/');
+        start = start == std::string::npos ? 0 : start + 1;
+        size_t end = path.find_last_of('.');
+        if (end == std::string::npos || end < start) end = path.size();
+        return path.substr(start, end - start);
+    }
+
+    std::string joinExpressions(const std::vector<const Expression*>& expressions) {
+        std::string text;
+        for (size_t i = 0; i < expressions.size(); i++) {
+            if (i > 0) text += ", ";
+            text += expressions[i]->toString();
+        }
+        return text;
+    }
+
+    // A key value as it would be written in SQL, strings quoted
+    std::string keyText(const Value& value) {
+        return Expression::makeLiteral(value)->toString();
+    }
+
+    // A left and a right row side by side; a missing side is all NULL
+    Record joinRows(const Record* left, size_t left_width, const Record* right, size_t right_width) {
+        Record joined;
+        if (left) {
+            joined.values = left->values;
+            joined.values.resize(left_width);
+        } else {
+            joined.values.assign(left_width, Value());
+        }
+        if (right) {
+            joined.values.insert(joined.values.end(), right->values.begin(), right->values.end());
+            joined.values.resize(left_width + right_width);
+        } else {
+            joined.values.insert(joined.values.end(), right_width, Value());
+        }
+        return joined;
+    }
+
+    std::string joinKind(JoinType type) {
+        switch (type) {
+        case JoinType::LEFT: return "Left ";
+        case JoinType::RIGHT: return "Right ";
+        case JoinType::FULL: return "Full ";
+        default: return "";
+        }
+    }
+
+    // Join partitions store each record as its uint32 length, a uint32
+    // value count and the values in Value::serialize form. Joined rows may
+    // be wider than a stored record, so the count is not capped as in
+    // Record::serialize.
+    void writeSpilledRecord(std::ofstream& file, const Record& record) {
+        size_t size = sizeof(uint32_t);
+        for (const Value& value : record.values) {
+            size += value.getSerializedSize();
+        }
+        std::vector<char> data(size);
+        uint32_t count = static_cast<uint32_t>(record.values.size());
+        memcpy(data.data(), &count, sizeof(uint32_t));
+        size_t pos = sizeof(uint32_t);
+        for (const Value& value : record.values) {
+            pos += value.serialize(data.data() + pos);
+        }
+        uint32_t length = static_cast<uint32_t>(data.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(uint32_t));
+        file.write(data.data(), length);
+    }
+
+    // False at the end of the file, or with failed set on a truncated or
+    // malformed record
+    bool readSpilledRecord(std::ifstream& file, Record& record, bool& failed) {
+        failed = false;
+        uint32_t length = 0;
+        if (!file.read(reinterpret_cast<char*>(&length), sizeof(uint32_t))) {
+            failed = file.gcount() != 0 || !file.eof();
+            return false;
+        }
+        std::vector<char> data(length);
+        uint32_t count = 0;
+        if (length < sizeof(uint32_t) || !file.read(data.data(), length)) {
+            failed = true;
+            return false;
+        }
+        memcpy(&count, data.data(), sizeof(uint32_t));
+        record = Record();
+        record.values.resize(count);
+        size_t pos = sizeof(uint32_t);
+        for (Value& value : record.values) {
+            size_t consumed = pos < length ? value.deserialize(data.data() + pos, length - pos) : 0;
+            if (consumed == 0) {
+                failed = true;
+                return false;
+            }
+            pos += consumed;
+        }
+        failed = pos != length;
+        return !failed;
+    }
+
+    std::string keyText(const IndexKey& key) {
+        std::string text;
+        for (size_t i = 0; i < key.size(); i++) {
+            if (i > 0) text += ", ";
+            text += keyText(key[i]);
+        }
+        return key.size() == 1 ? text : "(" + text + ")";
+    }
+
+    // Key conditions of a range: the equalities on the leading columns both
+    // bounds agree on, then the bounds on the next column
+    std::string rangeText(const KeyRange& range, const std::vector<int>& key_columns, const Schema& schema) {
+        size_t equal = 0;
+        while (range.has_low && range.has_high && equal < range.low.size() && equal < range.high.size() &&
+               range.low[equal] == range.high[equal] &&
+               (equal + 1 < std::max(range.low.size(), range.high.size()) ||
+                (range.low_inclusive && range.high_inclusive))) {
+            equal++;
+        }
+
+        std::string bounds;
+        for (size_t i = 0; i < equal; i++) {
+            if (!bounds.empty()) bounds += " AND ";
+            bounds += schema[key_columns[i]].name + " = " + keyText(range.low[i]);
+        }
+        if (range.has_low && range.low.size() > equal) {
+            if (!bounds.empty()) bounds += " AND ";
+            bounds += schema[key_columns[equal]].name + (range.low_inclusive ? " >= " : " > ") +
+                      keyText(range.low[equal]);
+        }
+        if (range.has_high && range.high.size() > equal) {
+            if (!bounds.empty()) bounds += " AND ";
+            bounds += schema[key_columns[equal]].name + (range.high_inclusive ? " <= " : " < ") +
+                      keyText(range.high[equal]);
+        }
+        return bounds;
+    }
+}
+
+SeqScanOperator::SeqScanOperator(StorageManager* storage_manager, const std::string& data_file, Schema schema,
+                                 std::vector<bool> columns, const Expression* filter)
+    : Operator(std::move(schema)), data_file(data_file), columns(std::move(columns)), filter(filter),
+      iterator(storage_manager, data_file) {
+    ScanProjection projection;
+    projection.columns = this->columns;
+    if (filter) {
+        projection.filter_columns.assign(this->schema.size(), false);
+        markBoundColumns(filter, projection.filter_columns);
+        projection.filter = [filter](const Record& row) { return filter->isTrue(row); };
+    }
+    iterator.setProjection(std::move(projection));
+}
+
+std::string SeqScanOperator::describe() const {
+    std::string text = "Seq Scan on " + fileStem(data_file);
+    if (filter) {
+        text += ", filter (" + filter->toString() + ")";
+    }
+    if (std::find(columns.begin(), columns.end(), false) != columns.end()) {
+        std::string names;
+        for (size_t i = 0; i < columns.size() && i < schema.size(); i++) {
+            if (!columns[i]) continue;
+            if (!names.empty()) names += ", ";
+            names += schema[i].name;
+        }
+        text += ", columns (" + names + ")";
+    }
+    return text;
+}
+
+bool SeqScanOperator::open() {
+    iterator.reset();
+    return true;
+}
+
+bool SeqScanOperator::next(Record& row) {
+    return iterator.next(row);
+}
+
+IndexLookupOperator::IndexLookupOperator(StorageManager* storage_manager, IndexManager* index_manager,
+                                         const std::string& data_file, const std::string& index_file,
+                                         const IndexKey& key, Schema schema)
+    : Operator(std::move(schema)), storage_manager(storage_manager), index_manager(index_manager),
+      data_file(data_file), index_file(index_file), key(key), found(false), done(false) {}
+
+bool IndexLookupOperator::open() {
+    found = false;
+    done = false;
+
+    RID rid;
+    if (!index_manager->lookup(index_file, key, rid)) {
+        return true;  // No such key
+    }
+    found = storage_manager->getRecord(data_file, rid, match);
+    if (!found) {
+        std::cerr << "Index entry for key " << keyText(key) << " points to a missing row in " << data_file << std::endl;
+    }
+    return found;
+}
+
+bool IndexLookupOperator::next(Record& row) {
+    if (!found || done) {
+        return false;
+    }
+    done = true;
+    row = match;
+    return true;
+}
+
+void IndexLookupOperator::close() {
+    found = false;
+}
+
+std::string IndexLookupOperator::describe() const {
+    return "Index Lookup on " + fileStem(data_file) + " using " + fileStem(index_file) +
+           " (key = " + keyText(key) + ")";
+}
+
+IndexRangeScanOperator::IndexRangeScanOperator(StorageManager* storage_manager, IndexManager* index_manager,
+                                               const std::string& data_file, const std::string& index_file,
+                                               const KeyRange& range, std::vector<int> key_columns, Schema schema)
+    : Operator(std::move(schema)), storage_manager(storage_manager), index_manager(index_manager),
+      data_file(data_file), index_file(index_file), range(range), key_columns(std::move(key_columns)),
+      position(0) {}
+
+bool IndexRangeScanOperator::open() {
+    rids.clear();
+    position = 0;
+    return index_manager->scanRange(index_file, range, rids);
+}
+
+bool IndexRangeScanOperator::next(Record& row) {
+    while (position < rids.size()) {
+        const RID& rid = rids[position++];
+        if (storage_manager->getRecord(data_file, rid, row)) {
+            return true;
+        }
+        std::cerr << "Index entry points to a missing row at page " << rid.page_id << ", slot " << rid.slot
+                  << " of " << data_file << std::endl;
+    }
+    return false;
+}
+
+void IndexRangeScanOperator::close() {
+    rids.clear();
+}
+
+std::string IndexRangeScanOperator::describe() const {
+    std::string bounds = rangeText(range, key_columns, schema);
+    if (bounds.empty()) {
+        return "Full Index Scan on " + fileStem(data_file) + " using " + fileStem(index_file);
+    }
+    return "Index Range Scan on " + fileStem(data_file) + " using " + fileStem(index_file) + " (" + bounds + ")";
+}
+
+IndexOnlyScanOperator::IndexOnlyScanOperator(IndexManager* index_manager, const std::string& data_file,
+                                             const std::string& index_file, const KeyRange& range,
+                                             std::vector<int> key_columns, std::vector<int> included_columns,
+                                             Schema schema)
+    : Operator(std::move(schema)), index_manager(index_manager), data_file(data_file), index_file(index_file),
+      range(range), key_columns(std::move(key_columns)), included_columns(std::move(included_columns)),
+      position(0) {}
+
+bool IndexOnlyScanOperator::open() {
+    entries.clear();
+    position = 0;
+    return index_manager->scanEntries(index_file, range, entries);
+}
+
+bool IndexOnlyScanOperator::next(Record& row) {
+    if (position >= entries.size()) {
+        return false;
+    }
+    const IndexEntry& entry = entries[position++];
+    row.values.assign(schema.size(), Value());
+    for (size_t i = 0; i < key_columns.size() && i < entry.key.size(); i++) {
+        row.values[key_columns[i]] = entry.key[i];
+    }
+    for (size_t i = 0; i < included_columns.size() && i < entry.included.size(); i++) {
+        row.values[included_columns[i]] = entry.included[i];
+    }
+    row.rid = entry.rid;
+    return true;
+}
+
+void IndexOnlyScanOperator::close() {
+    entries.clear();
+}
+
+std::string IndexOnlyScanOperator::describe() const {
+    return "Index Only Scan on " + fileStem(data_file) + " using " + fileStem(index_file) + " (" +
+           rangeText(range, key_columns, schema) + ")";
+}
+
+FilterOperator::FilterOperator(OperatorPtr child, const Expression* predicate)
+    : FilterOperator(std::move(child), std::vector<const Expression*>{predicate}) {}
+
+FilterOperator::FilterOperator(OperatorPtr child, std::vector<const Expression*> conjuncts)
+    : Operator(child->getSchema()), child(std::move(child)), conjuncts(std::move(conjuncts)) {}
+
+bool FilterOperator::next(Record& row) {
+    while (child->next(row)) {
+        if (std::all_of(conjuncts.begin(), conjuncts.end(),
+                        [&](const Expression* conjunct) { return conjunct->isTrue(row); })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string FilterOperator::describe() const {
+    std::string text;
+    for (size_t i = 0; i < conjuncts.size(); i++) {
+        if (i > 0) text += " AND ";
+        bool wrap = conjuncts.size() > 1 && conjuncts[i]->type == ExpressionType::OR;
+        text += wrap ? "(" + conjuncts[i]->toString() + ")" : conjuncts[i]->toString();
+    }
+    return "Filter (" + text + ")";
+}
+
+ProjectOperator::ProjectOperator(OperatorPtr child, std::vector<const Expression*> expressions, Schema schema)
+    : Operator(std::move(schema)), child(std::move(child)), expressions(std::move(expressions)) {}
+
+bool ProjectOperator::next(Record& row) {
+    if (!child->next(input)) {
+        return false;
+    }
+    row.values.clear();
+    for (const Expression* expression : expressions) {
+        row.values.push_back(expression->evaluate(input));
+    }
+    row.rid = input.rid;
+    return true;
+}
+
+std::string ProjectOperator::describe() const {
+    return "Project (" + joinExpressions(expressions) + ")";
+}
+
+JoinOperator::JoinOperator(OperatorPtr left, OperatorPtr right, JoinType type, const Expression* condition,
+                           bool build_left)
+    : Operator(left->getSchema()), left(std::move(left)), right(std::move(right)),
+      type(type), condition(condition), build_left(build_left), has_probe(false), probe_matched(false),
+      probe_done(false), candidate(0), unmatched(0) {
+    const Schema& right_schema = this->right->getSchema();
+    left_width = schema.size();
+    right_width = right_schema.size();
+    schema.insert(schema.end(), right_schema.begin(), right_schema.end());
+}
+
+bool JoinOperator::open() {
+    if (!left->open() || !right->open()) {
+        return false;
+    }
+
+    if (!readBuild()) {
+        return false;
+    }
+    build();
+    startBatch();
+    return true;
+}
+
+bool JoinOperator::readBuild() {
+    build_rows.clear();
+    Record row;
+    while (buildInput()->next(row)) {
+        build_rows.push_back(row);
+    }
+    buildInput()->close();
+    return true;
+}
+
+void JoinOperator::startBatch() {
+    build_matched.assign(build_rows.size(), false);
+    has_probe = false;
+    probe_done = false;
+    candidates.clear();
+    candidate = 0;
+    unmatched = 0;
+}
+
+bool JoinOperator::next(Record& row) {
+    while (true) {
+        // Remaining build rows for the current probe row
+        while (candidate < candidates.size()) {
+            size_t i = candidates[candidate++];
+            Record joined = combine(&probe_row, &build_rows[i]);
+            if (!condition || condition->isTrue(joined)) {
+                probe_matched = true;
+                build_matched[i] = true;
+                row = std::move(joined);
+                return true;
+            }
+        }
+
+        if (has_probe) {
+            has_probe = false;
+            if (!probe_matched && preservesProbe()) {
+                row = combine(&probe_row, nullptr);
+                return true;
+            }
+        }
+
+        if (!probe_done) {
+            if (nextProbe(probe_row)) {
+                has_probe = true;
+                probe_matched = false;
+                candidates.clear();
+                candidate = 0;
+                findCandidates(probe_row, candidates);
+                continue;
+            }
+            probe_done = true;
+        }
+
+        // Outer join of the build side: build rows no probe row matched
+        if (preservesBuild()) {
+            while (unmatched < build_rows.size()) {
+                size_t i = unmatched++;
+                if (!build_matched[i]) {
+                    row = combine(nullptr, &build_rows[i]);
+                    return true;
+                }
+            }
+        }
+
+        if (!nextBatch()) {
+            return false;
+        }
+        build();
+        startBatch();
+    }
+}
+
+void JoinOperator::close() {
+    probeInput()->close();
+    build_rows.clear();
+    build_matched.clear();
+}
+
+std::string JoinOperator::describe() const {
+    std::string text = joinKind(type) + algorithm();
+    if (condition) {
+        text += " (" + condition->toString() + ")";
+    }
+    return text + ", build " + (build_left ? "left" : "right");
+}
+
+void JoinOperator::forEachChild(const std::function<void(OperatorPtr&)>& visit) {
+    visit(left);
+    visit(right);
+}
+
+bool JoinOperator::preservesProbe() const {
+    return type == JoinType::FULL || type == (build_left ? JoinType::RIGHT : JoinType::LEFT);
+}
+
+bool JoinOperator::preservesBuild() const {
+    return type == JoinType::FULL || type == (build_left ? JoinType::LEFT : JoinType::RIGHT);
+}
+
+Record JoinOperator::combine(const Record* probe, const Record* build) const {
+    return build_left ? joinRows(build, left_width, probe, right_width)
+                      : joinRows(probe, left_width, build, right_width);
+}
+
+void NestedLoopJoinOperator::findCandidates(const Record&, std::vector<size_t>& candidates) {
+    for (size_t i = 0; i < build_rows.size(); i++) {
+        candidates.push_back(i);
+    }
+}
+
+HashJoinOperator::HashJoinOperator(OperatorPtr left, OperatorPtr right, JoinType type,
+                                   const Expression* condition, int left_key, int right_key, bool build_left,
+                                   const std::string& spill_prefix)
+    : JoinOperator(std::move(left), std::move(right), type, condition, build_left),
+      probe_key(build_left ? right_key : left_key), build_key(build_left ? left_key : right_key),
+      spill_prefix(spill_prefix), spilled(false), partition(0) {}
+
+void HashJoinOperator::close() {
+    JoinOperator::close();
+    table.clear();
+    probe_file.close();
+    removePartitions();
+}
+
+std::string HashJoinOperator::describe() const {
+    std::string text = JoinOperator::describe();
+    if (spilled) {
+        text += ", spilled to " + std::to_string(PARTITIONS) + " partitions";
+    }
+    return text;
+}
+
+bool HashJoinOperator::readBuild() {
+    build_rows.clear();
+    spilled = false;
+    size_t bytes = 0;
+    Record row;
+    while (buildInput()->next(row)) {
+        bytes += row.getSize();
+        build_rows.push_back(row);
+        if (bytes > MEMORY_BYTES && !spill_prefix.empty()) {
+            return spill();
+        }
+    }
+    buildInput()->close();
+    return true;
+}
+
+void HashJoinOperator::build() {
+    table.clear();
+    for (size_t i = 0; i < build_rows.size(); i++) {
+        if (build_key >= static_cast<int>(build_rows[i].values.size())) continue;
+        const Value& key = build_rows[i].values[build_key];
+        if (!key.isNull()) {
+            table.emplace(key, i);
+        }
+    }
+}
+
+void HashJoinOperator::findCandidates(const Record& probe, std::vector<size_t>& candidates) {
+    if (probe_key >= static_cast<int>(probe.values.size()) || probe.values[probe_key].isNull()) {
+        return;
+    }
+    auto range = table.equal_range(probe.values[probe_key]);
+    for (auto it = range.first; it != range.second; ++it) {
+        candidates.push_back(it->second);
+    }
+    // Keep build order so results do not depend on hash bucket layout
+    std::sort(candidates.begin(), candidates.end());
+}
+
+bool HashJoinOperator::nextProbe(Record& row) {
+    if (!spilled) {
+        return JoinOperator::nextProbe(row);
+    }
+    bool malformed;
+    if (!readSpilledRecord(probe_file, row, malformed)) {
+        if (malformed) {
+            std::cerr << "Failed to read join partition: " << partitionName("probe", partition) << std::endl;
+            has_error = true;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool HashJoinOperator::nextBatch() {
+    if (!spilled) {
+        return false;
+    }
+    probe_file.close();
+    std::error_code ec;
+    std::filesystem::remove(partitionName("build", partition), ec);
+    std::filesystem::remove(partitionName("probe", partition), ec);
+    if (++partition == PARTITIONS) {
+        return false;
+    }
+    if (!loadPartition()) {
+        has_error = true;
+        return false;
+    }
+    return true;
+}
+
+std::string HashJoinOperator::partitionName(const char* side, size_t i) const {
+    return spill_prefix + "." + side + std::to_string(i);
+}
+
+size_t HashJoinOperator::partitionOf(const Record& row, int key) const {
+    if (key >= static_cast<int>(row.values.size()) || row.values[key].isNull()) {
+        return 0;  // Never matches, but must still reach an outer join's output
+    }
+    // The in-memory table of a partition buckets on the same hash, so mix
+    // it first to keep each partition's keys spread over its buckets
+    uint64_t hash = row.values[key].hash() * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash >> 32) % PARTITIONS;
+}
+
+bool HashJoinOperator::spill() {
+    spilled = true;
+    std::cout << "Hash join build side exceeds " << MEMORY_BYTES / (1024 * 1024) << " MB, partitioning both inputs into "
+              << PARTITIONS << " files" << std::endl;
+
+    std::vector<std::ofstream> build_files, probe_files;
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        build_files.emplace_back(partitionName("build", i), std::ios::binary | std::ios::trunc);
+        probe_files.emplace_back(partitionName("probe", i), std::ios::binary | std::ios::trunc);
+        if (!build_files.back() || !probe_files.back()) {
+            std::cerr << "Failed to create join partition: " << partitionName("build", i) << std::endl;
+            return false;
+        }
+    }
+
+    for (const Record& row : build_rows) {
+        writeSpilledRecord(build_files[partitionOf(row, build_key)], row);
+    }
+    build_rows.clear();
+    build_rows.shrink_to_fit();
+    Record row;
+    while (buildInput()->next(row)) {
+        writeSpilledRecord(build_files[partitionOf(row, build_key)], row);
+    }
+    buildInput()->close();
+    while (probeInput()->next(row)) {
+        writeSpilledRecord(probe_files[partitionOf(row, probe_key)], row);
+    }
+
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        build_files[i].close();
+        probe_files[i].close();
+        if (!build_files[i] || !probe_files[i]) {
+            std::cerr << "Failed to write join partition " << i << " of " << spill_prefix << std::endl;
+            return false;
+        }
+    }
+    partition = 0;
+    return loadPartition();
+}
+
+// A partition larger than MEMORY_BYTES (many rows sharing one key) is
+// still joined in memory rather than split again
+bool HashJoinOperator::loadPartition() {
+    build_rows.clear();
+    std::ifstream build_file(partitionName("build", partition), std::ios::binary);
+    Record row;
+    bool malformed = !build_file;
+    while (!malformed && readSpilledRecord(build_file, row, malformed)) {
+        build_rows.push_back(row);
+    }
+    probe_file.open(partitionName("probe", partition), std::ios::binary);
+    if (malformed || !probe_file) {
+        std::cerr << "Failed to read join partition " << partition << " of " << spill_prefix << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void HashJoinOperator::removePartitions() {
+    if (!spilled) return;
+    std::error_code ec;
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        std::filesystem::remove(partitionName("build", i), ec);
+        std::filesystem::remove(partitionName("probe", i), ec);
+    }
+}
+
+MergeJoinOperator::MergeJoinOperator(OperatorPtr left, OperatorPtr right, JoinType type,
+                                     const Expression* condition, int left_key, int right_key, bool sort_left,
+                                     bool sort_right)
+    : Operator(left->getSchema()), type(type), condition(condition), left_position(0), right_position(0),
+      left_matched(false), unmatched(0) {
+    const Schema& right_schema = right->getSchema();
+    left_width = schema.size();
+    right_width = right_schema.size();
+    schema.insert(schema.end(), right_schema.begin(), right_schema.end());
+    this->left.child = std::move(left);
+    this->left.key = left_key;
+    this->left.sort = sort_left;
+    this->right.child = std::move(right);
+    this->right.key = right_key;
+    this->right.sort = sort_right;
+}
+
+bool MergeJoinOperator::Input::open() {
+    if (!child->open()) {
+        return false;
+    }
+    rows.clear();
+    position = 0;
+    if (sort) {
+        Record record;
+        while (child->next(record)) {
+            if (key >= static_cast<int>(record.values.size())) record.values.resize(key + 1);
+            rows.push_back(record);
+        }
+        child->close();
+        std::stable_sort(rows.begin(), rows.end(), [this](const Record& a, const Record& b) {
+            return a.values[key] < b.values[key];
+        });
+    }
+    advance();
+    return true;
+}
+
+void MergeJoinOperator::Input::advance() {
+    if (!sort) {
+        has_row = child->next(row);
+    } else if (position < rows.size()) {
+        row = std::move(rows[position++]);
+        has_row = true;
+    } else {
+        has_row = false;
+    }
+    // A short row is treated as a NULL key
+    if (has_row && key >= static_cast<int>(row.values.size())) {
+        row.values.resize(key + 1);
+    }
+}
+
+const Value& MergeJoinOperator::Input::keyValue() const {
+    return row.values[key];
+}
+
+bool MergeJoinOperator::open() {
+    left_group.clear();
+    right_group.clear();
+    right_matched.clear();
+    left_position = 0;
+    right_position = 0;
+    left_matched = false;
+    unmatched = 0;
+    return left.open() && right.open();
+}
+
+bool MergeJoinOperator::nextGroups() {
+    left_group.clear();
+    right_group.clear();
+    if (!left.has_row && !right.has_row) {
+        return false;
+    }
+
+    // A NULL key matches nothing, so its row forms a group on its own
+    if (left.has_row && left.keyValue().isNull()) {
+        left_group.push_back(std::move(left.row));
+        left.advance();
+        return true;
+    }
+    if (right.has_row && right.keyValue().isNull()) {
+        right_group.push_back(std::move(right.row));
+        right.advance();
+        return true;
+    }
+
+    int c = !left.has_row ? 1 : !right.has_row ? -1 : left.keyValue().compare(right.keyValue());
+    if (c <= 0) {
+        Value key = left.keyValue();
+        do {
+            left_group.push_back(std::move(left.row));
+            left.advance();
+        } while (left.has_row && left.keyValue() == key);
+    }
+    if (c >= 0) {
+        Value key = right.keyValue();
+        do {
+            right_group.push_back(std::move(right.row));
+            right.advance();
+        } while (right.has_row && right.keyValue() == key);
+    }
+    return true;
+}
+
+bool MergeJoinOperator::next(Record& row) {
+    while (true) {
+        // Pairs of the current left row with the right group
+        while (left_position < left_group.size()) {
+            const Record& left_row = left_group[left_position];
+            while (right_position < right_group.size()) {
+                size_t i = right_position++;
+                Record joined = joinRows(&left_row, left_width, &right_group[i], right_width);
+                if (!condition || condition->isTrue(joined)) {
+                    left_matched = true;
+                    right_matched[i] = true;
+                    row = std::move(joined);
+                    return true;
+                }
+            }
+            left_position++;
+            right_position = 0;
+            bool matched = left_matched;
+            left_matched = false;
+            if (!matched && (type == JoinType::LEFT || type == JoinType::FULL)) {
+                row = joinRows(&left_row, left_width, nullptr, right_width);
+                return true;
+            }
+        }
+
+        if (type == JoinType::RIGHT || type == JoinType::FULL) {
+            while (unmatched < right_group.size()) {
+                size_t i = unmatched++;
+                if (!right_matched[i]) {
+                    row = joinRows(nullptr, left_width, &right_group[i], right_width);
+                    return true;
+                }
+            }
+        }
+
+        if (!nextGroups()) {
+            return false;
+        }
+        right_matched.assign(right_group.size(), false);
+        left_position = 0;
+        right_position = 0;
+        left_matched = false;
+        unmatched = 0;
+    }
+}
+
+void MergeJoinOperator::close() {
+    left.child->close();
+    right.child->close();
+    left.rows.clear();
+    right.rows.clear();
+    left_group.clear();
+    right_group.clear();
+}
+
+std::string MergeJoinOperator::describe() const {
+    std::string text = joinKind(type) + "Merge Join";
+    if (condition) {
+        text += " (" + condition->toString() + ")";
+    }
+    if (left.sort && right.sort) return text + ", sort both";
+    if (left.sort) return text + ", sort left";
+    if (right.sort) return text + ", sort right";
+    return text;
+}
+
+void MergeJoinOperator::forEachChild(const std::function<void(OperatorPtr&)>& visit) {
+    visit(left.child);
+    visit(right.child);
+}
+
+IndexNestedLoopJoinOperator::IndexNestedLoopJoinOperator(OperatorPtr outer, StorageManager* storage_manager,
+                                                         IndexManager* index_manager, const std::string& data_file,
+                                                         const std::string& index_file, const Schema& inner_schema,
+                                                         JoinType type, const Expression* condition, int outer_key,
+                                                         bool outer_left)
+    : Operator(outer_left ? outer->getSchema() : inner_schema), outer(std::move(outer)),
+      storage_manager(storage_manager), index_manager(index_manager), data_file(data_file),
+      index_file(index_file), type(type), condition(condition), outer_key(outer_key), outer_left(outer_left),
+      has_outer(false), outer_matched(false), match(0) {
+    const Schema& outer_schema = this->outer->getSchema();
+    outer_width = outer_schema.size();
+    inner_width = inner_schema.size();
+    const Schema& second = outer_left ? inner_schema : outer_schema;
+    schema.insert(schema.end(), second.begin(), second.end());
+}
+
+bool IndexNestedLoopJoinOperator::open() {
+    has_outer = false;
+    matches.clear();
+    match = 0;
+    return outer->open();
+}
+
+bool IndexNestedLoopJoinOperator::next(Record& row) {
+    while (true) {
+        while (match < matches.size()) {
+            const RID& rid = matches[match++];
+            Record inner;
+            if (!storage_manager->getRecord(data_file, rid, inner)) {
+                std::cerr << "Index entry points to a missing row at page " << rid.page_id << ", slot " << rid.slot
+                          << " of " << data_file << std::endl;
+                continue;
+            }
+            Record joined = outer_left ? joinRows(&outer_row, outer_width, &inner, inner_width)
+                                       : joinRows(&inner, inner_width, &outer_row, outer_width);
+            if (!condition || condition->isTrue(joined)) {
+                outer_matched = true;
+                row = std::move(joined);
+                return true;
+            }
+        }
+
+        if (has_outer) {
+            has_outer = false;
+            if (!outer_matched && preservesOuter()) {
+                row = outer_left ? joinRows(&outer_row, outer_width, nullptr, inner_width)
+                                 : joinRows(nullptr, inner_width, &outer_row, outer_width);
+                return true;
+            }
+        }
+
+        if (!outer->next(outer_row)) {
+            return false;
+        }
+        has_outer = true;
+        outer_matched = false;
+        matches.clear();
+        match = 0;
+        if (outer_key < static_cast<int>(outer_row.values.size()) && !outer_row.values[outer_key].isNull()) {
+            KeyRange range;
+            range.has_low = range.has_high = true;
+            range.low = range.high = {outer_row.values[outer_key]};
+            if (!index_manager->scanRange(index_file, range, matches)) {
+                matches.clear();
+            }
+        }
+    }
+}
+
+void IndexNestedLoopJoinOperator::close() {
+    outer->close();
+    matches.clear();
+}
+
+std::string IndexNestedLoopJoinOperator::describe() const {
+    std::string text = joinKind(type) + "Index Nested Loop Join";
+    if (condition) {
+        text += " (" + condition->toString() + ")";
+    }
+    return text + ", inner " + fileStem(data_file) + " using " + fileStem(index_file);
+}
+
+void Accumulator::add(const Value& value) {
+    if (value.isNull()) return;
+    count++;
+    if (value.isNumeric()) {
+        sum += value.asDouble();
+        numeric++;
+        all_int = all_int && value.getType() == ValueType::INT;
+    }
+    if (min.isNull() || value < min) min = value;
+    if (max.isNull() || value > max) max = value;
+}
+
+Value Accumulator::result(const std::string& function) const {
+    if (function == "COUNT") return Value(static_cast<int32_t>(count));
+    if (function == "MIN") return min;
+    if (function == "MAX") return max;
+    if (numeric == 0) return Value();
+    if (function == "AVG") return Value(sum / numeric);
+    // SUM of INT columns stays an INT while it fits
+    if (all_int && sum >= INT32_MIN && sum <= INT32_MAX) {
+        return Value(static_cast<int32_t>(sum));
+    }
+    return Value(sum);
+}
+
+AggregateOperator::AggregateOperator(OperatorPtr child, std::vector<const Expression*> group_by,
+                                     std::vector<const Expression*> aggregates, Schema schema)
+    : Operator(std::move(schema)), child(std::move(child)), group_by(std::move(group_by)),
+      aggregates(std::move(aggregates)) {}
+
+bool AggregateOperator::open() {
+    groups.clear();
+    if (!child->open()) {
+        return false;
+    }
+
+    Record row;
+    while (child->next(row)) {
+        std::vector<Value> key;
+        for (const Expression* expression : group_by) {
+            key.push_back(expression->evaluate(row));
+        }
+
+        std::vector<Accumulator>& accumulators = groups[key];
+        accumulators.resize(aggregates.size());
+        for (size_t i = 0; i < aggregates.size(); i++) {
+            if (aggregates[i]->children.empty()) {
+                accumulators[i].count++;  // COUNT(*)
+            } else {
+                accumulators[i].add(aggregates[i]->children[0]->evaluate(row));
+            }
+        }
+    }
+    child->close();
+
+    if (group_by.empty() && groups.empty()) {
+        groups[{}].resize(aggregates.size());
+    }
+    position = groups.begin();
+    return true;
+}
+
+bool AggregateOperator::next(Record& row) {
+    if (position == groups.end()) {
+        return false;
+    }
+    row.values = position->first;
+    for (size_t i = 0; i < aggregates.size(); i++) {
+        row.values.push_back(position->second[i].result(aggregates[i]->name));
+    }
+    ++position;
+    return true;
+}
+
+void AggregateOperator::close() {
+    groups.clear();
+    position = groups.begin();
+}
+
+std::string AggregateOperator::describe() const {
+    std::string text = "Aggregate (" + joinExpressions(aggregates) + ")";
+    if (!group_by.empty()) {
+        text += " group by (" + joinExpressions(group_by) + ")";
+    }
+    return text;
+}
+
+SortOperator::SortOperator(OperatorPtr child, std::vector<SortKey> keys)
+    : Operator(child->getSchema()), child(std::move(child)), keys(std::move(keys)), position(0) {}
+
+bool SortOperator::open() {
+    rows.clear();
+    position = 0;
+    if (!child->open()) {
+        return false;
+    }
+
+    Record row;
+    while (child->next(row)) {
+        rows.push_back(row);
+    }
+    child->close();
+
+    std::stable_sort(rows.begin(), rows.end(), [this](const Record& a, const Record& b) {
+        for (const SortKey& key : keys) {
+            int result = key.expression->evaluate(a).compare(key.expression->evaluate(b));
+            if (result != 0) {
+                return key.ascending ? result < 0 : result > 0;
+            }
+        }
+        return false;
+    });
+    return true;
+}
+
+bool SortOperator::next(Record& row) {
+    if (position >= rows.size()) {
+        return false;
+    }
+    row = std::move(rows[position++]);
+    return true;
+}
+
+void SortOperator::close() {
+    rows.clear();
+}
+
+std::string SortOperator::describe() const {
+    std::string text = "Sort (";
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i > 0) text += ", ";
+        text += keys[i].expression->toString() + (keys[i].ascending ? " ASC" : " DESC");
+    }
+    return text + ")";
+}
+
+TopNOperator::TopNOperator(OperatorPtr child, std::vector<SortKey> keys, size_t count)
+    : Operator(child->getSchema()), child(std::move(child)), keys(std::move(keys)), count(count), position(0) {}
+
+bool TopNOperator::before(const Entry& a, const Entry& b) const {
+    for (size_t i = 0; i < keys.size(); i++) {
+        int result = a.key[i].compare(b.key[i]);
+        if (result != 0) {
+            return keys[i].ascending ? result < 0 : result > 0;
+        }
+    }
+    return a.sequence < b.sequence;
+}
+
+bool TopNOperator::open() {
+    rows.clear();
+    position = 0;
+    if (count == 0) {
+        return true;  // Nothing to return, so nothing to read
+    }
+    if (!child->open()) {
+        return false;
+    }
+
+    auto heap_order = [this](const Entry& a, const Entry& b) { return before(a, b); };
+    Entry entry;
+    entry.sequence = 0;
+    while (child->next(entry.row)) {
+        entry.key.clear();
+        for (const SortKey& key : keys) {
+            entry.key.push_back(key.expression->evaluate(entry.row));
+        }
+        if (rows.size() < count) {
+            rows.push_back(entry);
+            std::push_heap(rows.begin(), rows.end(), heap_order);
+        } else if (before(entry, rows.front())) {
+            // Replaces the last of the rows kept so far
+            std::pop_heap(rows.begin(), rows.end(), heap_order);
+            rows.back() = entry;
+            std::push_heap(rows.begin(), rows.end(), heap_order);
+        }
+        entry.sequence++;
+    }
+    child->close();
+
+    std::sort_heap(rows.begin(), rows.end(), heap_order);
+    return true;
+}
+
+bool TopNOperator::next(Record& row) {
+    if (position >= rows.size()) {
+        return false;
+    }
+    row = std::move(rows[position++].row);
+    return true;
+}
+
+void TopNOperator::close() {
+    rows.clear();
+}
+
+std::string TopNOperator::describe() const {
+    std::string text = "Top-N Sort (";
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i > 0) text += ", ";
+        text += keys[i].expression->toString() + (keys[i].ascending ? " ASC" : " DESC");
+    }
+    return text + "), keep " + std::to_string(count);
+}
+
+LimitOperator::LimitOperator(OperatorPtr child, size_t limit, size_t offset)
+    : Operator(child->getSchema()), child(std::move(child)), limit(limit), offset(offset), produced(0) {}
+
+bool LimitOperator::open() {
+    produced = 0;
+    return child->open();
+}
+
+bool LimitOperator::next(Record& row) {
+    while (produced < offset + limit) {
+        if (!child->next(row)) {
+            return false;
+        }
+        if (produced++ >= offset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string LimitOperator::describe() const {
+    std::string text = "Limit (" + std::to_string(limit);
+    if (offset > 0) {
+        text += " offset " + std::to_string(offset);
+    }
+    return text + ")";
+}
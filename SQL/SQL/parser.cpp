@@ -0,0 +1,587 @@
+#include "parser.h"
+#include <cstdlib>
+#include <unordered_set>
+
+namespace {
+    bool isComparisonOperator(const std::string& op) {
+        return op == "=" || op == "!=" || op == "<>" || op == "<" ||
+               op == ">" || op == "<=" || op == ">=";
+    }
+
+    bool isAggregateFunction(const std::string& upper) {
+        return upper == "COUNT" || upper == "SUM" || upper == "AVG" ||
+               upper == "MIN" || upper == "MAX";
+    }
+
+    bool isColumnType(const std::string& upper) {
+        static const std::unordered_set<std::string> types = {
+            "INT", "INTEGER", "SMALLINT", "BIGINT", "DOUBLE", "FLOAT", "REAL",
+            "DECIMAL", "NUMERIC", "VARCHAR", "CHAR", "CHARACTER", "TEXT"
+        };
+        return types.count(upper) > 0;
+    }
+}
+
+Parser::Parser(const std::string& sql) : sql(sql), pos(0) {}
+
+bool Parser::isReserved(const std::string& upper) {
+    static const std::unordered_set<std::string> keywords = {
+        "SELECT", "FROM", "WHERE", "GROUP", "BY", "HAVING", "ORDER", "ASC", "DESC",
+        "JOIN", "INNER", "LEFT", "RIGHT", "FULL", "OUTER", "ON", "AND", "OR", "NOT", "AS",
+        "INSERT", "INTO", "VALUES", "UPDATE", "SET", "DELETE", "CREATE", "DROP",
+        "TABLE", "INDEX", "NULL", "LIMIT", "OFFSET", "BETWEEN"
+    };
+    return keywords.count(upper) > 0;
+}
+
+const Token& Parser::peek(size_t ahead) const {
+    size_t index = pos + ahead;
+    return index < tokens.size() ? tokens[index] : tokens.back();
+}
+
+const Token& Parser::advance() {
+    const Token& token = peek();
+    if (pos < tokens.size() - 1) {
+        pos++;
+    }
+    return token;
+}
+
+bool Parser::accept(TokenType type) {
+    if (peek().type == type) {
+        advance();
+        return true;
+    }
+    return false;
+}
+
+bool Parser::acceptKeyword(const char* keyword) {
+    if (peek().isKeyword(keyword)) {
+        advance();
+        return true;
+    }
+    return false;
+}
+
+bool Parser::expect(TokenType type, const char* what) {
+    return accept(type) || fail(what);
+}
+
+bool Parser::expectKeyword(const char* keyword) {
+    return acceptKeyword(keyword) || fail(keyword);
+}
+
+bool Parser::fail(const std::string& expected) {
+    if (error.empty()) {
+        const Token& token = peek();
+        std::string found = token.type == TokenType::END ? "end of input" : "'" + token.text + "'";
+        error = "Syntax error at position " + std::to_string(token.position) +
+                ": expected " + expected + ", found " + found;
+    }
+    return false;
+}
+
+bool Parser::parseIdentifier(std::string& name, const char* what) {
+    const Token& token = peek();
+    if (token.type != TokenType::IDENTIFIER || isReserved(token.upper)) {
+        return fail(what);
+    }
+    name = advance().text;
+    return true;
+}
+
+bool Parser::parseLiteral(Value& value) {
+    std::string sign;
+    if (peek().type == TokenType::OPERATOR && (peek().text == "-" || peek().text == "+")) {
+        sign = advance().text;
+        if (peek().type != TokenType::INTEGER && peek().type != TokenType::FLOAT) {
+            return fail("a number");
+        }
+    }
+
+    const Token& token = peek();
+    switch (token.type) {
+    case TokenType::INTEGER:
+    case TokenType::FLOAT:
+        value = Value::fromLiteral(sign + advance().text);
+        return true;
+    case TokenType::STRING:
+        value = Value(advance().text);
+        return true;
+    default:
+        if (acceptKeyword("NULL")) {
+            value = Value();
+            return true;
+        }
+        return fail("a value");
+    }
+}
+
+bool Parser::parse(std::vector<Statement>& statements) {
+    statements.clear();
+    error.clear();
+    pos = 0;
+
+    Lexer lexer(sql);
+    if (!lexer.tokenize(tokens, error)) {
+        return false;
+    }
+
+    while (true) {
+        while (accept(TokenType::SEMICOLON)) {}
+        if (peek().type == TokenType::END) {
+            break;
+        }
+
+        Statement statement;
+        if (!parseStatement(statement)) {
+            return false;
+        }
+        statements.push_back(std::move(statement));
+
+        if (!accept(TokenType::SEMICOLON) && peek().type != TokenType::END) {
+            return fail("end of statement");
+        }
+    }
+    return true;
+}
+
+bool Parser::parseStatement(Statement& statement) {
+    if (acceptKeyword("SELECT")) {
+        statement.type = StatementType::SELECT;
+        return parseSelect(statement.select);
+    }
+    if (acceptKeyword("INSERT")) {
+        statement.type = StatementType::INSERT;
+        return parseInsert(statement.insert);
+    }
+    if (acceptKeyword("UPDATE")) {
+        statement.type = StatementType::UPDATE;
+        return parseUpdate(statement.update);
+    }
+    if (acceptKeyword("DELETE")) {
+        statement.type = StatementType::DELETE;
+        return parseDelete(statement.remove);
+    }
+    if (acceptKeyword("CREATE")) {
+        return parseCreate(statement);
+    }
+    if (acceptKeyword("USE")) {
+        statement.type = StatementType::USE_DATABASE;
+        acceptKeyword("DATABASE");
+        return parseIdentifier(statement.name, "database name");
+    }
+    if (acceptKeyword("DROP")) {
+        if (acceptKeyword("TABLE")) {
+            statement.type = StatementType::DROP_TABLE;
+            return parseIdentifier(statement.name, "table name");
+        }
+        if (acceptKeyword("DATABASE")) {
+            statement.type = StatementType::DROP_DATABASE;
+            return parseIdentifier(statement.name, "database name");
+        }
+        return fail("TABLE or DATABASE");
+    }
+    if (acceptKeyword("EXPLAIN")) {
+        statement.type = StatementType::EXPLAIN;
+        statement.explain_analyze = acceptKeyword("ANALYZE");
+        return expectKeyword("SELECT") && parseSelect(statement.select);
+    }
+    if (acceptKeyword("ANALYZE")) {
+        statement.type = StatementType::ANALYZE;
+        acceptKeyword("TABLE");
+        return parseIdentifier(statement.name, "table name");
+    }
+    if (acceptKeyword("BEGIN")) {
+        statement.type = StatementType::BEGIN;
+        acceptKeyword("TRANSACTION");
+        return true;
+    }
+    if (acceptKeyword("COMMIT")) {
+        statement.type = StatementType::COMMIT;
+        acceptKeyword("TRANSACTION");
+        return true;
+    }
+    if (acceptKeyword("ROLLBACK")) {
+        statement.type = StatementType::ROLLBACK;
+        acceptKeyword("TRANSACTION");
+        return true;
+    }
+    if (acceptKeyword("HELP")) {
+        statement.type = StatementType::HELP;
+        return true;
+    }
+    if (acceptKeyword("EXIT") || acceptKeyword("QUIT")) {
+        statement.type = StatementType::EXIT;
+        return true;
+    }
+    return fail("a statement");
+}
+
+bool Parser::parseSelect(SelectStatement& select) {
+    // Select list
+    if (accept(TokenType::STAR)) {
+        SelectItem item;
+        item.expression = std::make_unique<Expression>();
+        item.expression->type = ExpressionType::STAR;
+        select.items.push_back(std::move(item));
+    } else {
+        do {
+            SelectItem item;
+            item.expression = parseExpression();
+            if (!item.expression) {
+                return false;
+            }
+            if (acceptKeyword("AS")) {
+                if (!parseIdentifier(item.alias, "alias")) return false;
+            } else if (peek().type == TokenType::IDENTIFIER && !isReserved(peek().upper)) {
+                item.alias = advance().text;
+            }
+            select.items.push_back(std::move(item));
+        } while (accept(TokenType::COMMA));
+    }
+
+    if (!expectKeyword("FROM") || !parseTableRef(select.from)) {
+        return false;
+    }
+
+    // [INNER | LEFT [OUTER] | RIGHT [OUTER] | FULL [OUTER]] JOIN table ON condition
+    while (true) {
+        JoinClause join;
+        if (acceptKeyword("JOIN")) {
+            join.type = JoinType::INNER;
+        } else if (acceptKeyword("INNER")) {
+            join.type = JoinType::INNER;
+            if (!expectKeyword("JOIN")) return false;
+        } else if (peek().isKeyword("LEFT") || peek().isKeyword("RIGHT") || peek().isKeyword("FULL")) {
+            std::string kind = advance().upper;
+            join.type = kind == "LEFT" ? JoinType::LEFT : kind == "RIGHT" ? JoinType::RIGHT : JoinType::FULL;
+            acceptKeyword("OUTER");
+            if (!expectKeyword("JOIN")) return false;
+        } else {
+            break;
+        }
+
+        if (!parseTableRef(join.table) || !expectKeyword("ON")) {
+            return false;
+        }
+        join.condition = parseExpression();
+        if (!join.condition) {
+            return false;
+        }
+        select.joins.push_back(std::move(join));
+    }
+
+    if (acceptKeyword("WHERE")) {
+        select.where = parseExpression();
+        if (!select.where) return false;
+    }
+
+    if (acceptKeyword("GROUP")) {
+        if (!expectKeyword("BY")) return false;
+        do {
+            ExpressionPtr expression = parseExpression();
+            if (!expression) return false;
+            select.group_by.push_back(std::move(expression));
+        } while (accept(TokenType::COMMA));
+    }
+
+    if (acceptKeyword("HAVING")) {
+        select.having = parseExpression();
+        if (!select.having) return false;
+    }
+
+    if (acceptKeyword("ORDER")) {
+        if (!expectKeyword("BY")) return false;
+        do {
+            OrderItem item;
+            item.expression = parseExpression();
+            if (!item.expression) return false;
+            if (acceptKeyword("DESC")) {
+                item.ascending = false;
+            } else {
+                acceptKeyword("ASC");
+            }
+            select.order_by.push_back(std::move(item));
+        } while (accept(TokenType::COMMA));
+    }
+
+    if (acceptKeyword("LIMIT")) {
+        if (peek().type != TokenType::INTEGER) return fail("a row count");
+        select.limit = std::strtoll(advance().text.c_str(), nullptr, 10);
+        if (acceptKeyword("OFFSET")) {
+            if (peek().type != TokenType::INTEGER) return fail("a row count");
+            select.offset = std::strtoll(advance().text.c_str(), nullptr, 10);
+        }
+    }
+    return true;
+}
+
+bool Parser::parseTableRef(TableRef& table) {
+    if (!parseIdentifier(table.name, "table name")) {
+        return false;
+    }
+    if (acceptKeyword("AS")) {
+        return parseIdentifier(table.alias, "alias");
+    }
+    if (peek().type == TokenType::IDENTIFIER && !isReserved(peek().upper)) {
+        table.alias = advance().text;
+    }
+    return true;
+}
+
+bool Parser::parseInsert(InsertStatement& insert) {
+    if (!expectKeyword("INTO") || !parseIdentifier(insert.table, "table name") ||
+        !expectKeyword("VALUES")) {
+        return false;
+    }
+
+    // One or more parenthesised rows
+    do {
+        if (!expect(TokenType::LPAREN, "'('")) return false;
+        std::vector<Value> row;
+        do {
+            Value value;
+            if (!parseLiteral(value)) return false;
+            row.push_back(value);
+        } while (accept(TokenType::COMMA));
+        if (!expect(TokenType::RPAREN, "')'")) return false;
+        insert.rows.push_back(row);
+    } while (accept(TokenType::COMMA));
+    return true;
+}
+
+bool Parser::parseUpdate(UpdateStatement& update) {
+    if (!parseIdentifier(update.table, "table name") || !expectKeyword("SET")) {
+        return false;
+    }
+
+    do {
+        Assignment assignment;
+        if (!parseIdentifier(assignment.column, "column name")) return false;
+        if (peek().type != TokenType::OPERATOR || peek().text != "=") return fail("'='");
+        advance();
+        if (!parseLiteral(assignment.value)) return false;
+        update.assignments.push_back(assignment);
+    } while (accept(TokenType::COMMA));
+
+    if (acceptKeyword("WHERE")) {
+        update.where = parseExpression();
+        if (!update.where) return false;
+    }
+    return true;
+}
+
+bool Parser::parseDelete(DeleteStatement& remove) {
+    if (!expectKeyword("FROM") || !parseIdentifier(remove.table, "table name")) {
+        return false;
+    }
+    if (acceptKeyword("WHERE")) {
+        remove.where = parseExpression();
+        if (!remove.where) return false;
+    }
+    return true;
+}
+
+bool Parser::parseCreate(Statement& statement) {
+    if (acceptKeyword("DATABASE")) {
+        statement.type = StatementType::CREATE_DATABASE;
+        return parseIdentifier(statement.name, "database name");
+    }
+
+    if (acceptKeyword("TABLE")) {
+        statement.type = StatementType::CREATE_TABLE;
+        CreateTableStatement& create = statement.create_table;
+        if (!parseIdentifier(create.table, "table name") || !expect(TokenType::LPAREN, "'('")) {
+            return false;
+        }
+        do {
+            ColumnInfo column;
+            if (!parseColumnDefinition(column)) return false;
+            create.columns.push_back(column);
+        } while (accept(TokenType::COMMA));
+        statement.name = create.table;
+        return expect(TokenType::RPAREN, "')'");
+    }
+
+    if (acceptKeyword("INDEX")) {
+        // CREATE INDEX ON table (column [, column ...]) [USING {BTREE | HASH}]
+        //     [INCLUDE (column [, column ...])]
+        statement.type = StatementType::CREATE_INDEX;
+        CreateIndexStatement& create = statement.create_index;
+        if (!expectKeyword("ON") || !parseIdentifier(create.table, "table name") ||
+            !parseColumnList(create.columns)) {
+            return false;
+        }
+        if (acceptKeyword("USING")) {
+            if (acceptKeyword("HASH")) {
+                create.hash = true;
+            } else if (!acceptKeyword("BTREE")) {
+                return fail("BTREE or HASH");
+            }
+        }
+        return !acceptKeyword("INCLUDE") || parseColumnList(create.included);
+    }
+    return fail("DATABASE, TABLE or INDEX");
+}
+
+bool Parser::parseColumnList(std::vector<std::string>& columns) {
+    if (!expect(TokenType::LPAREN, "'('")) {
+        return false;
+    }
+    do {
+        std::string column;
+        if (!parseIdentifier(column, "column name")) return false;
+        columns.push_back(column);
+    } while (accept(TokenType::COMMA));
+    return expect(TokenType::RPAREN, "')'");
+}
+
+bool Parser::parseColumnDefinition(ColumnInfo& column) {
+    std::string type;
+    if (!parseIdentifier(column.name, "column name") || !parseIdentifier(type, "column type")) {
+        return false;
+    }
+
+    column.type = tokens[pos - 1].upper;
+    if (!isColumnType(column.type)) {
+        pos--;
+        return fail("a column type");
+    }
+
+    // VARCHAR(n), CHAR(n), DECIMAL(p, s)
+    if (accept(TokenType::LPAREN)) {
+        if (peek().type != TokenType::INTEGER) return fail("a length");
+        column.size = std::stoi(advance().text);
+        if (accept(TokenType::COMMA) && !expect(TokenType::INTEGER, "a scale")) return false;
+        if (!expect(TokenType::RPAREN, "')'")) return false;
+    } else if (Value::typeFromName(column.type) == ValueType::INT) {
+        column.size = sizeof(int);
+    } else if (Value::typeFromName(column.type) == ValueType::DOUBLE) {
+        column.size = sizeof(double);
+    }
+
+    // Constraints
+    while (true) {
+        if (acceptKeyword("PRIMARY")) {
+            if (!expectKeyword("KEY")) return false;
+            column.is_primary_key = true;
+        } else if (acceptKeyword("FOREIGN")) {
+            if (!expectKeyword("KEY")) return false;
+        } else if (acceptKeyword("REFERENCES")) {
+            column.is_foreign_key = true;
+            if (!parseIdentifier(column.references_table, "table name") ||
+                !expect(TokenType::LPAREN, "'('") ||
+                !parseIdentifier(column.references_column, "column name") ||
+                !expect(TokenType::RPAREN, "')'")) {
+                return false;
+            }
+        } else {
+            return true;
+        }
+    }
+}
+
+ExpressionPtr Parser::parseExpression() {
+    return parseOr();
+}
+
+ExpressionPtr Parser::parseOr() {
+    ExpressionPtr left = parseAnd();
+    while (left && acceptKeyword("OR")) {
+        ExpressionPtr right = parseAnd();
+        if (!right) return nullptr;
+        left = Expression::makeLogical(ExpressionType::OR, std::move(left), std::move(right));
+    }
+    return left;
+}
+
+ExpressionPtr Parser::parseAnd() {
+    ExpressionPtr left = parseNot();
+    while (left && acceptKeyword("AND")) {
+        ExpressionPtr right = parseNot();
+        if (!right) return nullptr;
+        left = Expression::makeLogical(ExpressionType::AND, std::move(left), std::move(right));
+    }
+    return left;
+}
+
+ExpressionPtr Parser::parseNot() {
+    if (acceptKeyword("NOT")) {
+        ExpressionPtr child = parseNot();
+        return child ? Expression::makeNot(std::move(child)) : nullptr;
+    }
+    return parseComparison();
+}
+
+ExpressionPtr Parser::parseComparison() {
+    ExpressionPtr left = parseOperand();
+    if (!left) {
+        return nullptr;
+    }
+    if (peek().type == TokenType::OPERATOR && isComparisonOperator(peek().text)) {
+        std::string op = advance().text;
+        ExpressionPtr right = parseOperand();
+        if (!right) return nullptr;
+        return Expression::makeComparison(op, std::move(left), std::move(right));
+    }
+
+    // x [NOT] BETWEEN a AND b is rewritten to [NOT] (x >= a AND x <= b), so
+    // filters, index ranges and estimates need no separate case for it
+    bool negated = peek().isKeyword("NOT") && peek(1).isKeyword("BETWEEN");
+    if (negated) advance();
+    if (acceptKeyword("BETWEEN")) {
+        ExpressionPtr low = parseOperand();
+        if (!low || !expectKeyword("AND")) return nullptr;
+        ExpressionPtr high = parseOperand();
+        if (!high) return nullptr;
+        ExpressionPtr copy = left->clone();
+        ExpressionPtr range = Expression::makeLogical(
+            ExpressionType::AND, Expression::makeComparison(">=", std::move(left), std::move(low)),
+            Expression::makeComparison("<=", std::move(copy), std::move(high)));
+        return negated ? Expression::makeNot(std::move(range)) : std::move(range);
+    }
+    return left;
+}
+
+ExpressionPtr Parser::parseOperand() {
+    const Token& token = peek();
+
+    if (accept(TokenType::LPAREN)) {
+        ExpressionPtr expression = parseExpression();
+        if (!expression || !expect(TokenType::RPAREN, "')'")) return nullptr;
+        return expression;
+    }
+
+    if (token.type == TokenType::INTEGER || token.type == TokenType::FLOAT ||
+        token.type == TokenType::STRING || token.type == TokenType::OPERATOR ||
+        token.isKeyword("NULL")) {
+        Value value;
+        if (!parseLiteral(value)) return nullptr;
+        return Expression::makeLiteral(value);
+    }
+
+    if (token.type == TokenType::IDENTIFIER && isAggregateFunction(token.upper) &&
+        peek(1).type == TokenType::LPAREN) {
+        std::string function = advance().upper;
+        advance();
+        ExpressionPtr argument;
+        if (function != "COUNT" || !accept(TokenType::STAR)) {
+            argument = parseExpression();
+            if (!argument) return nullptr;
+        }
+        if (!expect(TokenType::RPAREN, "')'")) return nullptr;
+        return Expression::makeAggregate(function, std::move(argument));
+    }
+
+    std::string name;
+    if (!parseIdentifier(name, "an expression")) {
+        return nullptr;
+    }
+    if (accept(TokenType::DOT)) {
+        std::string column;
+        if (!parseIdentifier(column, "column name")) return nullptr;
+        return Expression::makeColumn(name, column);
+    }
+    return Expression::makeColumn("", name);
+}
@@ -0,0 +1,976 @@
+#include "planner.h"
+#include "vectorized.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Bounds on a single column, kept as one-value keys
+    void tightenLow(KeyRange& range, const Value& value, bool inclusive) {
+        if (!range.has_low || value > range.low[0] || (value == range.low[0] && !inclusive)) {
+            range.has_low = true;
+            range.low = {value};
+            range.low_inclusive = inclusive;
+        }
+    }
+
+    void tightenHigh(KeyRange& range, const Value& value, bool inclusive) {
+        if (!range.has_high || value < range.high[0] || (value == range.high[0] && !inclusive)) {
+            range.has_high = true;
+            range.high = {value};
+            range.high_inclusive = inclusive;
+        }
+    }
+
+    // Narrows range by the "column <op> literal" conjuncts of a bound WHERE
+    // clause on the indexed column col_index (BETWEEN arrives as a pair of
+    // them), so the rows can be located through its index instead of a
+    // scan. Literals are cast to the column's type, as the stored keys
+    // were; one that does not fit leaves its conjunct to the Filter. used
+    // collects the conjuncts that narrowed the range, and exact those of
+    // them whose literal kept its value in the cast, which the range then
+    // enforces alone.
+    void findKeyRange(const ColumnInfo& col, int col_index, const Expression* where, KeyRange& range,
+                      std::vector<const Expression*>& used, std::vector<const Expression*>& exact) {
+        if (!where) return;
+        if (where->type == ExpressionType::AND) {
+            findKeyRange(col, col_index, where->children[0].get(), range, used, exact);
+            findKeyRange(col, col_index, where->children[1].get(), range, used, exact);
+            return;
+        }
+        if (where->type != ExpressionType::COMPARISON) return;
+
+        const Expression* column = where->children[0].get();
+        const Expression* literal = where->children[1].get();
+        std::string op = where->op;
+        if (column->type != ExpressionType::COLUMN) {
+            std::swap(column, literal);
+            if (op == "<") op = ">";
+            else if (op == ">") op = "<";
+            else if (op == "<=") op = ">=";
+            else if (op == ">=") op = "<=";
+        }
+        if (column->type != ExpressionType::COLUMN || column->column_index != col_index ||
+            literal->type != ExpressionType::LITERAL || literal->value.isNull()) {
+            return;
+        }
+
+        int max_length = 0;
+        ValueType type = Value::typeFromName(col.type, &max_length);
+        if (max_length == 0 && (type == ValueType::VARCHAR || type == ValueType::CHAR)) {
+            max_length = col.size;
+        }
+        Value value;
+        if (!literal->value.castTo(type, max_length, value)) {
+            return;
+        }
+
+        if (op == "=") {
+            tightenLow(range, value, true);
+            tightenHigh(range, value, true);
+        } else if (op == ">" || op == ">=") {
+            tightenLow(range, value, op == ">=");
+        } else if (op == "<" || op == "<=") {
+            tightenHigh(range, value, op == "<=");
+        } else {
+            return;
+        }
+        used.push_back(where);
+        if (value.compare(literal->value) == 0) exact.push_back(where);
+    }
+
+    int columnPosition(const TableInfo* table, const std::string& name) {
+        for (size_t i = 0; i < table->columns.size(); i++) {
+            if (table->columns[i].name == name) return i;
+        }
+        return -1;
+    }
+
+    // Marks the table columns expression reads; * reads them all
+    void markColumns(const Expression* expression, const TableInfo* table, std::vector<bool>& needed) {
+        if (!expression) return;
+        if (expression->type == ExpressionType::STAR) {
+            needed.assign(needed.size(), true);
+            return;
+        }
+        if (expression->type == ExpressionType::COLUMN) {
+            int column = columnPosition(table, expression->name);
+            if (column >= 0) needed[column] = true;
+        }
+        for (const auto& child : expression->children) {
+            markColumns(child.get(), table, needed);
+        }
+    }
+
+    // Columns of table a single-table query reads anywhere
+    std::vector<bool> referencedColumns(const SelectStatement& query, const TableInfo* table) {
+        std::vector<bool> needed(table->columns.size(), false);
+        for (const auto& item : query.items) markColumns(item.expression.get(), table, needed);
+        markColumns(query.where.get(), table, needed);
+        for (const auto& expression : query.group_by) markColumns(expression.get(), table, needed);
+        markColumns(query.having.get(), table, needed);
+        for (const auto& item : query.order_by) markColumns(item.expression.get(), table, needed);
+        return needed;
+    }
+
+    // A single-column index on column; ordered asks for a B+ tree, which
+    // returns the rows in key order. Composite indexes leave out rows with
+    // a NULL in any of their columns, so they cannot stand in for one.
+    const IndexInfo* columnIndex(const TableInfo* table, int column, bool ordered) {
+        const IndexInfo* found = nullptr;
+        for (const IndexInfo& index : table->indexes) {
+            if (index.columns.size() != 1 || index.columns[0] != table->columns[column].name ||
+                (ordered && index.hash)) {
+                continue;
+            }
+            if (!found || (index.hash && !found->hash)) found = &index;
+        }
+        return found;
+    }
+
+    enum class JoinMethod { NESTED_LOOP, HASH, MERGE, INDEX_NESTED_LOOP };
+
+    // The operands of the ANDs at the top of condition
+    void splitConjuncts(const Expression* condition, std::vector<const Expression*>& conjuncts) {
+        if (condition->type == ExpressionType::AND) {
+            splitConjuncts(condition->children[0].get(), conjuncts);
+            splitConjuncts(condition->children[1].get(), conjuncts);
+            return;
+        }
+        conjuncts.push_back(condition);
+    }
+
+    // Bit i is set when expression reads a column of the table schemas[i]
+    uint32_t referencedTables(const Expression* expression, const std::vector<Schema>& schemas) {
+        uint32_t mask = 0;
+        if (expression->type == ExpressionType::COLUMN) {
+            for (size_t i = 0; i < schemas.size(); i++) {
+                for (const SchemaColumn& column : schemas[i]) {
+                    if (column.name == expression->name && (expression->table.empty() || column.table == expression->table)) {
+                        mask |= 1u << i;
+                    }
+                }
+            }
+            return mask;
+        }
+        for (const auto& child : expression->children) {
+            mask |= referencedTables(child.get(), schemas);
+        }
+        return mask;
+    }
+
+    // Marks, per table, the columns expression may read; an unqualified
+    // name marks it in every table that has it, and * marks them all
+    void markTableColumns(const Expression* expression, const std::vector<Schema>& schemas,
+                          std::vector<std::vector<bool>>& needed) {
+        if (!expression) return;
+        if (expression->type == ExpressionType::STAR) {
+            for (std::vector<bool>& columns : needed) columns.assign(columns.size(), true);
+            return;
+        }
+        if (expression->type == ExpressionType::COLUMN) {
+            for (size_t i = 0; i < schemas.size(); i++) {
+                for (size_t c = 0; c < schemas[i].size(); c++) {
+                    const SchemaColumn& column = schemas[i][c];
+                    if (column.name == expression->name && (expression->table.empty() || column.table == expression->table)) {
+                        needed[i][c] = true;
+                    }
+                }
+            }
+        }
+        for (const auto& child : expression->children) {
+            markTableColumns(child.get(), schemas, needed);
+        }
+    }
+
+    // Fraction of the cross product of the tables in mask that conjunct keeps
+    double conjunctSelectivity(const Expression* conjunct, uint32_t mask, const std::vector<Schema>& schemas,
+                               const std::vector<TableStats>& stats) {
+        Schema schema;
+        TableStats product;
+        bool empty = true;
+        for (size_t i = 0; i < schemas.size(); i++) {
+            if (!(mask & (1u << i))) continue;
+            schema.insert(schema.end(), schemas[i].begin(), schemas[i].end());
+            product = empty ? stats[i] : joinStats(product, stats[i]);
+            empty = false;
+        }
+        ExpressionPtr bound = conjunct->clone();
+        std::string error;
+        if (empty || !bound->bind(schema, error)) {
+            return 1;  // Binding errors are reported once the join binds it
+        }
+        return Selectivity::estimate(product, bound.get());
+    }
+
+    // Left-deep join order whose joins produce the fewest rows in total,
+    // by dynamic programming over the subsets of tables. A subset's size is
+    // the product of its tables' rows and the selectivities of the
+    // conditions within it. Ties keep the written order.
+    std::vector<size_t> chooseJoinOrder(const std::vector<double>& rows, const std::vector<uint32_t>& masks,
+                                        const std::vector<double>& selectivities) {
+        size_t n = rows.size();
+        uint32_t all = (1u << n) - 1;
+        std::vector<double> size(all + 1, 1);
+        std::vector<double> cost(all + 1, std::numeric_limits<double>::infinity());
+        std::vector<int> last(all + 1, -1);
+        for (uint32_t set = 1; set <= all; set++) {
+            for (size_t i = 0; i < n; i++) {
+                if (set & (1u << i)) size[set] *= rows[i];
+            }
+            for (size_t c = 0; c < masks.size(); c++) {
+                if (masks[c] != 0 && (masks[c] & ~set) == 0) size[set] *= selectivities[c];
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            cost[1u << i] = 0;
+            last[1u << i] = static_cast<int>(i);
+        }
+        for (uint32_t set = 1; set < all; set++) {
+            if (last[set] < 0) continue;
+            for (size_t t = 0; t < n; t++) {
+                uint32_t next = set | (1u << t);
+                if (next == set) continue;
+                double total = cost[set] + size[next];
+                if (total < cost[next]) {
+                    cost[next] = total;
+                    last[next] = static_cast<int>(t);
+                }
+            }
+        }
+
+        std::vector<size_t> order;
+        for (uint32_t set = all; set != 0; set &= ~(1u << last[set])) {
+            order.push_back(static_cast<size_t>(last[set]));
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // ON a = b with a from the left input and b from the right one (or the
+    // other way round) can be answered with a hash, merge or index join
+    bool findJoinKeys(const Expression* condition, int left_width, int& left_key, int& right_key) {
+        // Any equality ANDed into the condition will do; the join operators
+        // still check the whole condition on every pair
+        if (condition->type == ExpressionType::AND) {
+            return findJoinKeys(condition->children[0].get(), left_width, left_key, right_key) ||
+                   findJoinKeys(condition->children[1].get(), left_width, left_key, right_key);
+        }
+        if (condition->type != ExpressionType::COMPARISON || condition->op != "=" ||
+            condition->children[0]->type != ExpressionType::COLUMN ||
+            condition->children[1]->type != ExpressionType::COLUMN) {
+            return false;
+        }
+        int a = condition->children[0]->column_index;
+        int b = condition->children[1]->column_index;
+        if (a < left_width && b >= left_width) {
+            left_key = a;
+            right_key = b - left_width;
+            return true;
+        }
+        if (b < left_width && a >= left_width) {
+            left_key = b;
+            right_key = a - left_width;
+            return true;
+        }
+        return false;
+    }
+
+    // Estimate of an operator that passes on fraction of its input's rows
+    double scaled(double rows, double fraction) {
+        return rows < 0 ? rows : rows * fraction;
+    }
+}
+
+Planner::Planner(CatalogManager* catalog_manager, StorageManager* storage_manager,
+                 IndexManager* index_manager, const std::string& db_name)
+    : catalog_manager(catalog_manager), storage_manager(storage_manager),
+      index_manager(index_manager), db_name(db_name) {}
+
+Schema Planner::tableSchema(const TableInfo* table, const std::string& qualifier) {
+    Schema schema;
+    for (const auto& col : table->columns) {
+        schema.push_back({qualifier, col.name, ""});
+    }
+    return schema;
+}
+
+std::string Planner::getTablePath(const std::string& table_name) const {
+    return "./data/" + db_name + "/" + table_name + ".dat";
+}
+
+bool Planner::chooseIndexPath(const TableInfo* table, const Expression* where, IndexPath& path,
+                              const std::vector<bool>* needed_columns) const {
+    const TableStats& stats = table->stats;
+    for (const IndexInfo& index : table->indexes) {
+        IndexPath candidate;
+        candidate.index = &index;
+        for (const auto& name : index.columns) {
+            candidate.columns.push_back(columnPosition(table, name));
+        }
+        for (const auto& name : index.included) {
+            candidate.included_columns.push_back(columnPosition(table, name));
+        }
+        if (std::find(candidate.columns.begin(), candidate.columns.end(), -1) != candidate.columns.end() ||
+            std::find(candidate.included_columns.begin(), candidate.included_columns.end(), -1) !=
+                candidate.included_columns.end()) {
+            continue;
+        }
+
+        // Equalities fix the leading columns of the key; the first column
+        // without one may still be bounded, and ends the usable prefix
+        std::vector<const Expression*> used;
+        KeyRange& range = candidate.range;
+        for (int column : candidate.columns) {
+            KeyRange bounds;
+            size_t found = used.size();
+            findKeyRange(table->columns[column], column, where, bounds, used, candidate.enforced);
+            if (used.size() == found) break;
+
+            if (bounds.has_low && bounds.has_high && bounds.low_inclusive && bounds.high_inclusive &&
+                bounds.low[0] == bounds.high[0]) {
+                range.low.push_back(bounds.low[0]);
+                range.high.push_back(bounds.low[0]);
+                candidate.equal_columns++;
+                continue;
+            }
+            if (bounds.has_low) {
+                range.low.push_back(bounds.low[0]);
+                range.low_inclusive = bounds.low_inclusive;
+            }
+            if (bounds.has_high) {
+                range.high.push_back(bounds.high[0]);
+                range.high_inclusive = bounds.high_inclusive;
+            }
+            break;
+        }
+        // A hash index only finds whole keys
+        if (used.empty() || (index.hash && candidate.equal_columns < candidate.columns.size())) continue;
+        range.has_low = !range.low.empty();
+        range.has_high = !range.high.empty();
+
+        if (needed_columns) {
+            candidate.covering = true;
+            for (size_t c = 0; c < needed_columns->size(); c++) {
+                if ((*needed_columns)[c] &&
+                    std::find(candidate.columns.begin(), candidate.columns.end(), c) == candidate.columns.end() &&
+                    std::find(candidate.included_columns.begin(), candidate.included_columns.end(), c) ==
+                        candidate.included_columns.end()) {
+                    candidate.covering = false;
+                }
+            }
+        }
+
+        // Among the usable indexes take the cheapest, or without
+        // statistics the one bounding the key tightest; a covering index
+        // wins a tie
+        if (stats.analyzed) {
+            candidate.rows = stats.row_count * Selectivity::estimateAll(stats, used);
+            if (index.hash) {
+                candidate.index_cost = candidate.covering ? Cost::hashOnlyLookup(candidate.rows)
+                                                          : Cost::hashLookup(candidate.rows);
+            } else {
+                candidate.index_cost = candidate.covering ? Cost::indexOnlyScan(stats, candidate.rows)
+                                                          : Cost::indexLookup(stats, candidate.rows);
+            }
+        }
+        bool better = !path.index;
+        if (!better && candidate.index_cost != path.index_cost) {
+            better = candidate.index_cost < path.index_cost;
+        } else if (!better && candidate.score() != path.score()) {
+            better = candidate.score() > path.score();
+        } else if (!better) {
+            better = candidate.covering && !path.covering;
+        }
+        if (better) {
+            path = candidate;
+        }
+    }
+    if (!path.index) {
+        return false;
+    }
+
+    // With statistics the index must also beat reading the whole table,
+    // which it does not for a table of a page or two or a wide range
+    if (!stats.analyzed) {
+        return true;
+    }
+    path.scan_cost = Cost::tableScan(stats);
+    return path.index_cost < path.scan_cost;
+}
+
+bool Planner::planScan(TableInfo* table, const std::string& qualifier, Expression* where,
+                       OperatorPtr& root, std::string& error, const std::vector<bool>* needed_columns) {
+    Schema schema = tableSchema(table, qualifier);
+    if (where && !where->bind(schema, error)) {
+        return false;
+    }
+
+    std::string data_file = getTablePath(table->name);
+    IndexPath path;
+    bool use_index = chooseIndexPath(table, where, path, needed_columns);
+    if (use_index) {
+        std::string index_file = catalog_manager->getIndexPath(*path.index);
+        if (path.covering) {
+            root = std::make_unique<IndexOnlyScanOperator>(index_manager, data_file, index_file, path.range,
+                                                           path.columns, path.included_columns, schema);
+        } else if (path.isPoint()) {
+            root = std::make_unique<IndexLookupOperator>(storage_manager, index_manager, data_file,
+                                                         index_file, path.range.low, schema);
+        } else {
+            root = std::make_unique<IndexRangeScanOperator>(storage_manager, index_manager, data_file,
+                                                            index_file, path.range, path.columns, schema);
+        }
+    } else {
+        // The scan tests WHERE itself and decodes only the needed columns
+        root = std::make_unique<SeqScanOperator>(storage_manager, data_file, schema,
+                                                 needed_columns ? *needed_columns : std::vector<bool>(), where);
+    }
+
+    const TableStats& stats = table->stats;
+    if (stats.analyzed) {
+        root->setEstimatedRows(use_index ? path.rows : stats.row_count);
+    }
+    if (where) {
+        // The range already holds the rows to the conjuncts it enforces
+        if (use_index) {
+            std::vector<const Expression*> residual;
+            splitConjuncts(where, residual);
+            residual.erase(std::remove_if(residual.begin(), residual.end(),
+                                          [&](const Expression* conjunct) {
+                                              return std::find(path.enforced.begin(), path.enforced.end(),
+                                                               conjunct) != path.enforced.end();
+                                          }),
+                           residual.end());
+            if (!residual.empty()) root = std::make_unique<FilterOperator>(std::move(root), std::move(residual));
+        }
+        if (stats.analyzed) root->setEstimatedRows(Selectivity::estimateRows(stats, where));
+    }
+    return true;
+}
+
+Planner::JoinInput Planner::scanInput(TableInfo* table, const Schema& schema, const std::vector<bool>& columns,
+                                      const Expression* filter) {
+    JoinInput input;
+    input.root = std::make_unique<SeqScanOperator>(storage_manager, getTablePath(table->name), schema, columns,
+                                                   filter);
+    input.table = table;
+    input.filter = filter;
+    input.stats = table->stats;
+    input.pages = storage_manager->getNumPages(getTablePath(table->name));
+    if (input.stats.analyzed) {
+        double rows = filter ? Selectivity::estimateRows(table->stats, filter) : table->stats.row_count;
+        input.root->setEstimatedRows(rows);
+        if (filter) {
+            input.pages = table->stats.row_count > 0 ? input.pages * rows / table->stats.row_count : 0;
+            input.stats = scaleStats(table->stats, rows);
+        }
+    }
+    return input;
+}
+
+// Joins are planned left-deep: each one joins the rows of the tables
+// before it with the scan of one more table. Outer joins keep the written
+// order. A query of only inner joins over analyzed tables may be run in
+// any order, so its ON conditions are pooled, split at their ANDs, and
+// the order with the smallest intermediate results is chosen; each
+// condition then applies at the first join that has all its tables.
+// Each scan decodes only the columns the query reads, and tests the WHERE
+// conjuncts on its table alone unless an outer join pads the table with
+// NULLs, which those conjuncts must still see.
+bool Planner::planJoin(SelectStatement& query, OperatorPtr& root, TableStats& stats, std::string& error) {
+    std::vector<TableInfo*> tables;
+    std::vector<Schema> schemas;  // of each table, for the columns conditions read
+    bool all_inner = true;
+    bool analyzed = true;
+    for (size_t i = 0; i <= query.joins.size(); i++) {
+        const TableRef& ref = i == 0 ? query.from : query.joins[i - 1].table;
+        TableInfo* table = catalog_manager->getTableInfo(ref.name);
+        if (!table) {
+            error = "Table not found: " + ref.name;
+            return false;
+        }
+        tables.push_back(table);
+        schemas.push_back(tableSchema(table, ref.qualifier()));
+        analyzed = analyzed && table->stats.analyzed;
+        if (i > 0) all_inner = all_inner && query.joins[i - 1].type == JoinType::INNER;
+    }
+    // Joined rows are the columns of the tables in written order
+    Schema schema;
+    for (const Schema& table_schema : schemas) {
+        schema.insert(schema.end(), table_schema.begin(), table_schema.end());
+    }
+    if (query.where && !query.where->bind(schema, error)) {
+        return false;
+    }
+
+    std::vector<std::vector<bool>> needed;
+    for (const Schema& table_schema : schemas) {
+        needed.emplace_back(table_schema.size(), false);
+    }
+    for (const auto& item : query.items) markTableColumns(item.expression.get(), schemas, needed);
+    for (const auto& join : query.joins) markTableColumns(join.condition.get(), schemas, needed);
+    markTableColumns(query.where.get(), schemas, needed);
+    for (const auto& expression : query.group_by) markTableColumns(expression.get(), schemas, needed);
+    markTableColumns(query.having.get(), schemas, needed);
+    for (const auto& item : query.order_by) markTableColumns(item.expression.get(), schemas, needed);
+
+    // A table is padded with NULLs by a LEFT or FULL join that adds it, or
+    // by a RIGHT or FULL join after it, as every join's left input holds
+    // all the tables before it
+    std::vector<bool> padded(tables.size(), false);
+    for (size_t i = 1; i < tables.size(); i++) {
+        JoinType type = query.joins[i - 1].type;
+        if (type == JoinType::LEFT || type == JoinType::FULL) padded[i] = true;
+        if (type == JoinType::RIGHT || type == JoinType::FULL) {
+            for (size_t j = 0; j < i; j++) padded[j] = true;
+        }
+    }
+    std::vector<ExpressionPtr> pushed(tables.size());  // AND of the conjuncts each scan tests
+    ExpressionPtr remainder;  // the rest of WHERE, tested on the joined rows
+    std::vector<const Expression*> where_conjuncts;
+    if (query.where) splitConjuncts(query.where.get(), where_conjuncts);
+    for (const Expression* conjunct : where_conjuncts) {
+        uint32_t mask = tables.size() <= 32 ? referencedTables(conjunct, schemas) : 0;
+        size_t table = mask ? 0 : tables.size();
+        while (table < tables.size() && mask != 1u << table) table++;
+        ExpressionPtr& target = table < tables.size() && !padded[table] ? pushed[table] : remainder;
+        target = target ? Expression::makeLogical(ExpressionType::AND, std::move(target), conjunct->clone())
+                        : conjunct->clone();
+    }
+
+    std::vector<JoinInput> inputs;
+    for (size_t i = 0; i < tables.size(); i++) {
+        Expression* filter = pushed[i].get();
+        if (filter) {
+            if (!filter->bind(schemas[i], error)) return false;
+            query.planned.push_back(std::move(pushed[i]));
+        }
+        inputs.push_back(scanInput(tables[i], schemas[i], needed[i], filter));
+    }
+
+    if (!all_inner || !analyzed || query.joins.size() < 2 || inputs.size() > MAX_REORDERED_TABLES) {
+        for (size_t i = 1; i < inputs.size(); i++) {
+            JoinClause& join = query.joins[i - 1];
+            if (!planJoinStep(inputs[0], inputs[i], join.type, join.condition.get(), i, error)) {
+                return false;
+            }
+        }
+        root = std::move(inputs[0].root);
+        stats = inputs[0].stats;
+    } else {
+        std::vector<TableStats> table_stats;
+        for (const JoinInput& input : inputs) {
+            table_stats.push_back(input.stats);
+        }
+        std::vector<const Expression*> conjuncts;
+        for (const JoinClause& join : query.joins) {
+            splitConjuncts(join.condition.get(), conjuncts);
+        }
+        std::vector<uint32_t> masks;
+        std::vector<double> selectivities;
+        for (const Expression* conjunct : conjuncts) {
+            masks.push_back(referencedTables(conjunct, schemas));
+            selectivities.push_back(conjunctSelectivity(conjunct, masks.back(), schemas, table_stats));
+        }
+        std::vector<double> rows;
+        for (const TableStats& table : table_stats) {
+            rows.push_back(static_cast<double>(table.row_count));
+        }
+        std::vector<size_t> order = chooseJoinOrder(rows, masks, selectivities);
+
+        // Where each table's columns start in the joined rows
+        std::vector<size_t> offsets(inputs.size());
+        std::vector<bool> used(conjuncts.size(), false);
+        uint32_t joined = 1u << order[0];
+        size_t width = schemas[order[0]].size();
+        JoinInput result = std::move(inputs[order[0]]);
+        for (size_t step = 1; step < order.size(); step++) {
+            size_t next = order[step];
+            offsets[next] = width;
+            width += schemas[next].size();
+            joined |= 1u << next;
+
+            // AND of the conditions this join completes, owned by the statement
+            ExpressionPtr condition;
+            for (size_t c = 0; c < conjuncts.size(); c++) {
+                if (used[c] || (masks[c] & ~joined) != 0) continue;
+                used[c] = true;
+                condition = condition ? Expression::makeLogical(ExpressionType::AND, std::move(condition),
+                                                                conjuncts[c]->clone())
+                                      : conjuncts[c]->clone();
+            }
+            Expression* bound = condition.get();
+            if (condition) query.planned.push_back(std::move(condition));
+            if (!planJoinStep(result, inputs[next], JoinType::INNER, bound, step, error)) {
+                return false;
+            }
+        }
+
+        // Put the columns back in written order for SELECT * and the binds
+        // below; the statistics follow them
+        root = std::move(result.root);
+        stats = result.stats;
+        if (!std::is_sorted(order.begin(), order.end())) {
+            std::vector<const Expression*> columns;
+            stats.columns.clear();
+            for (size_t t = 0; t < schemas.size(); t++) {
+                for (size_t c = 0; c < schemas[t].size(); c++) {
+                    ExpressionPtr column = Expression::makeColumn(schemas[t][c].table, schemas[t][c].name);
+                    // Bound by position, as a self join repeats names
+                    column->column_index = static_cast<int>(offsets[t] + c);
+                    columns.push_back(column.get());
+                    query.planned.push_back(std::move(column));
+                    stats.columns.push_back(result.stats.columns[offsets[t] + c]);
+                }
+            }
+            double estimated = root->getEstimatedRows();
+            root = std::make_unique<ProjectOperator>(std::move(root), std::move(columns), schema);
+            root->setEstimatedRows(estimated);
+        }
+    }
+
+    if (remainder) {
+        if (!remainder->bind(schema, error)) {
+            return false;
+        }
+        double rows = root->getEstimatedRows();
+        root = std::make_unique<FilterOperator>(std::move(root), remainder.get());
+        root->setEstimatedRows(scaled(rows, Selectivity::estimate(stats, remainder.get())));
+        query.planned.push_back(std::move(remainder));
+    }
+    return true;
+}
+
+// The smaller input is built: by row count once both inputs are analyzed,
+// else by heap pages. Without statistics every equi-join is hashed. With
+// them each algorithm is costed, reading base tables included: hash,
+// nested loop (when hashing a tiny build side does not pay), merge over
+// inputs read in index order or sorted, and an index nested loop join
+// probing a single-column index on a base table that is not kept by an
+// outer join.
+bool Planner::planJoinStep(JoinInput& left, JoinInput& right, JoinType type, Expression* condition, size_t step,
+                           std::string& error) {
+    const TableInfo* left_table = left.table;
+    const TableInfo* right_table = right.table;
+    int left_width = static_cast<int>(left.root->getSchema().size());
+    TableStats stats = joinStats(left.stats, right.stats);
+
+    Schema schema = left.root->getSchema();
+    schema.insert(schema.end(), right.root->getSchema().begin(), right.root->getSchema().end());
+    if (condition && !condition->bind(schema, error)) {
+        return false;
+    }
+
+    int left_key = 0, right_key = 0;
+    bool equi_join = condition && findJoinKeys(condition, left_width, left_key, right_key);
+    bool build_left = left.pages < right.pages;
+    bool keeps_left = type == JoinType::LEFT || type == JoinType::FULL;
+    bool keeps_right = type == JoinType::RIGHT || type == JoinType::FULL;
+    JoinMethod method = equi_join ? JoinMethod::HASH : JoinMethod::NESTED_LOOP;
+    const IndexInfo* left_order = nullptr;  // merge: read the input in this index's order
+    const IndexInfo* right_order = nullptr;
+    const IndexInfo* inner_index = nullptr;  // index nested loop: probed index
+    bool inner_left = false;
+    double joined_rows = -1;
+    if (stats.analyzed) {
+        const TableStats& left_stats = left.stats;
+        const TableStats& right_stats = right.stats;
+        double left_rows = static_cast<double>(left_stats.row_count);
+        double right_rows = static_cast<double>(right_stats.row_count);
+        joined_rows = condition ? Selectivity::estimateRows(stats, condition) : left_rows * right_rows;
+        build_left = left_rows < right_rows;
+        double probe_rows = build_left ? right_rows : left_rows;
+        double build_rows = build_left ? left_rows : right_rows;
+        // The rows of earlier joins cost the same whichever way they are
+        // joined, so only base tables count their scan
+        double left_scan = left_table ? Cost::tableScan(left_table->stats) : 0;
+        double right_scan = Cost::tableScan(right_table->stats);
+        double scans = left_scan + right_scan;
+
+        double best = scans + Cost::nestedLoopJoin(probe_rows, build_rows);
+        method = JoinMethod::NESTED_LOOP;
+        if (equi_join) {
+            // A build side past the hash join's memory budget is partitioned,
+            // writing both inputs out and reading them back
+            double build_pages = build_left ? left.pages : right.pages;
+            double spilled_pages =
+                build_pages * PAGE_SIZE_BYTES > HashJoinOperator::MEMORY_BYTES ? left.pages + right.pages : 0;
+            double cost = scans + Cost::hashJoin(probe_rows, build_rows, spilled_pages);
+            if (cost < best) {
+                best = cost;
+                method = JoinMethod::HASH;
+            }
+
+            // Index order leaves out NULL keys, which an outer join must keep
+            // unless the column is a primary key
+            double left_cost = left_scan + Cost::sort(left_rows);
+            double right_cost = right_scan + Cost::sort(right_rows);
+            const IndexInfo* left_index = left_table ? columnIndex(left_table, left_key, true) : nullptr;
+            const IndexInfo* right_index = columnIndex(right_table, right_key, true);
+            bool use_left_index =
+                left_index && (!keeps_left || left_table->columns[left_key].is_primary_key) &&
+                Cost::indexOrderScan(left_table->stats, left_key) < left_cost;
+            bool use_right_index =
+                right_index && (!keeps_right || right_table->columns[right_key].is_primary_key) &&
+                Cost::indexOrderScan(right_table->stats, right_key) < right_cost;
+            if (use_left_index) left_cost = Cost::indexOrderScan(left_table->stats, left_key);
+            if (use_right_index) right_cost = Cost::indexOrderScan(right_table->stats, right_key);
+            cost = left_cost + right_cost + Cost::mergeJoin(left_rows, right_rows);
+            if (cost < best) {
+                best = cost;
+                method = JoinMethod::MERGE;
+                left_order = use_left_index ? left_index : nullptr;
+                right_order = use_right_index ? right_index : nullptr;
+            }
+
+            // Each outer row looks up the inner rows sharing its key; the
+            // lookups bypass the scan, so not when it filters the rows
+            for (bool left_inner : {false, true}) {
+                const TableInfo* inner = left_inner ? left_table : right_table;
+                if (!inner || (left_inner ? keeps_left || left.filter : keeps_right || right.filter)) continue;
+                int inner_key = left_inner ? left_key : right_key;
+                const IndexInfo* index = columnIndex(inner, inner_key, false);
+                if (!index) continue;
+                double outer_rows = left_inner ? right_rows : left_rows;
+                double per_row = outer_rows > 0 ? joined_rows / outer_rows : 0;
+                cost = (left_inner ? right_scan : left_scan) +
+                       outer_rows * Cost::indexJoinLookup(inner->stats, inner_key, per_row, index->hash);
+                if (cost < best) {
+                    best = cost;
+                    method = JoinMethod::INDEX_NESTED_LOOP;
+                    inner_index = index;
+                    inner_left = left_inner;
+                }
+            }
+        }
+    }
+
+    OperatorPtr root;
+    switch (method) {
+    case JoinMethod::HASH: {
+        std::string spill_prefix = "./data/" + db_name + "/" + right_table->name + ".join" + std::to_string(step);
+        root = std::make_unique<HashJoinOperator>(std::move(left.root), std::move(right.root), type, condition,
+                                                  left_key, right_key, build_left, spill_prefix);
+        break;
+    }
+    case JoinMethod::NESTED_LOOP:
+        root = std::make_unique<NestedLoopJoinOperator>(std::move(left.root), std::move(right.root), type, condition,
+                                                        build_left);
+        break;
+    case JoinMethod::MERGE:
+        if (left_order) {
+            Schema left_schema = left.root->getSchema();
+            left.root = std::make_unique<IndexRangeScanOperator>(
+                storage_manager, index_manager, getTablePath(left_table->name),
+                catalog_manager->getIndexPath(*left_order), KeyRange(), std::vector<int>{left_key}, left_schema);
+            left.root->setEstimatedRows(left_table->stats.row_count);
+            if (left.filter) {
+                left.root = std::make_unique<FilterOperator>(std::move(left.root), left.filter);
+                left.root->setEstimatedRows(left.stats.row_count);
+            }
+        }
+        if (right_order) {
+            Schema right_schema = right.root->getSchema();
+            right.root = std::make_unique<IndexRangeScanOperator>(
+                storage_manager, index_manager, getTablePath(right_table->name),
+                catalog_manager->getIndexPath(*right_order), KeyRange(), std::vector<int>{right_key}, right_schema);
+            right.root->setEstimatedRows(right_table->stats.row_count);
+            if (right.filter) {
+                right.root = std::make_unique<FilterOperator>(std::move(right.root), right.filter);
+                right.root->setEstimatedRows(right.stats.row_count);
+            }
+        }
+        root = std::make_unique<MergeJoinOperator>(std::move(left.root), std::move(right.root), type, condition,
+                                                   left_key, right_key, !left_order, !right_order);
+        break;
+    case JoinMethod::INDEX_NESTED_LOOP: {
+        const TableInfo* inner = inner_left ? left_table : right_table;
+        OperatorPtr& outer = inner_left ? right.root : left.root;
+        Schema inner_schema = (inner_left ? left.root : right.root)->getSchema();
+        root = std::make_unique<IndexNestedLoopJoinOperator>(
+            std::move(outer), storage_manager, index_manager, getTablePath(inner->name),
+            catalog_manager->getIndexPath(*inner_index), inner_schema, type, condition,
+            inner_left ? right_key : left_key, !inner_left);
+        break;
+    }
+    }
+
+    // The joined rows become the left input of the next join
+    if (stats.analyzed) {
+        // Outer joins keep every row of the preserved side
+        double rows = joined_rows;
+        if (keeps_left) rows = std::max<double>(rows, left.stats.row_count);
+        if (keeps_right) rows = std::max<double>(rows, right.stats.row_count);
+        root->setEstimatedRows(rows);
+        double row_pages = (left.stats.row_count > 0 ? left.pages / left.stats.row_count : 0) +
+                           (right.stats.row_count > 0 ? right.pages / right.stats.row_count : 0);
+        left.pages = rows * row_pages;
+        left.stats = scaleStats(stats, rows);
+        left.stats.page_count = static_cast<int64_t>(std::ceil(left.pages));
+    } else {
+        left.pages += right.pages;
+        left.stats = stats;
+    }
+    left.root = std::move(root);
+    left.table = nullptr;
+    return true;
+}
+
+// Output rows are the group columns, then one column per distinct
+// aggregate named by its SQL text, so the select list, HAVING and ORDER BY
+// bind to it like to any other column
+bool Planner::planAggregate(SelectStatement& query, TableInfo* table, const TableStats& stats,
+                            OperatorPtr& root, Schema& output, std::string& error) {
+    const Schema& input = root->getSchema();
+
+    std::vector<const Expression*> group_by;
+    for (auto& expression : query.group_by) {
+        if (!expression->bind(input, error)) return false;
+        group_by.push_back(expression.get());
+    }
+
+    std::vector<Expression*> collected;
+    for (auto& item : query.items) item.expression->collectAggregates(collected);
+    if (query.having) query.having->collectAggregates(collected);
+    for (auto& item : query.order_by) item.expression->collectAggregates(collected);
+
+    std::vector<const Expression*> aggregates;
+    for (Expression* aggregate : collected) {
+        if (!aggregate->children.empty() && !aggregate->children[0]->bind(input, error)) {
+            return false;
+        }
+        aggregates.push_back(aggregate);
+    }
+
+    output.clear();
+    for (const Expression* expression : group_by) {
+        if (expression->type == ExpressionType::COLUMN) {
+            output.push_back({input[expression->column_index].table, input[expression->column_index].name, ""});
+        } else {
+            output.push_back({"", expression->toString(), ""});
+        }
+    }
+    for (const Expression* aggregate : aggregates) {
+        output.push_back({"", aggregate->toString(), ""});
+    }
+    for (const auto& item : query.items) {
+        for (auto& column : output) {
+            if (!item.alias.empty() && (column.name == item.expression->toString() ||
+                                        (item.expression->type == ExpressionType::COLUMN &&
+                                         column.name == item.expression->name))) {
+                column.alias = item.alias;
+            }
+        }
+    }
+
+    // Single-table aggregates run vectorized when the batch kernels cover
+    // WHERE and the aggregate arguments, unless the index path is cheaper
+    double input_rows = root->getEstimatedRows();
+    double groups = input_rows < 0 && !group_by.empty() ? -1
+                  : Selectivity::estimateGroups(stats, group_by, input_rows);
+    OperatorPtr batch;
+    IndexPath path;
+    std::vector<bool> needed = table ? referencedColumns(query, table) : std::vector<bool>();
+    if (table && !chooseIndexPath(table, query.where.get(), path, &needed)) {
+        batch = BatchAggregateOperator::create(storage_manager, getTablePath(table->name), table,
+                                               query.where.get(), group_by, aggregates, output);
+    }
+    if (batch) {
+        root = std::move(batch);
+    } else {
+        root = std::make_unique<AggregateOperator>(std::move(root), std::move(group_by),
+                                                   std::move(aggregates), output);
+    }
+    root->setEstimatedRows(groups);
+
+    // HAVING filters whole groups; there are no statistics on aggregates,
+    // so its selectivity is a default one
+    if (query.having) {
+        if (!query.having->bind(output, error)) return false;
+        root = std::make_unique<FilterOperator>(std::move(root), query.having.get());
+        root->setEstimatedRows(scaled(groups, Selectivity::estimate(TableStats(), query.having.get())));
+    }
+    return true;
+}
+
+bool Planner::planSelect(SelectStatement& query, OperatorPtr& root, std::string& error) {
+    TableInfo* table = catalog_manager->getTableInfo(query.from.name);
+    if (!table) {
+        error = "Table not found: " + query.from.name;
+        return false;
+    }
+    // Statistics of the rows entering the aggregate step
+    TableStats stats = table->stats;
+    if (query.joins.empty()) {
+        std::vector<bool> needed = referencedColumns(query, table);
+        if (!planScan(table, query.from.qualifier(), query.where.get(), root, error, &needed)) return false;
+    } else if (!planJoin(query, root, stats, error)) {
+        return false;
+    }
+
+    bool select_all = query.items.size() == 1 && query.items[0].expression->type == ExpressionType::STAR;
+    bool aggregate = !query.group_by.empty() || query.having;
+    for (const auto& item : query.items) {
+        aggregate = aggregate || item.expression->containsAggregate();
+    }
+
+    // Columns the select list and ORDER BY are bound to
+    Schema output = root->getSchema();
+    if (aggregate) {
+        if (select_all) {
+            error = "SELECT * cannot be used with GROUP BY or aggregates";
+            return false;
+        }
+        if (!planAggregate(query, query.joins.empty() ? table : nullptr, stats, root, output, error)) {
+            return false;
+        }
+    } else {
+        // ORDER BY may name a column by its select list alias
+        for (auto& item : query.items) {
+            if (!item.alias.empty() && item.expression->type == ExpressionType::COLUMN &&
+                item.expression->bind(output, error)) {
+                output[item.expression->column_index].alias = item.alias;
+            }
+        }
+    }
+
+    if (!query.order_by.empty()) {
+        std::vector<SortKey> keys;
+        for (auto& item : query.order_by) {
+            if (!item.expression->bind(output, error)) return false;
+            keys.push_back({item.expression.get(), item.ascending});
+        }
+        // With a LIMIT only the rows it may return are kept
+        double rows = root->getEstimatedRows();
+        if (query.limit >= 0) {
+            size_t count = static_cast<size_t>(query.limit + query.offset);
+            root = std::make_unique<TopNOperator>(std::move(root), std::move(keys), count);
+            root->setEstimatedRows(rows < 0 ? rows : std::min<double>(rows, count));
+        } else {
+            root = std::make_unique<SortOperator>(std::move(root), std::move(keys));
+            root->setEstimatedRows(rows);
+        }
+    }
+
+    if (!select_all) {
+        std::vector<const Expression*> expressions;
+        Schema projected;
+        for (auto& item : query.items) {
+            if (!item.expression->bind(output, error)) return false;
+            expressions.push_back(item.expression.get());
+            projected.push_back({"", item.alias.empty() ? item.expression->toString() : item.alias, ""});
+        }
+        double rows = root->getEstimatedRows();
+        root = std::make_unique<ProjectOperator>(std::move(root), std::move(expressions), std::move(projected));
+        root->setEstimatedRows(rows);
+    }
+
+    if (query.limit >= 0) {
+        double rows = root->getEstimatedRows();
+        root = std::make_unique<LimitOperator>(std::move(root), static_cast<size_t>(query.limit),
+                                               static_cast<size_t>(query.offset));
+        root->setEstimatedRows(rows < 0 ? rows : std::clamp<double>(rows - query.offset, 0, query.limit));
+    }
+    return true;
+}
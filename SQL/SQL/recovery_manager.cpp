@@ -0,0 +1,313 @@
+#include "recovery_manager.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <algorithm>
+
+namespace {
+    const uint32_t MASTER_MAGIC = 0x434B5054;  // "CKPT"
+}
+
+RecoveryManager::RecoveryManager(StorageManager* sm, LogManager* lm, const std::string& master_file)
+    : storage_manager(sm), log_manager(lm), master_file(master_file) {
+    lsn_t base_lsn;
+    if (!readMaster(master_file, last_checkpoint_lsn, base_lsn)) {
+        last_checkpoint_lsn = INVALID_LSN;
+    }
+}
+
+lsn_t RecoveryManager::prepareLog(const std::string& log_file, const std::string& master_file) {
+    lsn_t checkpoint_lsn, base_lsn;
+    if (!readMaster(master_file, checkpoint_lsn, base_lsn)) {
+        base_lsn = LOG_HEADER_SIZE;
+    }
+
+    // A copy named after the base the master records was installed by the
+    // crashed checkpoint; any other copy was never installed
+    std::filesystem::path log_path(log_file);
+    std::error_code ec;
+    std::string prefix = log_path.filename().string() + ".";
+    for (const auto& entry : std::filesystem::directory_iterator(log_path.parent_path(), ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::string suffix = name.substr(prefix.size());
+        if (suffix.empty() || suffix.find_first_not_of("0123456789") != std::string::npos) continue;
+        if (std::stoull(suffix) == base_lsn) {
+            std::filesystem::rename(entry.path(), log_path, ec);
+        } else {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    return base_lsn;
+}
+
+std::string RecoveryManager::pageKey(const std::string& filename, int page_id) {
+    return filename + "#" + std::to_string(page_id);
+}
+
+bool RecoveryManager::readMaster(const std::string& master_file, lsn_t& checkpoint_lsn, lsn_t& base_lsn) {
+    std::ifstream file(master_file, std::ios::binary);
+    uint32_t magic = 0;
+    checkpoint_lsn = INVALID_LSN;
+    base_lsn = LOG_HEADER_SIZE;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&checkpoint_lsn), sizeof(lsn_t));
+    if (!file || magic != MASTER_MAGIC) {
+        checkpoint_lsn = INVALID_LSN;
+        return false;
+    }
+    if (!file.read(reinterpret_cast<char*>(&base_lsn), sizeof(lsn_t))) {
+        base_lsn = LOG_HEADER_SIZE;
+    }
+    return true;
+}
+
+bool RecoveryManager::writeMaster(lsn_t checkpoint_lsn, lsn_t base_lsn) const {
+    // Write a new copy and rename it over the old one so a crash leaves
+    // either the previous or the new checkpoint, never a torn record
+    std::string tmp_file = master_file + ".tmp";
+    {
+        std::ofstream file(tmp_file, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&MASTER_MAGIC), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&checkpoint_lsn), sizeof(lsn_t));
+        file.write(reinterpret_cast<const char*>(&base_lsn), sizeof(lsn_t));
+        if (!file) {
+            std::cerr << "Failed to write checkpoint record: " << tmp_file << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_file, master_file, ec);
+    if (ec) {
+        std::cerr << "Failed to install checkpoint record: " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool RecoveryManager::checkpoint(bool flush_all) {
+    BufferPool* buffer_pool = storage_manager->getBufferPool();
+    if (flush_all) {
+        if (!buffer_pool->flushAll()) {
+            return false;
+        }
+    } else if (last_checkpoint_lsn != INVALID_LSN) {
+        buffer_pool->flushPagesOlderThan(last_checkpoint_lsn);
+    }
+
+    LogRecord begin_record;
+    begin_record.type = LogRecordType::BEGIN_CHECKPOINT;
+    lsn_t begin_lsn = log_manager->appendLogRecord(begin_record);
+
+    // Transactions and pages may change while the tables are collected;
+    // analysis starts at begin_lsn and sees those changes in the log
+    LogRecord end_record;
+    end_record.type = LogRecordType::END_CHECKPOINT;
+    end_record.active_transactions = log_manager->getActiveTransactions();
+    end_record.dirty_pages = buffer_pool->getDirtyPages();
+    if (!log_manager->flush(log_manager->appendLogRecord(end_record))) {
+        return false;
+    }
+
+    if (!writeMaster(begin_lsn, log_manager->getFirstLSN())) {
+        return false;
+    }
+    last_checkpoint_lsn = begin_lsn;
+
+    // Restart reads nothing older than the checkpoint, the oldest change a
+    // page on disk may lack and the first record of an unfinished
+    // transaction, which rollback may still walk back to
+    lsn_t keep = begin_lsn;
+    for (const DirtyPageEntry& entry : end_record.dirty_pages) {
+        keep = std::min(keep, entry.rec_lsn);
+    }
+    lsn_t oldest_transaction = log_manager->getOldestActiveLSN();
+    if (oldest_transaction != INVALID_LSN) {
+        keep = std::min(keep, oldest_transaction);
+    }
+    return log_manager->discardBefore(keep, [this, begin_lsn](lsn_t base_lsn) {
+        return writeMaster(begin_lsn, base_lsn);
+    });
+}
+
+void RecoveryManager::maybeCheckpoint() {
+    lsn_t since = std::max<lsn_t>(last_checkpoint_lsn, log_manager->getFirstLSN());
+    if (log_manager->getNextLSN() - since >= CHECKPOINT_INTERVAL_BYTES) {
+        checkpoint();
+    }
+}
+
+bool RecoveryManager::recover(int& max_transaction_id) {
+    max_transaction_id = 0;
+
+    // Start from the last complete checkpoint, or the beginning of the log
+    lsn_t start_lsn = log_manager->getFirstLSN();
+    LogRecord master_record;
+    if (last_checkpoint_lsn != INVALID_LSN &&
+        log_manager->readLogRecord(last_checkpoint_lsn, master_record) &&
+        master_record.type == LogRecordType::BEGIN_CHECKPOINT) {
+        start_lsn = last_checkpoint_lsn;
+    }
+    if (start_lsn >= log_manager->getNextLSN()) {
+        return true;  // Nothing logged since the last checkpoint
+    }
+
+    std::map<int, TransactionEntry> transactions;
+    std::map<std::string, DirtyPageEntry> dirty_pages;
+    if (!analysis(start_lsn, transactions, dirty_pages, max_transaction_id)) {
+        return false;
+    }
+
+    size_t redone = 0;
+    if (!redo(dirty_pages, redone)) {
+        return false;
+    }
+
+    if (!undo(transactions)) {
+        return false;
+    }
+
+    if (redone > 0 || !transactions.empty()) {
+        std::cout << "Recovery: replayed " << redone << " log records, rolled back "
+                  << transactions.size() << " unfinished transactions" << std::endl;
+    }
+    return log_manager->flushAll();
+}
+
+bool RecoveryManager::analysis(lsn_t start_lsn, std::map<int, TransactionEntry>& transactions,
+                               std::map<std::string, DirtyPageEntry>& dirty_pages,
+                               int& max_transaction_id) {
+    std::set<int> finished;
+    lsn_t end_lsn = log_manager->getNextLSN();
+    lsn_t lsn = start_lsn;
+
+    while (lsn < end_lsn) {
+        LogRecord record;
+        if (!log_manager->readLogRecord(lsn, record)) {
+            // A crash while the log was being written leaves a torn record;
+            // nothing after it was ever acknowledged
+            std::cout << "Discarding incomplete log tail at offset " << lsn << std::endl;
+            return log_manager->truncate(lsn);
+        }
+        max_transaction_id = std::max(max_transaction_id, record.transaction_id);
+
+        switch (record.type) {
+        case LogRecordType::BEGIN:
+            transactions[record.transaction_id] = {lsn};
+            break;
+        case LogRecordType::UPDATE:
+        case LogRecordType::CLR: {
+            transactions[record.transaction_id] = {lsn};
+            std::string key = pageKey(record.filename, record.page_id);
+            if (dirty_pages.find(key) == dirty_pages.end()) {
+                dirty_pages[key] = {record.filename, record.page_id, lsn};
+            }
+            break;
+        }
+        case LogRecordType::COMMIT:
+        case LogRecordType::ABORT:
+            transactions.erase(record.transaction_id);
+            finished.insert(record.transaction_id);
+            break;
+        case LogRecordType::END_CHECKPOINT:
+            for (const auto& [transaction_id, last_lsn] : record.active_transactions) {
+                max_transaction_id = std::max(max_transaction_id, transaction_id);
+                if (!finished.count(transaction_id) && !transactions.count(transaction_id)) {
+                    transactions[transaction_id] = {last_lsn};
+                }
+            }
+            for (const auto& entry : record.dirty_pages) {
+                std::string key = pageKey(entry.filename, entry.page_id);
+                auto it = dirty_pages.find(key);
+                if (it == dirty_pages.end()) {
+                    dirty_pages[key] = entry;
+                } else {
+                    it->second.rec_lsn = std::min(it->second.rec_lsn, entry.rec_lsn);
+                }
+            }
+            break;
+        case LogRecordType::BEGIN_CHECKPOINT:
+            break;
+        }
+
+        lsn += record.getSize();
+    }
+    return true;
+}
+
+bool RecoveryManager::redo(const std::map<std::string, DirtyPageEntry>& dirty_pages, size_t& redone) {
+    if (dirty_pages.empty()) {
+        return true;
+    }
+
+    // Repeat history from the oldest change that may be missing on disk
+    lsn_t lsn = dirty_pages.begin()->second.rec_lsn;
+    for (const auto& [key, entry] : dirty_pages) {
+        lsn = std::min(lsn, entry.rec_lsn);
+    }
+    lsn = std::max<lsn_t>(lsn, log_manager->getFirstLSN());
+
+    lsn_t end_lsn = log_manager->getNextLSN();
+    while (lsn < end_lsn) {
+        LogRecord record;
+        if (!log_manager->readLogRecord(lsn, record)) {
+            std::cerr << "Failed to read log record at " << lsn << " during redo" << std::endl;
+            return false;
+        }
+
+        if (record.type == LogRecordType::UPDATE || record.type == LogRecordType::CLR) {
+            auto it = dirty_pages.find(pageKey(record.filename, record.page_id));
+            if (it != dirty_pages.end() && lsn >= it->second.rec_lsn) {
+                if (!storage_manager->redoLogRecord(record)) {
+                    return false;
+                }
+                redone++;
+            }
+        }
+        lsn += record.getSize();
+    }
+    return true;
+}
+
+bool RecoveryManager::undo(const std::map<int, TransactionEntry>& transactions) {
+    // Always undo the newest outstanding record across all losers
+    std::map<lsn_t, int> to_undo;
+    for (const auto& [transaction_id, entry] : transactions) {
+        log_manager->registerTransaction(transaction_id, entry.last_lsn);
+        to_undo[entry.last_lsn] = transaction_id;
+    }
+
+    while (!to_undo.empty()) {
+        auto newest = std::prev(to_undo.end());
+        lsn_t lsn = newest->first;
+        int transaction_id = newest->second;
+        to_undo.erase(newest);
+
+        LogRecord record;
+        if (!log_manager->readLogRecord(lsn, record)) {
+            std::cerr << "Failed to read log record at " << lsn << " during undo" << std::endl;
+            return false;
+        }
+
+        lsn_t next_lsn = record.prev_lsn;
+        if (record.type == LogRecordType::UPDATE) {
+            if (!storage_manager->undoLogRecord(record)) {
+                return false;
+            }
+        } else if (record.type == LogRecordType::CLR) {
+            next_lsn = record.undo_next_lsn;
+        }
+
+        if (next_lsn == INVALID_LSN) {
+            LogRecord abort_record;
+            abort_record.type = LogRecordType::ABORT;
+            abort_record.transaction_id = transaction_id;
+            log_manager->appendLogRecord(abort_record);
+        } else {
+            to_undo[next_lsn] = transaction_id;
+        }
+    }
+    return true;
+}
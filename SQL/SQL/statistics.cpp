@@ -0,0 +1,432 @@
+#include "statistics.h"
+#include "ast.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+StatisticsBuilder::StatisticsBuilder(size_t num_columns) : row_count(0), columns(num_columns), random(42) {}
+
+void StatisticsBuilder::add(const Record& record) {
+    row_count++;
+    for (size_t c = 0; c < columns.size(); c++) {
+        ColumnSample& column = columns[c];
+        if (c >= record.values.size() || record.values[c].isNull()) {
+            column.null_count++;
+            continue;
+        }
+        const Value& value = record.values[c];
+        if (column.seen == 0) {
+            column.min = value;
+            column.max = value;
+        } else {
+            column.steps += value >= column.previous;
+            if (value < column.min) column.min = value;
+            if (value > column.max) column.max = value;
+        }
+        column.previous = value;
+        column.seen++;
+
+        // Reservoir sampling: every value seen so far is kept with the
+        // same probability SAMPLE_SIZE / seen
+        if (column.values.size() < SAMPLE_SIZE) {
+            column.values.push_back(value);
+        } else {
+            uint64_t slot = random() % static_cast<uint64_t>(column.seen);
+            if (slot < SAMPLE_SIZE) column.values[slot] = value;
+        }
+    }
+}
+
+TableStats StatisticsBuilder::finish(int64_t page_count) {
+    TableStats stats;
+    stats.analyzed = true;
+    stats.row_count = row_count;
+    stats.page_count = page_count;
+
+    for (ColumnSample& column : columns) {
+        std::vector<Value>& sample = column.values;
+        ColumnStats col;
+        col.null_count = column.null_count;
+        col.ordered = column.seen > 1 ? static_cast<double>(column.steps) / (column.seen - 1) : 1;
+        std::sort(sample.begin(), sample.end());
+
+        // Distinct values of the sample, and those seen only once in it
+        int64_t distinct = 0, singles = 0;
+        for (size_t i = 0; i < sample.size(); i++) {
+            if (i > 0 && sample[i] == sample[i - 1]) continue;
+            distinct++;
+            singles += i + 1 == sample.size() || sample[i + 1] != sample[i];
+        }
+        if (static_cast<int64_t>(sample.size()) == column.seen) {
+            col.distinct_count = distinct;
+        } else {
+            // Haas and Stokes' estimator, as PostgreSQL uses: values seen
+            // once in the sample stand for the ones the sample missed
+            double n = static_cast<double>(sample.size());
+            double total = static_cast<double>(column.seen);
+            double estimate = n * distinct / (n - singles + singles * n / total);
+            col.distinct_count = std::clamp<int64_t>(std::llround(estimate), distinct, column.seen);
+        }
+        if (!sample.empty()) {
+            col.min = column.min;
+            col.max = column.max;
+            size_t buckets = std::min(HISTOGRAM_BUCKETS, sample.size());
+            for (size_t b = 1; b <= buckets; b++) {
+                col.histogram.push_back(sample[b * sample.size() / buckets - 1]);
+            }
+            // The sample may miss the largest value
+            col.histogram.back() = column.max;
+        }
+        stats.columns.push_back(col);
+        sample.clear();
+        sample.shrink_to_fit();
+    }
+    return stats;
+}
+
+namespace {
+    const double DEFAULT_EQUALITY_SELECTIVITY = 0.1;
+    const double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3.0;
+
+    double clamp(double fraction) {
+        return std::max(0.0, std::min(1.0, fraction));
+    }
+
+    // Fraction of the column's non-NULL values that equal value
+    double equalFraction(const ColumnStats& col, const Value& value) {
+        if (col.distinct_count == 0 || value < col.min || value > col.max) return 0;
+        return 1.0 / col.distinct_count;
+    }
+
+    // Fraction of the column's non-NULL values below value, read off the
+    // histogram and interpolated linearly inside a numeric bucket
+    double lessFraction(const ColumnStats& col, const Value& value, bool inclusive) {
+        const std::vector<Value>& bounds = col.histogram;
+        if (bounds.empty()) return 0;
+        if (value < col.min || (!inclusive && value == col.min)) return 0;
+
+        size_t bucket = 0;
+        while (bucket < bounds.size() && bounds[bucket] < value) bucket++;
+        if (bucket == bounds.size()) return 1;
+
+        double per_bucket = 1.0 / bounds.size();
+        double fraction = bucket * per_bucket;
+        const Value& low = bucket == 0 ? col.min : bounds[bucket - 1];
+        const Value& high = bounds[bucket];
+        if (low.isNumeric() && high.isNumeric() && value.isNumeric() && high.asDouble() > low.asDouble()) {
+            fraction += per_bucket * (value.asDouble() - low.asDouble()) / (high.asDouble() - low.asDouble());
+        } else {
+            fraction += per_bucket / 2;
+        }
+        if (inclusive) fraction += equalFraction(col, value);
+        return clamp(fraction);
+    }
+
+    // Puts the column of "literal op column" on the left, flipping op
+    void normalize(const Expression* comparison, const Expression*& left, const Expression*& right,
+                   std::string& op) {
+        left = comparison->children[0].get();
+        right = comparison->children[1].get();
+        op = comparison->op;
+        if (left->type == ExpressionType::LITERAL && right->type == ExpressionType::COLUMN) {
+            std::swap(left, right);
+            if (op == "<") op = ">";
+            else if (op == ">") op = "<";
+            else if (op == "<=") op = ">=";
+            else if (op == ">=") op = "<=";
+        }
+    }
+
+    double comparisonSelectivity(const TableStats& stats, const Expression* comparison) {
+        const Expression* left;
+        const Expression* right;
+        std::string op;
+        normalize(comparison, left, right, op);
+        bool is_equality = op == "=";
+        double fallback = is_equality ? DEFAULT_EQUALITY_SELECTIVITY
+                        : (op == "!=" || op == "<>") ? 1 - DEFAULT_EQUALITY_SELECTIVITY
+                        : DEFAULT_RANGE_SELECTIVITY;
+
+        // Unanalyzed tables have no column statistics
+        if (left->type != ExpressionType::COLUMN || left->column_index < 0 ||
+            static_cast<size_t>(left->column_index) >= stats.columns.size() || stats.row_count == 0) {
+            return fallback;
+        }
+        const ColumnStats& col = stats.columns[left->column_index];
+        double non_null = static_cast<double>(stats.row_count - col.null_count) / stats.row_count;
+
+        if (right->type == ExpressionType::COLUMN) {
+            if (!is_equality || right->column_index < 0 ||
+                static_cast<size_t>(right->column_index) >= stats.columns.size()) {
+                return fallback;
+            }
+            int64_t distinct = std::max(col.distinct_count, stats.columns[right->column_index].distinct_count);
+            return distinct > 0 ? non_null / distinct : 0;
+        }
+        if (right->type != ExpressionType::LITERAL) return fallback;
+
+        const Value& value = right->value;
+        if (value.isNull()) return 0;
+
+        double fraction;
+        if (op == "=") fraction = equalFraction(col, value);
+        else if (op == "!=" || op == "<>") fraction = 1 - equalFraction(col, value);
+        else if (op == "<") fraction = lessFraction(col, value, false);
+        else if (op == "<=") fraction = lessFraction(col, value, true);
+        else if (op == ">") fraction = 1 - lessFraction(col, value, true);
+        else if (op == ">=") fraction = 1 - lessFraction(col, value, false);
+        else return fallback;
+        return clamp(fraction) * non_null;
+    }
+
+    // Tightest lower and upper bound a conjunction puts on one column
+    struct ColumnBounds {
+        const Expression* low = nullptr;
+        const Expression* high = nullptr;
+        Value low_value, high_value;
+        bool low_inclusive = true, high_inclusive = true;
+    };
+
+    void flattenAnd(const Expression* expression, std::vector<const Expression*>& conjuncts) {
+        if (expression->type == ExpressionType::AND) {
+            flattenAnd(expression->children[0].get(), conjuncts);
+            flattenAnd(expression->children[1].get(), conjuncts);
+        } else {
+            conjuncts.push_back(expression);
+        }
+    }
+
+    // Multiplying the selectivities of "x >= a" and "x <= b" would treat
+    // the two bounds as independent; a range on one column is instead the
+    // histogram mass between its bounds
+    double conjunctionSelectivity(const TableStats& stats, const std::vector<const Expression*>& conjuncts) {
+        double selectivity = 1;
+        std::map<int, ColumnBounds> bounds;
+        for (const Expression* conjunct : conjuncts) {
+            const Expression* column = nullptr;
+            const Expression* literal = nullptr;
+            std::string op;
+            if (conjunct->type == ExpressionType::COMPARISON) {
+                normalize(conjunct, column, literal, op);
+            }
+            bool is_range = op == "<" || op == "<=" || op == ">" || op == ">=";
+            if (!is_range || column->type != ExpressionType::COLUMN || column->column_index < 0 ||
+                static_cast<size_t>(column->column_index) >= stats.columns.size() ||
+                literal->type != ExpressionType::LITERAL || literal->value.isNull()) {
+                selectivity *= Selectivity::estimate(stats, conjunct);
+                continue;
+            }
+
+            ColumnBounds& b = bounds[column->column_index];
+            const Value& value = literal->value;
+            bool inclusive = op.size() == 2;
+            if (op[0] == '>') {
+                if (!b.low || value > b.low_value || (value == b.low_value && !inclusive)) {
+                    b.low = conjunct;
+                    b.low_value = value;
+                    b.low_inclusive = inclusive;
+                }
+            } else if (!b.high || value < b.high_value || (value == b.high_value && !inclusive)) {
+                b.high = conjunct;
+                b.high_value = value;
+                b.high_inclusive = inclusive;
+            }
+        }
+
+        for (const auto& entry : bounds) {
+            const ColumnBounds& b = entry.second;
+            if (!b.low || !b.high || stats.row_count == 0) {
+                selectivity *= Selectivity::estimate(stats, b.low ? b.low : b.high);
+                continue;
+            }
+            const ColumnStats& col = stats.columns[entry.first];
+            double non_null = static_cast<double>(stats.row_count - col.null_count) / stats.row_count;
+            double fraction = lessFraction(col, b.high_value, b.high_inclusive) -
+                              lessFraction(col, b.low_value, !b.low_inclusive);
+            selectivity *= clamp(fraction) * non_null;
+        }
+        return selectivity;
+    }
+}
+
+namespace Selectivity {
+    double estimate(const TableStats& stats, const Expression* predicate) {
+        if (!predicate) return 1;
+        switch (predicate->type) {
+        case ExpressionType::AND:
+            return estimateAll(stats, {predicate});
+        case ExpressionType::OR: {
+            double a = estimate(stats, predicate->children[0].get());
+            double b = estimate(stats, predicate->children[1].get());
+            return a + b - a * b;
+        }
+        case ExpressionType::NOT:
+            return 1 - estimate(stats, predicate->children[0].get());
+        case ExpressionType::COMPARISON:
+            return comparisonSelectivity(stats, predicate);
+        default:
+            return DEFAULT_RANGE_SELECTIVITY;
+        }
+    }
+
+    double estimateAll(const TableStats& stats, const std::vector<const Expression*>& predicates) {
+        std::vector<const Expression*> conjuncts;
+        for (const Expression* predicate : predicates) {
+            flattenAnd(predicate, conjuncts);
+        }
+        return conjunctionSelectivity(stats, conjuncts);
+    }
+
+    double estimateRows(const TableStats& stats, const Expression* predicate) {
+        return stats.row_count * estimate(stats, predicate);
+    }
+
+    double estimateGroups(const TableStats& stats, const std::vector<const Expression*>& group_by,
+                          double input_rows) {
+        if (group_by.empty()) return 1;
+        double groups = 1;
+        for (const Expression* expression : group_by) {
+            int column = expression->type == ExpressionType::COLUMN ? expression->column_index : -1;
+            if (column >= 0 && static_cast<size_t>(column) < stats.columns.size()) {
+                const ColumnStats& col = stats.columns[column];
+                // NULL forms a group of its own
+                groups *= std::max<int64_t>(col.distinct_count + (col.null_count > 0 ? 1 : 0), 1);
+            } else {
+                groups *= 1 / DEFAULT_EQUALITY_SELECTIVITY;
+            }
+        }
+        return std::min(groups, std::max(input_rows, 1.0));
+    }
+}
+
+TableStats joinStats(const TableStats& left, const TableStats& right) {
+    TableStats stats;
+    stats.analyzed = left.analyzed && right.analyzed;
+    stats.row_count = left.row_count * right.row_count;
+    stats.page_count = left.page_count + right.page_count;
+    stats.columns = left.columns;
+    stats.columns.insert(stats.columns.end(), right.columns.begin(), right.columns.end());
+    // Column statistics describe fractions of a column's own rows; scale
+    // the NULL counts to the product so non-NULL fractions stay the same
+    for (size_t i = 0; i < stats.columns.size(); i++) {
+        stats.columns[i].null_count *= i < left.columns.size() ? right.row_count : left.row_count;
+    }
+    return stats;
+}
+
+TableStats scaleStats(const TableStats& product, double rows) {
+    TableStats stats = product;
+    stats.row_count = static_cast<int64_t>(std::llround(std::max(rows, 0.0)));
+    double fraction = product.row_count > 0 ? rows / product.row_count : 0;
+    for (ColumnStats& column : stats.columns) {
+        column.null_count = static_cast<int64_t>(std::llround(column.null_count * fraction));
+        column.distinct_count = std::min(column.distinct_count, stats.row_count);
+    }
+    return stats;
+}
+
+namespace Cost {
+    namespace {
+        double indexHeight(const TableStats& stats) {
+            double height = 1;
+            if (stats.row_count > 1) {
+                height = std::ceil(std::log(static_cast<double>(stats.row_count)) / std::log(INDEX_FANOUT));
+            }
+            return std::max(height, 1.0);
+        }
+
+        // Heap pages holding rows that are adjacent in column's order: as
+        // few as the rows fill when the table is stored in that order, one
+        // per row when it is not
+        double heapPages(const TableStats& stats, size_t column, double rows) {
+            double ordered = column < stats.columns.size() ? stats.columns[column].ordered : 0;
+            double rows_per_page = stats.page_count > 0 ? stats.row_count / static_cast<double>(stats.page_count) : 1;
+            double clustered = std::max(1.0, std::ceil(rows / std::max(rows_per_page, 1.0)));
+            return ordered * std::min(clustered, rows) + (1 - ordered) * rows;
+        }
+    }
+
+    double tableScan(const TableStats& stats) {
+        return std::max<int64_t>(stats.page_count, 1) + stats.row_count * CPU_ROW_COST;
+    }
+
+    double indexLookup(const TableStats& stats, double matching_rows) {
+        // Every matching row costs the heap page its RID points to
+        return indexHeight(stats) + matching_rows * (1 + CPU_ROW_COST);
+    }
+
+    double indexOnlyScan(const TableStats& stats, double matching_rows) {
+        return indexHeight(stats) + matching_rows / INDEX_FANOUT + matching_rows * CPU_ROW_COST;
+    }
+
+    double hashLookup(double matching_rows) {
+        return 2 + matching_rows * (1 + CPU_ROW_COST);
+    }
+
+    double hashOnlyLookup(double matching_rows) {
+        return 2 + matching_rows / INDEX_FANOUT + matching_rows * CPU_ROW_COST;
+    }
+
+    double indexOrderScan(const TableStats& stats, size_t column) {
+        double rows = static_cast<double>(stats.row_count);
+        return indexHeight(stats) + rows / INDEX_FANOUT + heapPages(stats, column, rows) + rows * CPU_ROW_COST;
+    }
+
+    double indexJoinLookup(const TableStats& stats, size_t column, double matching_rows, bool hash) {
+        return (hash ? 2 : indexHeight(stats)) + heapPages(stats, column, matching_rows) +
+               matching_rows * CPU_ROW_COST;
+    }
+
+    double sort(double rows) {
+        return rows > 1 ? rows * std::log2(rows) * CPU_ROW_COST : 0;
+    }
+
+    double hashJoin(double probe_rows, double build_rows, double spilled_pages) {
+        // Building costs about twice as much per row as probing
+        return (probe_rows + 2 * build_rows) * CPU_ROW_COST + 2 * spilled_pages;
+    }
+
+    double nestedLoopJoin(double probe_rows, double build_rows) {
+        return (probe_rows + probe_rows * build_rows) * CPU_ROW_COST;
+    }
+
+    double mergeJoin(double left_rows, double right_rows) {
+        return (left_rows + right_rows) * CPU_ROW_COST;
+    }
+}
+
+std::string encodeStatsValue(const Value& value) {
+    switch (value.getType()) {
+    case ValueType::NULL_VALUE:
+        return "N";
+    case ValueType::INT:
+        return "I " + std::to_string(value.asInt());
+    case ValueType::DOUBLE: {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value.asDouble());
+        return std::string("D ") + buffer;
+    }
+    case ValueType::CHAR:
+        return "C " + value.asString();
+    default:
+        return "V " + value.asString();
+    }
+}
+
+bool decodeStatsValue(const std::string& text, Value& value) {
+    if (text == "N") {
+        value = Value();
+        return true;
+    }
+    if (text.size() < 2 || text[1] != ' ') return false;
+    std::string payload = text.substr(2);
+    switch (text[0]) {
+    case 'I': value = Value(static_cast<int32_t>(std::strtol(payload.c_str(), nullptr, 10))); return true;
+    case 'D': value = Value(std::strtod(payload.c_str(), nullptr)); return true;
+    case 'C': value = Value(payload, ValueType::CHAR); return true;
+    case 'V': value = Value(payload, ValueType::VARCHAR); return true;
+    default: return false;
+    }
+}
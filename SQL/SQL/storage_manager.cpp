@@ -1,4 +1,5 @@
 #include "storage_manager.h"
+#include "heap_page.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -10,7 +11,63 @@
 
 using namespace std::filesystem;
 
-StorageManager::StorageManager() {
+namespace {
+    // Transaction whose changes the calling thread is making; -1 if none
+    thread_local int current_transaction_id = -1;
+
+    // Changed byte runs closer than this are logged as one record
+    const size_t LOG_MERGE_GAP = 32;
+
+    bool wanted(const std::vector<bool>& mask, size_t column) {
+        return mask.empty() || (column < mask.size() && mask[column]);
+    }
+
+    // Record::deserialize narrowed by a projection: every value is stepped
+    // over once, decoding only the filter's columns; the other projected
+    // columns are decoded once the row passes. False for a malformed or
+    // rejected row. offsets is scratch space kept across calls.
+    bool decodeProjected(const char* data, size_t size, const ScanProjection& projection, Record& record,
+                         std::vector<size_t>& offsets) {
+        if (size < sizeof(uint16_t)) {
+            return false;
+        }
+        uint16_t num_values;
+        memcpy(&num_values, data, sizeof(uint16_t));
+        if (num_values > Record::MAX_VALUES) {
+            std::cerr << "Too many values in record: " << num_values << std::endl;
+            return false;
+        }
+        record.values.assign(num_values, Value());
+        offsets.assign(num_values, 0);
+        bool filtered = static_cast<bool>(projection.filter);
+        size_t pos = sizeof(uint16_t);
+        for (size_t i = 0; i < num_values; i++) {
+            size_t length = Value::skip(data + pos, size - pos);
+            if (length == 0) {
+                std::cerr << "Malformed value " << i << " in record" << std::endl;
+                return false;
+            }
+            offsets[i] = pos;
+            if (filtered && i < projection.filter_columns.size() && projection.filter_columns[i]) {
+                record.values[i].deserialize(data + pos, length);
+            }
+            pos += length;
+        }
+        if (filtered && !projection.filter(record)) {
+            return false;
+        }
+        for (size_t i = 0; i < num_values; i++) {
+            bool decoded = filtered && i < projection.filter_columns.size() && projection.filter_columns[i];
+            if (!decoded && wanted(projection.columns, i)) {
+                record.values[i].deserialize(data + offsets[i], size - offsets[i]);
+            }
+        }
+        return true;
+    }
+}
+
+StorageManager::StorageManager(size_t buffer_pool_frames)
+    : buffer_pool(std::make_unique<BufferPool>(buffer_pool_frames)), log_manager(nullptr) {
     // Create data directory if it doesn't exist
     if (!exists("./data")) {
         create_directory("./data");
@@ -18,7 +75,156 @@ StorageManager::StorageManager() {
 }
 
 StorageManager::~StorageManager() {
-    // No file handle member, so nothing to close
+    // Write back any dirty pages still cached in the buffer pool
+    buffer_pool->flushAll();
+}
+
+void StorageManager::setLogManager(LogManager* manager) {
+    log_manager = manager;
+    buffer_pool->setLogManager(manager);
+}
+
+void StorageManager::setCurrentTransaction(int transaction_id) {
+    current_transaction_id = transaction_id;
+}
+
+int StorageManager::getCurrentTransaction() {
+    return current_transaction_id;
+}
+
+bool StorageManager::isLogging() const {
+    return log_manager != nullptr && current_transaction_id != -1;
+}
+
+void StorageManager::logPageChange(const std::string& filename, int page_id,
+                                   const char* before, Page& page) {
+    const char* after = page.getData();
+    std::string name = path(filename).lexically_normal().string();
+
+    // One UPDATE record per run of changed bytes, so a tuple insert logs the
+    // slot directory and the tuple rather than everything in between
+    size_t pos = PAGE_LSN_SIZE;
+    while (pos < PAGE_SIZE_BYTES) {
+        if (before[pos] == after[pos]) {
+            pos++;
+            continue;
+        }
+
+        size_t start = pos;
+        size_t end = pos + 1;
+        size_t gap = 0;
+        for (pos++; pos < PAGE_SIZE_BYTES && gap < LOG_MERGE_GAP; pos++) {
+            if (before[pos] != after[pos]) {
+                end = pos + 1;
+                gap = 0;
+            } else {
+                gap++;
+            }
+        }
+        pos = end;
+
+        LogRecord record;
+        record.type = LogRecordType::UPDATE;
+        record.transaction_id = current_transaction_id;
+        record.filename = name;
+        record.page_id = page_id;
+        record.offset = static_cast<uint16_t>(start);
+        record.before_image.assign(before + start, end - start);
+        record.after_image.assign(after + start, end - start);
+        page.setLSN(log_manager->appendLogRecord(record));
+    }
+}
+
+bool StorageManager::undoLogRecord(const LogRecord& record) {
+    if (!log_manager || record.type != LogRecordType::UPDATE) {
+        return false;
+    }
+    if (!exists(record.filename)) {
+        return true;  // The file was dropped after the change
+    }
+
+    Page* page = buffer_pool->fetchPage(record.filename, record.page_id);
+    if (!page) {
+        std::cerr << "Cannot undo change to page " << record.page_id << " of " << record.filename << std::endl;
+        return false;
+    }
+    page->writeData(record.offset, record.before_image.data(), record.before_image.size());
+
+    LogRecord clr;
+    clr.type = LogRecordType::CLR;
+    clr.transaction_id = record.transaction_id;
+    clr.filename = record.filename;
+    clr.page_id = record.page_id;
+    clr.offset = record.offset;
+    clr.after_image = record.before_image;
+    clr.undo_next_lsn = record.prev_lsn;
+    page->setLSN(log_manager->appendLogRecord(clr));
+
+    buffer_pool->unpinPage(record.filename, record.page_id, true);
+    return true;
+}
+
+bool StorageManager::redoLogRecord(const LogRecord& record) {
+    if (record.type != LogRecordType::UPDATE && record.type != LogRecordType::CLR) {
+        return false;
+    }
+    if (!exists(record.filename)) {
+        return true;  // The file was dropped after the change
+    }
+
+    // Pages appended after the last write-back do not exist on disk yet
+    int num_pages = getNumPages(record.filename);
+    Page* page = record.page_id < num_pages ? buffer_pool->fetchPage(record.filename, record.page_id)
+                                            : buffer_pool->newPage(record.filename, record.page_id);
+    if (!page) {
+        std::cerr << "Cannot redo change to page " << record.page_id << " of " << record.filename << std::endl;
+        return false;
+    }
+
+    bool apply = page->getLSN() < record.lsn;
+    if (apply) {
+        page->writeData(record.offset, record.after_image.data(), record.after_image.size());
+        page->setLSN(record.lsn);
+    }
+    buffer_pool->unpinPage(record.filename, record.page_id, apply);
+
+    if (record.page_id >= num_pages) {
+        page_counts[path(record.filename).lexically_normal().string()] = record.page_id + 1;
+    }
+    return true;
+}
+
+TableIterator::TableIterator(StorageManager* storage_manager, const std::string& file_path)
+    : storage_manager(storage_manager), file_path(file_path),
+      next_page_id(0), position(0), pages_read(0) {}
+
+bool TableIterator::next(Record& record) {
+    while (position >= page_records.size()) {
+        // The page count is re-read so rows appended mid-scan are still seen
+        if (next_page_id >= storage_manager->getNumPages(file_path)) {
+            return false;
+        }
+        page_records.clear();
+        position = 0;
+        bool narrowed = !projection.columns.empty() || projection.filter;
+        if (!storage_manager->getPageRecords(file_path, next_page_id, page_records,
+                                             narrowed ? &projection : nullptr)) {
+            std::cerr << "Failed to read page " << next_page_id << " of " << file_path << std::endl;
+            next_page_id = storage_manager->getNumPages(file_path);
+            return false;
+        }
+        next_page_id++;
+        pages_read++;
+    }
+    record = page_records[position++];
+    return true;
+}
+
+void TableIterator::reset() {
+    next_page_id = 0;
+    position = 0;
+    pages_read = 0;
+    page_records.clear();
 }
 
 bool StorageManager::createDatabase(const std::string& db_name) {
@@ -48,7 +254,8 @@ std::string StorageManager::getIndexPath(const std::string& db_name, const std::
 bool StorageManager::createTable(const std::string& db_name, const std::string& table_name) {
     std::string file_path = "./data/" + db_name + "/" + table_name + ".dat";
     
-    // Create empty file
+    // Create empty file; heap pages are appended as records arrive
+    discardFile(file_path);
     std::ofstream file(file_path, std::ios::binary);
     if (!file) {
         std::cerr << "Failed to create file: " << file_path << std::endl;
@@ -68,6 +275,7 @@ bool StorageManager::createFile(const std::string& filename) {
         create_directories(filepath.parent_path());
 
         // Create the file
+        buffer_pool->discardFile(filename);
         std::ofstream file(filename, std::ios::binary);
         if (!file) {
             std::cerr << "Failed to create file: " << filename << std::endl;
@@ -79,7 +287,7 @@ bool StorageManager::createFile(const std::string& filename) {
         empty_page.setFreeSpace(PAGE_SIZE_BYTES);
         empty_page.clear();
         
-        file.write(reinterpret_cast<const char*>(&empty_page), sizeof(Page));
+        file.write(empty_page.getData(), PAGE_SIZE_BYTES);
         
         file.close();
         
@@ -100,6 +308,7 @@ bool StorageManager::createFile(const std::string& filename) {
 bool StorageManager::dropTable(const std::string& db_name, const std::string& table_name) {
     std::string file_path = "./data/" + db_name + "/" + table_name + ".dat";
     
+    discardFile(file_path);
     if (std::remove(file_path.c_str()) != 0) {
         std::cerr << "Failed to remove file: " << file_path << std::endl;
         return false;
@@ -109,127 +318,153 @@ bool StorageManager::dropTable(const std::string& db_name, const std::string& ta
 }
 
 bool StorageManager::writePage(const std::string& filename, int page_id, const Page& page) {
-    try {
-        std::cout << "Writing page " << page_id << " to " << filename << std::endl;
-        std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
-        if (!file) {
-            std::cerr << "Failed to open file for writing: " << filename << std::endl;
-            return false;
-        }
-
-        file.seekp(page_id * sizeof(Page));
-        file.write(reinterpret_cast<const char*>(&page), sizeof(Page));
+    // The whole page is overwritten, so the frame does not need to be read
+    // first unless its old contents have to be logged
+    int num_pages = getNumPages(filename);
+    bool logging = isLogging();
+    Page* frame = logging && page_id < num_pages ? buffer_pool->fetchPage(filename, page_id)
+                                                 : buffer_pool->newPage(filename, page_id);
+    if (!frame) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
 
-        if (!file.good()) {
-            std::cerr << "Error writing to file: " << filename << std::endl;
-            return false;
-        }
+    Page before = *frame;
+    *frame = page;
+    frame->setLSN(before.getLSN());
+    if (logging) {
+        logPageChange(filename, page_id, before.getData(), *frame);
+    }
+    buffer_pool->unpinPage(filename, page_id, true);
 
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error writing page: " << e.what() << std::endl;
-        return false;
+    if (page_id >= num_pages) {
+        page_counts[path(filename).lexically_normal().string()] = page_id + 1;
     }
+    return true;
 }
 
 bool StorageManager::readPage(const std::string& filename, int page_id, Page& page) {
-    try {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file) {
-            std::cerr << "Failed to open file for reading: " << filename << std::endl;
-            return false;
-        }
+    Page* frame = buffer_pool->fetchPage(filename, page_id);
+    if (!frame) {
+        return false;  // Missing file or end of file reached
+    }
 
-        // Get file size
-        file.seekg(0, std::ios::end);
-        std::streampos file_size = file.tellg();
-        
-        // Check if page_id is beyond file size
-        if (static_cast<std::streampos>(page_id * sizeof(Page)) >= file_size) {
-            return false;  // End of file reached
-        }
+    page = *frame;
+    buffer_pool->unpinPage(filename, page_id, false);
+    return true;
+}
 
-        // Seek to the requested page
-        file.seekg(page_id * sizeof(Page));
-        if (!file.good()) {
-            return false;
-        }
+bool StorageManager::flushFile(const std::string& filename) {
+    return buffer_pool->flushFile(filename);
+}
 
-        // Read the page
-        file.read(reinterpret_cast<char*>(&page), sizeof(Page));
-        return file.good();
-    } catch (const std::exception& e) {
-        std::cerr << "Error reading page: " << e.what() << std::endl;
-        return false;
+void StorageManager::discardFile(const std::string& filename) {
+    buffer_pool->discardFile(filename);
+    page_counts.erase(path(filename).lexically_normal().string());
+    free_space_hints.erase(path(filename).lexically_normal().string());
+}
+
+int StorageManager::getNumPages(const std::string& filename) {
+    std::string key = path(filename).lexically_normal().string();
+    auto it = page_counts.find(key);
+    if (it != page_counts.end()) {
+        return it->second;
     }
+
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(filename, ec);
+    int num_pages = ec ? 0 : static_cast<int>(file_size / PAGE_SIZE_BYTES);
+    page_counts[key] = num_pages;
+    return num_pages;
 }
 
 bool StorageManager::insertRecord(const std::string& db_name, 
                                  const std::string& table_name, 
-                                 const Record& record) {
-    std::string file_path = "./data/" + db_name + "/" + table_name + ".dat";
-    
-    // Calculate record size
-    size_t record_size = sizeof(size_t);  // For the total record size
-    record_size += sizeof(size_t);        // For the number of values
+                                 const Record& record,
+                                 RID* rid) {
+    std::string file_path = getTablePath(db_name, table_name);
     
-    for (const auto& value : record.values) {
-        record_size += sizeof(size_t);    // For each string length
-        record_size += value.length();    // For string content
+    size_t record_size = record.getSize();
+    if (record_size > HeapPage::MAX_TUPLE_SIZE) {
+        std::cerr << "Record too large for a page: " << record_size << " bytes" << std::endl;
+        return false;
     }
-    
-    // Create a buffer for the record
+
     std::vector<char> buffer(record_size);
-    size_t pos = 0;
-    
-    // Write total record size (including this size field)
-    memcpy(buffer.data() + pos, &record_size, sizeof(size_t));
-    pos += sizeof(size_t);
-    
-    // Write number of values
-    size_t num_values = record.values.size();
-    memcpy(buffer.data() + pos, &num_values, sizeof(size_t));
-    pos += sizeof(size_t);
-    
-    // Write each value
-    for (const auto& value : record.values) {
-        // Write string length
-        size_t len = value.length();
-        memcpy(buffer.data() + pos, &len, sizeof(size_t));
-        pos += sizeof(size_t);
-        
-        // Write string content
-        memcpy(buffer.data() + pos, value.c_str(), len);
-        pos += len;
+    record.serialize(buffer.data());
+
+    // Try pages that rows were deleted from, then the last page of the
+    // file, and only then append a fresh one
+    int num_pages = getNumPages(file_path);
+    std::set<int>& hint = free_space_hints[path(file_path).lexically_normal().string()];
+    for (auto it = hint.begin(); it != hint.end();) {
+        int slot = *it < num_pages ? insertIntoPage(file_path, *it, buffer.data(), record_size) : -1;
+        if (slot != -1) {
+            if (rid) *rid = RID(*it, slot);
+            return true;
+        }
+        it = hint.erase(it);
     }
-    
-    // Open file for appending
-    std::ofstream file(file_path, std::ios::binary | std::ios::app);
-    if (!file) {
+    if (num_pages > 0) {
+        int slot = insertIntoPage(file_path, num_pages - 1, buffer.data(), record_size);
+        if (slot != -1) {
+            if (rid) *rid = RID(num_pages - 1, slot);
+            return true;
+        }
+    }
+
+    int page_id = num_pages;
+    Page* page = buffer_pool->newPage(file_path, page_id);
+    if (!page) {
         std::cerr << "Failed to open file for writing: " << file_path << std::endl;
         return false;
     }
-    
-    // Write the buffer to the file
-    file.write(buffer.data(), record_size);
-    
-    // Check for errors
-    if (!file) {
+
+    Page before = *page;
+    HeapPage heap_page(*page);
+    heap_page.init();
+    page->setLSN(before.getLSN());
+    int slot = heap_page.insertTuple(buffer.data(), record_size);
+    if (isLogging()) {
+        logPageChange(file_path, page_id, before.getData(), *page);
+    }
+    buffer_pool->unpinPage(file_path, page_id, true);
+    page_counts[path(file_path).lexically_normal().string()] = num_pages + 1;
+
+    if (slot == -1) {
         std::cerr << "Error writing to file: " << file_path << std::endl;
-        file.close();
         return false;
     }
-    
-    file.close();
-    std::cout << "Writing page 0 to " << file_path << std::endl;
+    if (rid) *rid = RID(page_id, slot);
     return true;
 }
 
+int StorageManager::insertIntoPage(const std::string& file_path, int page_id, const char* data, size_t size) {
+    Page* page = buffer_pool->fetchPage(file_path, page_id);
+    if (!page) {
+        return -1;
+    }
+
+    Page before = *page;
+    HeapPage heap_page(*page);
+    if (!heap_page.isInitialized()) {
+        heap_page.init();
+        page->setLSN(before.getLSN());
+    }
+    int slot = heap_page.insertTuple(data, size);
+    if (slot == -1) {
+        *page = before;
+    } else if (isLogging()) {
+        logPageChange(file_path, page_id, before.getData(), *page);
+    }
+    buffer_pool->unpinPage(file_path, page_id, slot != -1);
+    return slot;
+}
+
 std::vector<Record> StorageManager::getAllRecords(const std::string& file_path) {
     std::vector<Record> records;
     
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file) {
+    if (!exists(file_path)) {
         std::cerr << "Reading records from file: " << file_path << std::endl;
         std::cerr << "Total records read: 0" << std::endl;
         return records;
@@ -237,104 +472,81 @@ std::vector<Record> StorageManager::getAllRecords(const std::string& file_path)
     
     std::cout << "Reading records from file: " << file_path << std::endl;
     
-    // Get file size
-    file.seekg(0, std::ios::end);
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    if (file_size > 0) {
-        std::cout << "Reading page 0 with " << file_size << " bytes used" << std::endl;
-        
-        // Read the entire file into a buffer
-        std::vector<char> buffer(file_size);
-        file.read(buffer.data(), file_size);
-        
-        size_t pos = 0;
-        while (pos < file_size) {
-            // First, check if we have at least the size of a record
-            if (pos + sizeof(size_t) > file_size) break;
-            
-            // Read record size
-            size_t record_size;
-            memcpy(&record_size, buffer.data() + pos, sizeof(size_t));
-            
-            // Validate record size
-            if (record_size == 0 || pos + record_size > file_size) break;
-            
-            // Create a record
-            Record record;
-            record.values.clear();
-            
-            // Deserialize the record manually
-            size_t record_pos = pos + sizeof(size_t); // Skip the record size
-            
-            // Read number of values
-            size_t num_values;
-            memcpy(&num_values, buffer.data() + record_pos, sizeof(size_t));
-            record_pos += sizeof(size_t);
-            
-            // Read each value
-            for (size_t i = 0; i < num_values && record_pos < file_size; i++) {
-                // Read string length
-                size_t str_len;
-                if (record_pos + sizeof(size_t) > file_size) break;
-                memcpy(&str_len, buffer.data() + record_pos, sizeof(size_t));
-                record_pos += sizeof(size_t);
-                
-                // Read string content
-                if (record_pos + str_len > file_size) break;
-                std::string value(buffer.data() + record_pos, str_len);
-                record.values.push_back(value);
-                record_pos += str_len;
-            }
-            
-            // Add the record to our list if it has values
-            if (!record.values.empty()) {
-                records.push_back(record);
-            }
-            
-            // Move to the next record
-            pos += record_size;
+    int num_pages = getNumPages(file_path);
+    for (int page_id = 0; page_id < num_pages; page_id++) {
+        if (!getPageRecords(file_path, page_id, records)) {
+            std::cerr << "Failed to read page " << page_id << " of " << file_path << std::endl;
+            break;
         }
     }
     
-    file.close();
     std::cout << "Total records read: " << records.size() << std::endl;
     return records;
 }
 
+bool StorageManager::getPageRecords(const std::string& file_path, int page_id, std::vector<Record>& records,
+                                    const ScanProjection* projection) {
+    if (page_id < 0 || page_id >= getNumPages(file_path)) {
+        return false;
+    }
+
+    Page* page = buffer_pool->fetchPage(file_path, page_id);
+    if (!page) {
+        return false;
+    }
+
+    HeapPage heap_page(*page);
+    std::vector<size_t> offsets;
+    for (int slot = 0; slot < heap_page.getNumSlots(); slot++) {
+        const char* data;
+        size_t size;
+        Record record;
+        if (!heap_page.getTuple(slot, data, size)) {
+            continue;
+        }
+        if (projection ? !decodeProjected(data, size, *projection, record, offsets) : !record.deserialize(data, size)) {
+            continue;
+        }
+        record.rid = RID(page_id, slot);
+        records.push_back(std::move(record));
+    }
+    buffer_pool->unpinPage(file_path, page_id, false);
+    return true;
+}
+
 bool StorageManager::getRecord(const std::string& db_name, 
                                const std::string& table_name, 
-                               int key, Record& record) {
-    std::string file_path = "./data/" + db_name + "/" + table_name + ".dat";
-    std::cout << "Getting record with key " << key << " from " << file_path << std::endl;
-    
-    // Read all records
-    std::vector<Record> all_records = getAllRecords(file_path);
-    
-    // Try to find the record with the matching key
-    for (const auto& rec : all_records) {
-        if (!rec.values.empty()) {
-            try {
-                if (std::stoi(rec.values[0]) == key) {
-                    record = rec;
-                    std::cout << "Found record with key " << key << std::endl;
-                    return true;
-                }
-            } catch (...) {
-                // Skip if not a valid integer
-            }
-        }
+                               const RID& rid, Record& record) {
+    return getRecord(getTablePath(db_name, table_name), rid, record);
+}
+
+bool StorageManager::getRecord(const std::string& file_path, const RID& rid, Record& record) {
+    if (!rid.isValid() || rid.page_id >= getNumPages(file_path)) {
+        return false;
     }
-    
-    std::cout << "Record with key " << key << " not found" << std::endl;
-    return false;
+
+    Page* page = buffer_pool->fetchPage(file_path, rid.page_id);
+    if (!page) {
+        return false;
+    }
+
+    HeapPage heap_page(*page);
+    const char* data;
+    size_t size;
+    bool found = heap_page.getTuple(rid.slot, data, size) && record.deserialize(data, size);
+    buffer_pool->unpinPage(file_path, rid.page_id, false);
+
+    if (found) {
+        record.rid = rid;
+    }
+    return found;
 }
 
 bool StorageManager::writeAllRecords(const std::string& filename, 
                                    const std::vector<Record>& records) {
     try {
         // Create or truncate the file
+        discardFile(filename);
         std::ofstream file(filename, std::ios::binary | std::ios::trunc);
         if (!file) {
             std::cerr << "Failed to open file for writing: " << filename << std::endl;
@@ -342,48 +554,45 @@ bool StorageManager::writeAllRecords(const std::string& filename,
         }
         file.close();
 
-        // Write records page by page
+        // Pack records into slotted pages in order
         Page page;
-        size_t offset = 0;
-        size_t current_page = 0;
+        HeapPage heap_page(page);
+        heap_page.init();
+        int current_page = 0;
         
         for (const auto& record : records) {
             size_t record_size = record.getSize();
+            if (record_size > HeapPage::MAX_TUPLE_SIZE) {
+                std::cerr << "Record too large for a page: " << record_size << " bytes" << std::endl;
+                return false;
+            }
+
+            std::vector<char> buffer(record_size);
+            record.serialize(buffer.data());
             
             // If this record won't fit in current page, write current page and start new one
-            if (offset + sizeof(size_t) + record_size > PAGE_SIZE_BYTES) {
-                page.setFreeSpace(PAGE_SIZE_BYTES - offset);
+            if (heap_page.insertTuple(buffer.data(), record_size) == -1) {
                 if (!writePage(filename, current_page, page)) {
                     std::cerr << "Failed to write page " << current_page << std::endl;
                     return false;
                 }
                 
-                // Start new page
-                page.clear();
-                offset = 0;
+                heap_page.init();
                 current_page++;
+                heap_page.insertTuple(buffer.data(), record_size);
             }
-            
-            // Write record size
-            page.writeData(offset, &record_size, sizeof(size_t));
-            offset += sizeof(size_t);
-            
-            // Write record data
-            char buffer[PAGE_SIZE_BYTES];
-            record.serialize(buffer);
-            page.writeData(offset, buffer, record_size);
-            offset += record_size;
         }
 
         // Write final page if it contains any data
-        if (offset > 0) {
-            page.setFreeSpace(PAGE_SIZE_BYTES - offset);
+        if (heap_page.getNumSlots() > 0) {
             if (!writePage(filename, current_page, page)) {
                 std::cerr << "Failed to write final page" << std::endl;
                 return false;
             }
+            current_page++;
         }
 
+        page_counts[path(filename).lexically_normal().string()] = current_page;
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Error writing records: " << e.what() << std::endl;
@@ -391,75 +600,174 @@ bool StorageManager::writeAllRecords(const std::string& filename,
     }
 }
 
+bool StorageManager::upgradeLegacyTable(const std::string& filename,
+                                        const std::vector<ValueType>& column_types) {
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(filename, ec);
+    if (ec || file_size == 0 || file_size % PAGE_SIZE_BYTES == 0) {
+        return false;  // Missing, empty, or already made of heap pages
+    }
+
+    // Older builds appended [total size][num values]([length][bytes])* records
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<char> buffer(file_size);
+    file.read(buffer.data(), file_size);
+    file.close();
+
+    std::vector<Record> records;
+    size_t pos = 0;
+    while (pos + 2 * sizeof(size_t) <= file_size) {
+        size_t record_size;
+        memcpy(&record_size, buffer.data() + pos, sizeof(size_t));
+        if (record_size == 0 || pos + record_size > file_size) break;
+
+        size_t record_pos = pos + sizeof(size_t);
+        size_t num_values;
+        memcpy(&num_values, buffer.data() + record_pos, sizeof(size_t));
+        record_pos += sizeof(size_t);
+
+        Record record;
+        for (size_t i = 0; i < num_values && record_pos + sizeof(size_t) <= file_size; i++) {
+            size_t str_len;
+            memcpy(&str_len, buffer.data() + record_pos, sizeof(size_t));
+            record_pos += sizeof(size_t);
+            if (record_pos + str_len > file_size) break;
+            std::string text(buffer.data() + record_pos, str_len);
+            ValueType type = i < column_types.size() ? column_types[i] : ValueType::VARCHAR;
+            Value value;
+            if (!Value::parse(text, type, 0, value)) {
+                value = Value(text);  // Keep values the old format let through
+            }
+            record.values.push_back(value);
+            record_pos += str_len;
+        }
+
+        if (!record.values.empty()) {
+            records.push_back(record);
+        }
+        pos += record_size;
+    }
+
+    std::cout << "Converting " << filename << " to heap pages (" << records.size() << " records)" << std::endl;
+    return writeAllRecords(filename, records);
+}
+
 bool StorageManager::updateRecord(const std::string& db_name, const std::string& table_name, 
                                 const Record& old_record, const Record& new_record) {
-    std::string file_path = getTablePath(db_name, table_name);
-    std::vector<Record> records = getAllRecords(file_path);
-    
-    bool found = false;
-    for (auto& record : records) {
-        if (record == old_record) {
-            record = new_record;
-            found = true;
-            break;
+    RID rid = old_record.rid;
+    if (!rid.isValid()) {
+        // Fall back to locating the record by value
+        TableIterator it = scan(getTablePath(db_name, table_name));
+        Record record;
+        while (it.next(record)) {
+            if (record.values == old_record.values) {
+                rid = record.rid;
+                break;
+            }
         }
     }
-    
-    if (!found) {
+    return rid.isValid() && updateRecord(db_name, table_name, rid, new_record);
+}
+
+bool StorageManager::updateRecord(const std::string& db_name, const std::string& table_name,
+                                const RID& rid, const Record& new_record, RID* new_rid) {
+    std::string file_path = getTablePath(db_name, table_name);
+    if (!rid.isValid() || rid.page_id >= getNumPages(file_path)) {
         return false;
     }
-    
-    // Write updated records back to file
-    std::ofstream outFile(file_path, std::ios::binary);
-    if (!outFile) {
+
+    size_t record_size = new_record.getSize();
+    if (record_size > HeapPage::MAX_TUPLE_SIZE) {
+        std::cerr << "Record too large for a page: " << record_size << " bytes" << std::endl;
         return false;
     }
-    
-    for (const auto& record : records) {
-        size_t record_size = record.getSize();
-        std::vector<char> buffer(record_size);
-        record.serialize(buffer.data());
-        outFile.write(buffer.data(), record_size);
+    std::vector<char> buffer(record_size);
+    new_record.serialize(buffer.data());
+
+    Page* page = buffer_pool->fetchPage(file_path, rid.page_id);
+    if (!page) {
+        return false;
     }
-    
+
+    HeapPage heap_page(*page);
+    if (!heap_page.isLive(rid.slot)) {
+        buffer_pool->unpinPage(file_path, rid.page_id, false);
+        return false;
+    }
+
+    Page before = *page;
+    bool updated = heap_page.updateTuple(rid.slot, buffer.data(), record_size);
+    if (!updated) {
+        *page = before;  // updateTuple may have compacted the page
+    } else if (isLogging()) {
+        logPageChange(file_path, rid.page_id, before.getData(), *page);
+    }
+    buffer_pool->unpinPage(file_path, rid.page_id, updated);
+    if (updated) {
+        if (new_rid) *new_rid = rid;
+        return true;
+    }
+
+    // The grown record no longer fits on its page: move it elsewhere
+    RID moved;
+    if (!insertRecord(db_name, table_name, new_record, &moved)) {
+        return false;
+    }
+    if (!deleteRecord(db_name, table_name, rid)) {
+        return false;
+    }
+    if (new_rid) *new_rid = moved;
     return true;
 }
 
 bool StorageManager::deleteRecord(const std::string& db_name, const std::string& table_name, 
                                 const Record& record) {
+    RID rid = record.rid;
+    if (!rid.isValid()) {
+        TableIterator it = scan(getTablePath(db_name, table_name));
+        Record r;
+        while (it.next(r)) {
+            if (r.values == record.values) {
+                rid = r.rid;
+                break;
+            }
+        }
+    }
+    return rid.isValid() && deleteRecord(db_name, table_name, rid);
+}
+
+bool StorageManager::deleteRecord(const std::string& db_name, const std::string& table_name,
+                                const RID& rid) {
     std::string file_path = getTablePath(db_name, table_name);
-    std::vector<Record> records = getAllRecords(file_path);
-    
-    auto it = std::find_if(records.begin(), records.end(),
-        [&record](const Record& r) { return r.values == record.values; });
-    
-    if (it == records.end()) {
+    if (!rid.isValid() || rid.page_id >= getNumPages(file_path)) {
         return false;
     }
-    
-    records.erase(it);
-    
-    // Write remaining records back to file
-    std::ofstream outFile(file_path, std::ios::binary);
-    if (!outFile) {
+
+    Page* page = buffer_pool->fetchPage(file_path, rid.page_id);
+    if (!page) {
         return false;
     }
-    
-    for (const auto& r : records) {
-        size_t record_size = r.getSize();
-        std::vector<char> buffer(record_size);
-        r.serialize(buffer.data());
-        outFile.write(buffer.data(), record_size);
+
+    Page before = *page;
+    HeapPage heap_page(*page);
+    bool deleted = heap_page.deleteTuple(rid.slot);
+    if (deleted && isLogging()) {
+        logPageChange(file_path, rid.page_id, before.getData(), *page);
     }
-    
-    return true;
+    buffer_pool->unpinPage(file_path, rid.page_id, deleted);
+    if (deleted) {
+        free_space_hints[path(file_path).lexically_normal().string()].insert(rid.page_id);
+    }
+    return deleted;
 }
 
 std::vector<Record> StorageManager::selectRecords(const std::string& db_name, 
                                                 const std::string& table_name, 
                                                 const std::string& condition) {
     std::string file_path = getTablePath(db_name, table_name);
-    std::vector<Record> all_records = getAllRecords(file_path);
     std::vector<Record> result;
     
     // Parse condition
@@ -469,19 +777,19 @@ std::vector<Record> StorageManager::selectRecords(const std::string& db_name,
     std::getline(iss, value);
     value = value.substr(value.find_first_not_of(" \t"));
     
-    // Remove quotes if present
-    if (!value.empty() && (value[0] == '\'' || value[0] == '"')) {
-        value = value.substr(1, value.length() - 2);
-    }
+    Value search_value = Value::fromLiteral(value);
     
-    // Find column index
+    // Find column index from the first record
+    TableIterator it = scan(file_path);
+    Record record;
+    if (!it.next(record)) {
+        return result;
+    }
     int col_index = -1;
-    if (!all_records.empty()) {
-        for (size_t i = 0; i < all_records[0].values.size(); i++) {
-            if (all_records[0].values[i] == column) {
-                col_index = i;
-                break;
-            }
+    for (size_t i = 0; i < record.values.size(); i++) {
+        if (record.values[i].toString() == column) {
+            col_index = i;
+            break;
         }
     }
     
@@ -490,9 +798,10 @@ std::vector<Record> StorageManager::selectRecords(const std::string& db_name,
     }
     
     // Filter records based on condition
-    for (const auto& record : all_records) {
+    it.reset();
+    while (it.next(record)) {
         if (col_index < static_cast<int>(record.values.size())) {
-            if (compareValues(record.values[col_index], value, op)) {
+            if (compareValues(record.values[col_index], search_value, op)) {
                 result.push_back(record);
             }
         }
@@ -502,30 +811,8 @@ std::vector<Record> StorageManager::selectRecords(const std::string& db_name,
 }
 
 // Helper function for comparing values
-bool StorageManager::compareValues(const std::string& record_value, 
-                                 const std::string& search_value, 
+bool StorageManager::compareValues(const Value& record_value, 
+                                 const Value& search_value, 
                                  const std::string& op) {
-    try {
-        // Try numeric comparison first
-        double record_num = std::stod(record_value);
-        double search_num = std::stod(search_value);
-        
-        if (op == "=") return record_num == search_num;
-        if (op == ">") return record_num > search_num;
-        if (op == "<") return record_num < search_num;
-        if (op == ">=") return record_num >= search_num;
-        if (op == "<=") return record_num <= search_num;
-        if (op == "!=") return record_num != search_num;
-    }
-    catch (...) {
-        // Fall back to string comparison
-        if (op == "=") return record_value == search_value;
-        if (op == ">") return record_value > search_value;
-        if (op == "<") return record_value < search_value;
-        if (op == ">=") return record_value >= search_value;
-        if (op == "<=") return record_value <= search_value;
-        if (op == "!=") return record_value != search_value;
-    }
-    
-    return false;
+    return record_value.compare(op, search_value);
 }
@@ -4,9 +4,12 @@
 #include <chrono>
 #include <queue>
 #include <set>
+#include <iostream>
 
-TransactionManager::TransactionManager(StorageManager* sm, CatalogManager* cm, IndexManager* im)
-    : storage_manager(sm), catalog_manager(cm), index_manager(im), next_transaction_id(1) {}
+TransactionManager::TransactionManager(StorageManager* sm, CatalogManager* cm, IndexManager* im,
+                                       LogManager* lm)
+    : storage_manager(sm), catalog_manager(cm), index_manager(im), log_manager(lm),
+      next_transaction_id(1) {}
 
 TransactionManager::~TransactionManager() {
     // Clean up any remaining transactions
@@ -15,13 +18,43 @@ TransactionManager::~TransactionManager() {
 }
 
 int TransactionManager::beginTransaction() {
-    std::lock_guard<std::mutex> lock(transaction_mutex);
-    int transaction_id = next_transaction_id++;
-    transactions[transaction_id] = std::make_unique<Transaction>(transaction_id);
+    int transaction_id;
+    {
+        std::lock_guard<std::mutex> lock(transaction_mutex);
+        transaction_id = next_transaction_id++;
+        transactions[transaction_id] = std::make_unique<Transaction>(transaction_id);
+    }
+
+    if (log_manager) {
+        LogRecord record;
+        record.type = LogRecordType::BEGIN;
+        record.transaction_id = transaction_id;
+        log_manager->appendLogRecord(record);
+    }
+    StorageManager::setCurrentTransaction(transaction_id);
     return transaction_id;
 }
 
 bool TransactionManager::commitTransaction(int transaction_id) {
+    {
+        std::lock_guard<std::mutex> lock(transaction_mutex);
+        if (transactions.find(transaction_id) == transactions.end()) {
+            return false;
+        }
+    }
+
+    // The transaction is durable once its COMMIT record is on disk. The
+    // mutex is not held while waiting so concurrent commits share a sync.
+    if (log_manager) {
+        LogRecord record;
+        record.type = LogRecordType::COMMIT;
+        record.transaction_id = transaction_id;
+        if (!log_manager->flush(log_manager->appendLogRecord(record))) {
+            std::cerr << "Failed to write commit record for transaction " << transaction_id << std::endl;
+            return false;
+        }
+    }
+
     std::lock_guard<std::mutex> lock(transaction_mutex);
     auto it = transactions.find(transaction_id);
     if (it == transactions.end()) {
@@ -36,10 +69,22 @@ bool TransactionManager::commitTransaction(int transaction_id) {
     
     // Remove the transaction
     transactions.erase(it);
+    if (StorageManager::getCurrentTransaction() == transaction_id) {
+        StorageManager::setCurrentTransaction(-1);
+    }
     return true;
 }
 
 bool TransactionManager::abortTransaction(int transaction_id) {
+    {
+        std::lock_guard<std::mutex> lock(transaction_mutex);
+        if (transactions.find(transaction_id) == transactions.end()) {
+            return false;
+        }
+    }
+
+    bool undone = rollback(transaction_id);
+
     std::lock_guard<std::mutex> lock(transaction_mutex);
     auto it = transactions.find(transaction_id);
     if (it == transactions.end()) {
@@ -54,7 +99,44 @@ bool TransactionManager::abortTransaction(int transaction_id) {
     
     // Remove the transaction
     transactions.erase(it);
-    return true;
+    if (StorageManager::getCurrentTransaction() == transaction_id) {
+        StorageManager::setCurrentTransaction(-1);
+    }
+    return undone;
+}
+
+bool TransactionManager::rollback(int transaction_id) {
+    if (!log_manager) {
+        return true;
+    }
+
+    // Walk the transaction's log chain backwards restoring before images.
+    // Each undo is itself logged as a CLR pointing past the undone record.
+    bool success = true;
+    lsn_t lsn = log_manager->getLastLSN(transaction_id);
+    while (lsn != INVALID_LSN) {
+        LogRecord record;
+        if (!log_manager->readLogRecord(lsn, record)) {
+            std::cerr << "Failed to read log record at " << lsn << std::endl;
+            success = false;
+            break;
+        }
+
+        if (record.type == LogRecordType::UPDATE) {
+            success = storage_manager->undoLogRecord(record) && success;
+            lsn = record.prev_lsn;
+        } else if (record.type == LogRecordType::CLR) {
+            lsn = record.undo_next_lsn;
+        } else {
+            lsn = record.prev_lsn;
+        }
+    }
+
+    LogRecord abort_record;
+    abort_record.type = LogRecordType::ABORT;
+    abort_record.transaction_id = transaction_id;
+    log_manager->appendLogRecord(abort_record);
+    return success;
 }
 
 bool TransactionManager::acquireLock(int transaction_id, const std::string& resource, LockMode mode) {
@@ -0,0 +1,400 @@
+#include "value.h"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+namespace {
+    std::string trim(const std::string& text) {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) {
+            return "";
+        }
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(start, end - start + 1);
+    }
+
+    bool isQuoted(const std::string& text) {
+        return text.length() >= 2 && (text.front() == '\'' || text.front() == '"') &&
+               text.back() == text.front();
+    }
+
+    bool parseInt(const std::string& text, int32_t& value) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        errno = 0;
+        long long parsed = std::strtoll(text.c_str(), &end, 10);
+        if (errno != 0 || *end != '\0' || parsed < INT32_MIN || parsed > INT32_MAX) {
+            return false;
+        }
+        value = static_cast<int32_t>(parsed);
+        return true;
+    }
+
+    bool parseDouble(const std::string& text, double& value) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        errno = 0;
+        double parsed = std::strtod(text.c_str(), &end);
+        if (errno != 0 || *end != '\0' || !std::isfinite(parsed)) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    bool isNullLiteral(const std::string& text) {
+        std::string upper = text;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        return upper == "NULL";
+    }
+
+    int kindRank(const Value& value) {
+        if (value.isNull()) return 0;
+        return value.isNumeric() ? 1 : 2;
+    }
+}
+
+ValueType Value::typeFromName(const std::string& type_name, int* max_length) {
+    std::string upper = trim(type_name);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+    int length = 0;
+    size_t paren = upper.find('(');
+    if (paren != std::string::npos) {
+        length = std::atoi(upper.c_str() + paren + 1);
+        upper = trim(upper.substr(0, paren));
+    }
+    if (max_length) {
+        *max_length = length;
+    }
+
+    if (upper == "INT" || upper == "INTEGER" || upper == "SMALLINT" || upper == "BIGINT") {
+        return ValueType::INT;
+    }
+    if (upper == "DOUBLE" || upper == "FLOAT" || upper == "REAL" ||
+        upper == "DECIMAL" || upper == "NUMERIC") {
+        return ValueType::DOUBLE;
+    }
+    if (upper == "CHAR" || upper == "CHARACTER") {
+        return ValueType::CHAR;
+    }
+    return ValueType::VARCHAR;  // VARCHAR, TEXT and anything unrecognised
+}
+
+const char* Value::typeName(ValueType type) {
+    switch (type) {
+    case ValueType::NULL_VALUE: return "NULL";
+    case ValueType::INT: return "INT";
+    case ValueType::DOUBLE: return "DOUBLE";
+    case ValueType::VARCHAR: return "VARCHAR";
+    case ValueType::CHAR: return "CHAR";
+    }
+    return "UNKNOWN";
+}
+
+bool Value::parse(const std::string& text, ValueType type, int max_length,
+                  Value& value, std::string* error) {
+    std::string literal = trim(text);
+    if (isNullLiteral(literal)) {
+        value = Value();
+        return true;
+    }
+    if (isQuoted(literal)) {
+        literal = literal.substr(1, literal.length() - 2);
+    }
+
+    switch (type) {
+    case ValueType::INT: {
+        int32_t parsed;
+        if (!parseInt(literal, parsed)) {
+            if (error) *error = "Invalid INT value: " + trim(text);
+            return false;
+        }
+        value = Value(parsed);
+        return true;
+    }
+    case ValueType::DOUBLE: {
+        double parsed;
+        if (!parseDouble(literal, parsed)) {
+            if (error) *error = "Invalid DOUBLE value: " + trim(text);
+            return false;
+        }
+        value = Value(parsed);
+        return true;
+    }
+    case ValueType::CHAR:
+        // CHAR(n) is blank padded; the padding is not stored
+        literal.erase(literal.find_last_not_of(' ') + 1);
+        [[fallthrough]];
+    case ValueType::VARCHAR:
+        if (max_length > 0 && literal.length() > static_cast<size_t>(max_length)) {
+            if (error) {
+                *error = "Value too long for " + std::string(typeName(type)) + "(" +
+                         std::to_string(max_length) + "): " + trim(text);
+            }
+            return false;
+        }
+        if (literal.length() > UINT16_MAX) {
+            if (error) *error = "Value too long: " + std::to_string(literal.length()) + " bytes";
+            return false;
+        }
+        value = Value(literal, type);
+        return true;
+    case ValueType::NULL_VALUE:
+        break;
+    }
+    if (error) *error = "Cannot convert value: " + trim(text);
+    return false;
+}
+
+bool Value::castTo(ValueType target, int max_length, Value& value, std::string* error) const {
+    if (isNull() || (isNumeric() && target == type)) {
+        value = *this;
+        return true;
+    }
+
+    switch (target) {
+    case ValueType::INT:
+        if (type == ValueType::DOUBLE) {
+            if (double_value != std::floor(double_value) ||
+                double_value < INT32_MIN || double_value > INT32_MAX) {
+                if (error) *error = "Invalid INT value: " + toString();
+                return false;
+            }
+            value = Value(static_cast<int32_t>(double_value));
+            return true;
+        }
+        break;
+    case ValueType::DOUBLE:
+        if (type == ValueType::INT) {
+            value = Value(static_cast<double>(int_value));
+            return true;
+        }
+        break;
+    case ValueType::VARCHAR:
+    case ValueType::CHAR:
+        break;
+    case ValueType::NULL_VALUE:
+        if (error) *error = "Cannot convert value: " + toString();
+        return false;
+    }
+
+    // Strings and numbers convert through their text
+    std::string text = toString();
+    if (target == ValueType::INT || target == ValueType::DOUBLE) {
+        return parse(text, target, max_length, value, error);
+    }
+    return parse("'" + text + "'", target, max_length, value, error);
+}
+
+Value Value::fromLiteral(const std::string& text) {
+    std::string literal = trim(text);
+    if (isQuoted(literal)) {
+        return Value(literal.substr(1, literal.length() - 2));
+    }
+    if (isNullLiteral(literal)) {
+        return Value();
+    }
+    int32_t int_value;
+    if (parseInt(literal, int_value)) {
+        return Value(int_value);
+    }
+    double double_value;
+    if (parseDouble(literal, double_value)) {
+        return Value(double_value);
+    }
+    return Value(literal);
+}
+
+int32_t Value::asInt() const {
+    switch (type) {
+    case ValueType::INT: return int_value;
+    case ValueType::DOUBLE: return static_cast<int32_t>(double_value);
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: return std::atoi(string_value.c_str());
+    case ValueType::NULL_VALUE: break;
+    }
+    return 0;
+}
+
+double Value::asDouble() const {
+    switch (type) {
+    case ValueType::INT: return int_value;
+    case ValueType::DOUBLE: return double_value;
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: return std::atof(string_value.c_str());
+    case ValueType::NULL_VALUE: break;
+    }
+    return 0;
+}
+
+std::string Value::toString() const {
+    switch (type) {
+    case ValueType::INT:
+        return std::to_string(int_value);
+    case ValueType::DOUBLE: {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", double_value);
+        return buffer;
+    }
+    case ValueType::VARCHAR:
+    case ValueType::CHAR:
+        return string_value;
+    case ValueType::NULL_VALUE:
+        break;
+    }
+    return "NULL";
+}
+
+int Value::compare(const Value& other) const {
+    int rank = kindRank(*this);
+    int other_rank = kindRank(other);
+    if (rank != other_rank) {
+        return rank < other_rank ? -1 : 1;
+    }
+
+    if (isNull()) {
+        return 0;
+    }
+    if (isNumeric()) {
+        if (type == ValueType::INT && other.type == ValueType::INT) {
+            return (int_value > other.int_value) - (int_value < other.int_value);
+        }
+        double a = asDouble();
+        double b = other.asDouble();
+        return (a > b) - (a < b);
+    }
+    int result = string_value.compare(other.string_value);
+    return (result > 0) - (result < 0);
+}
+
+bool Value::compare(const std::string& op, const Value& other) const {
+    int result = compare(other);
+    if (op == "=") return result == 0;
+    if (op == "!=" || op == "<>") return result != 0;
+    if (op == "<") return result < 0;
+    if (op == ">") return result > 0;
+    if (op == "<=") return result <= 0;
+    if (op == ">=") return result >= 0;
+    return false;
+}
+
+size_t Value::hash() const {
+    if (isNull()) {
+        return 0;
+    }
+    if (isNumeric()) {
+        return std::hash<double>()(asDouble());
+    }
+    return std::hash<std::string>()(string_value);
+}
+
+size_t Value::getSerializedSize() const {
+    size_t size = sizeof(uint8_t);
+    switch (type) {
+    case ValueType::INT: size += sizeof(int32_t); break;
+    case ValueType::DOUBLE: size += sizeof(double); break;
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: size += sizeof(uint16_t) + string_value.length(); break;
+    case ValueType::NULL_VALUE: break;
+    }
+    return size;
+}
+
+size_t Value::serialize(char* buffer) const {
+    size_t pos = 0;
+    buffer[pos++] = static_cast<char>(type);
+    switch (type) {
+    case ValueType::INT:
+        memcpy(buffer + pos, &int_value, sizeof(int32_t));
+        pos += sizeof(int32_t);
+        break;
+    case ValueType::DOUBLE:
+        memcpy(buffer + pos, &double_value, sizeof(double));
+        pos += sizeof(double);
+        break;
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: {
+        uint16_t length = static_cast<uint16_t>(string_value.length());
+        memcpy(buffer + pos, &length, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        memcpy(buffer + pos, string_value.data(), length);
+        pos += length;
+        break;
+    }
+    case ValueType::NULL_VALUE:
+        break;
+    }
+    return pos;
+}
+
+size_t Value::deserialize(const char* buffer, size_t buffer_size) {
+    if (buffer_size < sizeof(uint8_t)) {
+        return 0;
+    }
+    size_t pos = 0;
+    uint8_t tag = static_cast<uint8_t>(buffer[pos++]);
+    string_value.clear();
+    int_value = 0;
+
+    switch (static_cast<ValueType>(tag)) {
+    case ValueType::NULL_VALUE:
+        type = ValueType::NULL_VALUE;
+        return pos;
+    case ValueType::INT:
+        if (pos + sizeof(int32_t) > buffer_size) return 0;
+        type = ValueType::INT;
+        memcpy(&int_value, buffer + pos, sizeof(int32_t));
+        return pos + sizeof(int32_t);
+    case ValueType::DOUBLE:
+        if (pos + sizeof(double) > buffer_size) return 0;
+        type = ValueType::DOUBLE;
+        memcpy(&double_value, buffer + pos, sizeof(double));
+        return pos + sizeof(double);
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: {
+        if (pos + sizeof(uint16_t) > buffer_size) return 0;
+        uint16_t length;
+        memcpy(&length, buffer + pos, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        if (pos + length > buffer_size) return 0;
+        type = static_cast<ValueType>(tag);
+        string_value.assign(buffer + pos, length);
+        return pos + length;
+    }
+    }
+    return 0;  // Unknown type tag
+}
+
+size_t Value::skip(const char* buffer, size_t buffer_size) {
+    if (buffer_size < sizeof(uint8_t)) {
+        return 0;
+    }
+    size_t pos = sizeof(uint8_t);
+    size_t length = 0;
+    switch (static_cast<ValueType>(buffer[0])) {
+    case ValueType::NULL_VALUE: break;
+    case ValueType::INT: length = sizeof(int32_t); break;
+    case ValueType::DOUBLE: length = sizeof(double); break;
+    case ValueType::VARCHAR:
+    case ValueType::CHAR: {
+        if (pos + sizeof(uint16_t) > buffer_size) return 0;
+        uint16_t string_length;
+        memcpy(&string_length, buffer + pos, sizeof(uint16_t));
+        pos += sizeof(uint16_t);
+        length = string_length;
+        break;
+    }
+    default:
+        return 0;  // Unknown type tag
+    }
+    return pos + length <= buffer_size ? pos + length : 0;
+}
+
+std::ostream& operator<<(std::ostream& os, const Value& value) {
+    return os << value.toString();
+}
@@ -0,0 +1,528 @@
+#include "vectorized.h"
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+namespace {
+    enum class CompareOp { EQ, NE, LT, GT, LE, GE };
+
+    bool toCompareOp(const std::string& op, CompareOp& result) {
+        if (op == "=") result = CompareOp::EQ;
+        else if (op == "!=" || op == "<>") result = CompareOp::NE;
+        else if (op == "<") result = CompareOp::LT;
+        else if (op == ">") result = CompareOp::GT;
+        else if (op == "<=") result = CompareOp::LE;
+        else if (op == ">=") result = CompareOp::GE;
+        else return false;
+        return true;
+    }
+
+    // a op b == b flip(op) a
+    CompareOp flip(CompareOp op) {
+        switch (op) {
+        case CompareOp::LT: return CompareOp::GT;
+        case CompareOp::GT: return CompareOp::LT;
+        case CompareOp::LE: return CompareOp::GE;
+        case CompareOp::GE: return CompareOp::LE;
+        default: return op;
+        }
+    }
+
+    // Calls kernel with the comparator for op, so each loop is instantiated
+    // with a fixed comparison and no branch inside it
+    template <typename Kernel>
+    void dispatch(CompareOp op, Kernel&& kernel) {
+        switch (op) {
+        case CompareOp::EQ: kernel(std::equal_to<>()); break;
+        case CompareOp::NE: kernel(std::not_equal_to<>()); break;
+        case CompareOp::LT: kernel(std::less<>()); break;
+        case CompareOp::GT: kernel(std::greater<>()); break;
+        case CompareOp::LE: kernel(std::less_equal<>()); break;
+        case CompareOp::GE: kernel(std::greater_equal<>()); break;
+        }
+    }
+
+    bool isNumericType(ValueType type) {
+        return type == ValueType::INT || type == ValueType::DOUBLE;
+    }
+
+    bool isStringType(ValueType type) {
+        return type == ValueType::VARCHAR || type == ValueType::CHAR;
+    }
+
+    template <typename T, typename C, typename Cmp>
+    void compareConstant(const T* data, const uint8_t* nulls, C constant, size_t n, uint8_t* mask, Cmp cmp) {
+        for (size_t i = 0; i < n; i++) {
+            mask[i] = static_cast<uint8_t>(cmp(static_cast<C>(data[i]), constant) & (nulls[i] ^ 1));
+        }
+    }
+
+    template <typename A, typename B, typename C, typename Cmp>
+    void compareArrays(const A* left, const uint8_t* left_nulls, const B* right, const uint8_t* right_nulls,
+                       size_t n, uint8_t* mask, Cmp cmp) {
+        for (size_t i = 0; i < n; i++) {
+            mask[i] = static_cast<uint8_t>(cmp(static_cast<C>(left[i]), static_cast<C>(right[i])) &
+                                           ((left_nulls[i] | right_nulls[i]) ^ 1));
+        }
+    }
+
+    // column op literal
+    class ConstantComparison : public BatchPredicate {
+    public:
+        ConstantComparison(int column, CompareOp op, const Value& constant)
+            : column(column), op(op), constant(constant) {}
+
+        void evaluate(const RowBatch& batch, uint8_t* mask) const override {
+            const ColumnVector& col = batch.columns[column];
+            const uint8_t* nulls = col.nulls.data();
+            size_t n = batch.size;
+
+            if (col.type == ValueType::INT && constant.getType() == ValueType::INT) {
+                int32_t value = constant.asInt();
+                dispatch(op, [&](auto cmp) { compareConstant(col.ints.data(), nulls, value, n, mask, cmp); });
+            } else if (col.type == ValueType::INT) {
+                double value = constant.asDouble();
+                dispatch(op, [&](auto cmp) { compareConstant(col.ints.data(), nulls, value, n, mask, cmp); });
+            } else if (col.type == ValueType::DOUBLE) {
+                double value = constant.asDouble();
+                dispatch(op, [&](auto cmp) { compareConstant(col.doubles.data(), nulls, value, n, mask, cmp); });
+            } else {
+                const std::string& value = constant.asString();
+                dispatch(op, [&](auto cmp) {
+                    for (size_t i = 0; i < n; i++) {
+                        mask[i] = static_cast<uint8_t>(!nulls[i] && cmp(col.strings[i].compare(value), 0));
+                    }
+                });
+            }
+        }
+
+        void collectColumns(std::vector<bool>& mask) const override { mask[column] = true; }
+
+    private:
+        int column;
+        CompareOp op;
+        Value constant;
+    };
+
+    // column op column
+    class ColumnComparison : public BatchPredicate {
+    public:
+        ColumnComparison(int left, CompareOp op, int right) : left(left), op(op), right(right) {}
+
+        void evaluate(const RowBatch& batch, uint8_t* mask) const override {
+            const ColumnVector& a = batch.columns[left];
+            const ColumnVector& b = batch.columns[right];
+            size_t n = batch.size;
+
+            if (a.type == ValueType::INT && b.type == ValueType::INT) {
+                dispatch(op, [&](auto cmp) {
+                    compareArrays<int32_t, int32_t, int32_t>(a.ints.data(), a.nulls.data(), b.ints.data(),
+                                                             b.nulls.data(), n, mask, cmp);
+                });
+            } else if (a.type == ValueType::INT) {
+                dispatch(op, [&](auto cmp) {
+                    compareArrays<int32_t, double, double>(a.ints.data(), a.nulls.data(), b.doubles.data(),
+                                                           b.nulls.data(), n, mask, cmp);
+                });
+            } else if (b.type == ValueType::INT) {
+                dispatch(op, [&](auto cmp) {
+                    compareArrays<double, int32_t, double>(a.doubles.data(), a.nulls.data(), b.ints.data(),
+                                                           b.nulls.data(), n, mask, cmp);
+                });
+            } else if (a.type == ValueType::DOUBLE) {
+                dispatch(op, [&](auto cmp) {
+                    compareArrays<double, double, double>(a.doubles.data(), a.nulls.data(), b.doubles.data(),
+                                                          b.nulls.data(), n, mask, cmp);
+                });
+            } else {
+                dispatch(op, [&](auto cmp) {
+                    for (size_t i = 0; i < n; i++) {
+                        mask[i] = static_cast<uint8_t>(!a.nulls[i] && !b.nulls[i] &&
+                                                       cmp(a.strings[i].compare(b.strings[i]), 0));
+                    }
+                });
+            }
+        }
+
+        void collectColumns(std::vector<bool>& mask) const override {
+            mask[left] = true;
+            mask[right] = true;
+        }
+
+    private:
+        int left;
+        CompareOp op;
+        int right;
+    };
+
+    class LogicalPredicate : public BatchPredicate {
+    public:
+        LogicalPredicate(bool is_and, std::unique_ptr<BatchPredicate> left, std::unique_ptr<BatchPredicate> right)
+            : is_and(is_and), left(std::move(left)), right(std::move(right)) {}
+
+        void evaluate(const RowBatch& batch, uint8_t* mask) const override {
+            std::vector<uint8_t> other(batch.size);
+            left->evaluate(batch, mask);
+            right->evaluate(batch, other.data());
+            if (is_and) {
+                for (size_t i = 0; i < batch.size; i++) mask[i] &= other[i];
+            } else {
+                for (size_t i = 0; i < batch.size; i++) mask[i] |= other[i];
+            }
+        }
+
+        void collectColumns(std::vector<bool>& mask) const override {
+            left->collectColumns(mask);
+            right->collectColumns(mask);
+        }
+
+    private:
+        bool is_and;
+        std::unique_ptr<BatchPredicate> left;
+        std::unique_ptr<BatchPredicate> right;
+    };
+
+    class NotPredicate : public BatchPredicate {
+    public:
+        explicit NotPredicate(std::unique_ptr<BatchPredicate> child) : child(std::move(child)) {}
+
+        void evaluate(const RowBatch& batch, uint8_t* mask) const override {
+            child->evaluate(batch, mask);
+            for (size_t i = 0; i < batch.size; i++) mask[i] ^= 1;
+        }
+
+        void collectColumns(std::vector<bool>& mask) const override { child->collectColumns(mask); }
+
+    private:
+        std::unique_ptr<BatchPredicate> child;
+    };
+
+    // Running sums of one numeric column; folded into an Accumulator once
+    // per batch
+    template <typename T, typename Sum>
+    struct NumericFold {
+        Sum sum = 0;
+        int64_t count = 0;
+        T min = std::numeric_limits<T>::max();
+        T max = std::numeric_limits<T>::lowest();
+
+        // index(i) maps the i-th visited row to its position in the batch
+        template <typename Index>
+        void run(const T* data, const uint8_t* nulls, size_t n, Index index) {
+            for (size_t i = 0; i < n; i++) {
+                size_t row = index(i);
+                bool valid = !nulls[row];
+                T value = data[row];
+                sum += valid ? value : 0;
+                count += valid;
+                min = std::min(min, valid ? value : std::numeric_limits<T>::max());
+                max = std::max(max, valid ? value : std::numeric_limits<T>::lowest());
+            }
+        }
+
+        void mergeInto(Accumulator& accumulator) const {
+            if (count == 0) return;
+            accumulator.count += count;
+            accumulator.numeric += count;
+            if (std::is_floating_point<Sum>::value) {
+                accumulator.sum = static_cast<double>(sum);  // continued from accumulator.sum
+            } else {
+                accumulator.sum += static_cast<double>(sum);
+            }
+            Value low(min), high(max);
+            if (accumulator.min.isNull() || low < accumulator.min) accumulator.min = low;
+            if (accumulator.max.isNull() || high > accumulator.max) accumulator.max = high;
+        }
+    };
+
+    template <typename T, typename Sum>
+    void foldColumn(const RowBatch& batch, const std::vector<T>& data, const uint8_t* nulls,
+                    Accumulator& accumulator) {
+        NumericFold<T, Sum> fold;
+        // Doubles keep adding onto the running total so the result does not
+        // depend on where batches start
+        if (std::is_floating_point<Sum>::value) fold.sum = static_cast<Sum>(accumulator.sum);
+        if (batch.selected == batch.size) {
+            fold.run(data.data(), nulls, batch.size, [](size_t i) { return i; });
+        } else {
+            const uint32_t* selection = batch.selection.data();
+            fold.run(data.data(), nulls, batch.selected, [selection](size_t i) { return selection[i]; });
+        }
+        fold.mergeInto(accumulator);
+    }
+
+    // Folds the selected rows of one column into an aggregate
+    void accumulateBatch(const RowBatch& batch, int column, Accumulator& accumulator) {
+        if (column < 0) {
+            accumulator.count += batch.selected;  // COUNT(*)
+            return;
+        }
+        const ColumnVector& col = batch.columns[column];
+        if (col.type == ValueType::INT) {
+            foldColumn<int32_t, int64_t>(batch, col.ints, col.nulls.data(), accumulator);
+        } else if (col.type == ValueType::DOUBLE) {
+            size_t numeric = accumulator.numeric;
+            foldColumn<double, double>(batch, col.doubles, col.nulls.data(), accumulator);
+            accumulator.all_int = accumulator.all_int && accumulator.numeric == numeric;
+        } else {
+            for (size_t i = 0; i < batch.selected; i++) {
+                accumulator.add(col.get(batch.selection[i]));
+            }
+        }
+    }
+}
+
+Value ColumnVector::get(size_t row) const {
+    if (nulls[row]) return Value();
+    switch (type) {
+    case ValueType::INT: return Value(ints[row]);
+    case ValueType::DOUBLE: return Value(doubles[row]);
+    default: return Value(strings[row], type);
+    }
+}
+
+BatchScanner::BatchScanner(StorageManager* storage_manager, const std::string& data_file,
+                           const std::vector<ValueType>& types, const std::vector<bool>& mask)
+    : iterator(storage_manager, data_file), types(types), mask(mask) {
+    // Columns outside the mask are stepped over in the page bytes
+    ScanProjection projection;
+    projection.columns = mask;
+    iterator.setProjection(std::move(projection));
+}
+
+bool BatchScanner::next(RowBatch& batch) {
+    batch.columns.resize(types.size());
+    for (size_t c = 0; c < types.size(); c++) {
+        ColumnVector& col = batch.columns[c];
+        col.type = types[c];
+        col.loaded = mask[c];
+        col.ints.clear();
+        col.doubles.clear();
+        col.strings.clear();
+        col.nulls.clear();
+    }
+
+    // Values are stored under the column's declared type; inserts and
+    // updates cast to it, so a mismatch only comes from damaged rows and
+    // is read as NULL
+    batch.size = 0;
+    while (batch.size < BATCH_SIZE && iterator.next(record)) {
+        for (size_t c = 0; c < types.size(); c++) {
+            ColumnVector& col = batch.columns[c];
+            if (!col.loaded) continue;
+            static const Value null_value;
+            const Value& value = c < record.values.size() ? record.values[c] : null_value;
+            if (col.type == ValueType::INT) {
+                col.ints.push_back(value.isNumeric() ? value.asInt() : 0);
+                col.nulls.push_back(!value.isNumeric());
+            } else if (col.type == ValueType::DOUBLE) {
+                col.doubles.push_back(value.isNumeric() ? value.asDouble() : 0);
+                col.nulls.push_back(!value.isNumeric());
+            } else {
+                col.strings.push_back(value.isString() ? value.asString() : std::string());
+                col.nulls.push_back(!value.isString());
+            }
+        }
+        batch.size++;
+    }
+
+    batch.selection.resize(BATCH_SIZE);
+    for (size_t i = 0; i < batch.size; i++) {
+        batch.selection[i] = static_cast<uint32_t>(i);
+    }
+    batch.selected = batch.size;
+    return batch.size > 0;
+}
+
+std::unique_ptr<BatchPredicate> BatchPredicate::compile(const Expression* expression,
+                                                        const std::vector<ValueType>& types) {
+    if (expression->column_index >= 0) {
+        return nullptr;  // a bare column used as a condition
+    }
+
+    switch (expression->type) {
+    case ExpressionType::AND:
+    case ExpressionType::OR: {
+        auto left = compile(expression->children[0].get(), types);
+        auto right = compile(expression->children[1].get(), types);
+        if (!left || !right) return nullptr;
+        return std::make_unique<LogicalPredicate>(expression->type == ExpressionType::AND,
+                                                  std::move(left), std::move(right));
+    }
+    case ExpressionType::NOT: {
+        auto child = compile(expression->children[0].get(), types);
+        if (!child) return nullptr;
+        return std::make_unique<NotPredicate>(std::move(child));
+    }
+    case ExpressionType::COMPARISON:
+        break;
+    default:
+        return nullptr;
+    }
+
+    CompareOp op;
+    if (!toCompareOp(expression->op, op)) return nullptr;
+    const Expression* left = expression->children[0].get();
+    const Expression* right = expression->children[1].get();
+
+    if (left->type == ExpressionType::COLUMN && right->type == ExpressionType::COLUMN) {
+        ValueType a = types[left->column_index], b = types[right->column_index];
+        if ((isNumericType(a) && isNumericType(b)) || (isStringType(a) && isStringType(b))) {
+            return std::make_unique<ColumnComparison>(left->column_index, op, right->column_index);
+        }
+        return nullptr;
+    }
+
+    if (left->type == ExpressionType::LITERAL && right->type == ExpressionType::COLUMN) {
+        std::swap(left, right);
+        op = flip(op);
+    }
+    if (left->type != ExpressionType::COLUMN || right->type != ExpressionType::LITERAL) {
+        return nullptr;
+    }
+    ValueType column_type = types[left->column_index];
+    const Value& constant = right->value;
+    if ((isNumericType(column_type) && constant.isNumeric()) ||
+        (isStringType(column_type) && constant.isString())) {
+        return std::make_unique<ConstantComparison>(left->column_index, op, constant);
+    }
+    return nullptr;
+}
+
+OperatorPtr BatchAggregateOperator::create(StorageManager* storage_manager, const std::string& data_file,
+                                           const TableInfo* table, const Expression* where,
+                                           const std::vector<const Expression*>& group_by,
+                                           const std::vector<const Expression*>& aggregates, const Schema& schema) {
+    std::vector<ValueType> types;
+    for (const auto& col : table->columns) {
+        types.push_back(Value::typeFromName(col.type));
+    }
+    std::vector<bool> mask(types.size(), false);
+
+    std::unique_ptr<BatchPredicate> predicate;
+    if (where) {
+        predicate = BatchPredicate::compile(where, types);
+        if (!predicate) return nullptr;
+        predicate->collectColumns(mask);
+    }
+
+    std::vector<int> group_columns;
+    for (const Expression* expression : group_by) {
+        if (expression->type != ExpressionType::COLUMN) return nullptr;
+        group_columns.push_back(expression->column_index);
+        mask[expression->column_index] = true;
+    }
+
+    std::vector<std::string> functions;
+    std::vector<int> arguments;
+    for (const Expression* aggregate : aggregates) {
+        int column = -1;
+        if (!aggregate->children.empty()) {
+            if (aggregate->children[0]->type != ExpressionType::COLUMN) return nullptr;
+            column = aggregate->children[0]->column_index;
+            mask[column] = true;
+        }
+        functions.push_back(aggregate->name);
+        arguments.push_back(column);
+    }
+
+    auto* op = new BatchAggregateOperator(storage_manager, data_file, types, mask, std::move(predicate),
+                                          std::move(group_columns), std::move(functions),
+                                          std::move(arguments), schema);
+    op->description = "Vectorized Aggregate on " + table->name + " (";
+    for (size_t i = 0; i < aggregates.size(); i++) {
+        op->description += (i > 0 ? ", " : "") + aggregates[i]->toString();
+    }
+    op->description += ")";
+    if (where) {
+        op->description += " filter (" + where->toString() + ")";
+    }
+    if (!group_by.empty()) {
+        op->description += " group by (";
+        for (size_t i = 0; i < group_by.size(); i++) {
+            op->description += (i > 0 ? ", " : "") + group_by[i]->toString();
+        }
+        op->description += ")";
+    }
+    return OperatorPtr(op);
+}
+
+BatchAggregateOperator::BatchAggregateOperator(StorageManager* storage_manager, const std::string& data_file,
+                                               const std::vector<ValueType>& types, const std::vector<bool>& mask,
+                                               std::unique_ptr<BatchPredicate> predicate, std::vector<int> group_by,
+                                               std::vector<std::string> functions, std::vector<int> arguments,
+                                               Schema schema)
+    : Operator(std::move(schema)), scanner(storage_manager, data_file, types, mask),
+      predicate(std::move(predicate)), group_by(std::move(group_by)), functions(std::move(functions)),
+      arguments(std::move(arguments)) {}
+
+bool BatchAggregateOperator::open() {
+    groups.clear();
+    scanner.reset();
+
+    RowBatch batch;
+    std::vector<uint8_t> mask(BATCH_SIZE);
+    while (scanner.next(batch)) {
+        if (predicate) {
+            predicate->evaluate(batch, mask.data());
+            // Branch-free compaction of the qualifying rows
+            size_t selected = 0;
+            for (size_t i = 0; i < batch.size; i++) {
+                batch.selection[selected] = static_cast<uint32_t>(i);
+                selected += mask[i];
+            }
+            batch.selected = selected;
+        }
+
+        if (group_by.empty()) {
+            std::vector<Accumulator>& accumulators = groups[{}];
+            accumulators.resize(arguments.size());
+            for (size_t a = 0; a < arguments.size(); a++) {
+                accumulateBatch(batch, arguments[a], accumulators[a]);
+            }
+            continue;
+        }
+
+        std::vector<Value> key(group_by.size());
+        for (size_t i = 0; i < batch.selected; i++) {
+            uint32_t row = batch.selection[i];
+            for (size_t k = 0; k < group_by.size(); k++) {
+                key[k] = batch.columns[group_by[k]].get(row);
+            }
+            std::vector<Accumulator>& accumulators = groups[key];
+            accumulators.resize(arguments.size());
+            for (size_t a = 0; a < arguments.size(); a++) {
+                if (arguments[a] < 0) {
+                    accumulators[a].count++;
+                } else {
+                    accumulators[a].add(batch.columns[arguments[a]].get(row));
+                }
+            }
+        }
+    }
+
+    if (group_by.empty() && groups.empty()) {
+        groups[{}].resize(arguments.size());
+    }
+    position = groups.begin();
+    return true;
+}
+
+bool BatchAggregateOperator::next(Record& row) {
+    if (position == groups.end()) {
+        return false;
+    }
+    row.values = position->first;
+    for (size_t i = 0; i < functions.size(); i++) {
+        row.values.push_back(position->second[i].result(functions[i]));
+    }
+    ++position;
+    return true;
+}
+
+void BatchAggregateOperator::close() {
+    groups.clear();
+    position = groups.begin();
+}